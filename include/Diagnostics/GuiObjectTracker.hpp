@@ -0,0 +1,333 @@
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <source_location>
+
+// Kinds of GDI and USER objects created through the library
+enum class GuiObjectType : uint8_t {
+	// GDI
+	Brush,
+	Pen,
+	Font,
+	Bitmap,
+	Region,
+	DeviceContext,
+	// USER
+	Icon,
+	Cursor,
+	Menu,
+	Window,
+	Count,
+};
+
+// The two per-process quotas objects count against (10,000 each by default)
+enum class GuiResourceKind : uint8_t {
+	Gdi,
+	User,
+};
+
+inline GuiResourceKind GetResourceKind(GuiObjectType type) {
+	return type >= GuiObjectType::Icon ? GuiResourceKind::User : GuiResourceKind::Gdi;
+}
+
+// Where an object was created
+struct GuiCallSite {
+	const char* file = "";
+	uint32_t line = 0;
+	const char* function = "";
+};
+
+// A tracked object that is still alive
+struct GuiObjectRecord {
+	uintptr_t handle = 0;
+	GuiObjectType type = GuiObjectType::Brush;
+	uintptr_t owner = 0;
+	GuiCallSite site;
+};
+
+// Objects created at one call site
+struct GuiCallSiteStats {
+	GuiCallSite site;
+	GuiObjectType type = GuiObjectType::Brush;
+	uint64_t created = 0;
+	uint64_t live = 0;
+};
+
+// Process-wide object counts next to the share created through the library
+struct GuiResourceSample {
+	uint32_t processGdi = 0;
+	uint32_t processUser = 0;
+	uint64_t trackedGdi = 0;
+	uint64_t trackedUser = 0;
+};
+
+// A count crossed its budget
+struct GuiBudgetAlert {
+	GuiResourceKind kind = GuiResourceKind::Gdi;
+	uint64_t count = 0;
+	uint64_t budget = 0;
+	// True if `count` is the process-wide count, false if only the tracked objects
+	bool processWide = false;
+};
+
+// Source of the process-wide counts. The Win32 one calls `GetGuiResources`; tests use
+// `FakeGuiResourceBackend`.
+class GuiResourceBackend {
+public:
+	virtual ~GuiResourceBackend() = default;
+	virtual uint32_t GetGdiObjectCount() = 0;
+	virtual uint32_t GetUserObjectCount() = 0;
+};
+
+class FakeGuiResourceBackend : public GuiResourceBackend {
+public:
+	uint32_t gdiObjects = 0;
+	uint32_t userObjects = 0;
+
+	uint32_t GetGdiObjectCount() override {
+		return gdiObjects;
+	}
+
+	uint32_t GetUserObjectCount() override {
+		return userObjects;
+	}
+};
+
+// Book-keeping for GDI and USER objects created through the library, by type, owning
+// window and call site. Handles are plain integers so the tracker is platform
+// independent; creation and deletion are reported by the wrappers. Budgets are checked
+// against the tracked count on every creation and against the process-wide count on
+// every `Sample`; each alert fires once per upward crossing. When a window is destroyed,
+// `OnOwnerDestroyed` reports the objects still attributed to it. Thread-safe; handlers
+// are called without the lock held.
+class GuiObjectTracker {
+public:
+	using BudgetHandler = std::function<void(const GuiBudgetAlert& alert)>;
+	using LeakHandler = std::function<void(uintptr_t owner, const std::vector<GuiObjectRecord>& leaked)>;
+
+	explicit GuiObjectTracker(GuiResourceBackend& backend) : m_Backend(backend) {}
+
+	GuiObjectTracker(const GuiObjectTracker&) = delete;
+	GuiObjectTracker& operator=(const GuiObjectTracker&) = delete;
+
+	void OnCreated(uintptr_t handle, GuiObjectType type, uintptr_t owner = 0, const std::source_location& location = std::source_location::current()) {
+		if (!handle) {
+			return;
+		}
+		GuiBudgetAlert alert;
+		bool raise = false;
+		BudgetHandler handler;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			GuiCallSite site{ location.file_name(), location.line(), location.function_name() };
+			auto existing = m_Objects.find(handle);
+			if (existing != m_Objects.end()) {
+				// The handle value was recycled without us seeing the deletion
+				Forget(existing->second);
+				m_Objects.erase(existing);
+			}
+			m_Objects[handle] = { handle, type, owner, site };
+
+			CallSiteEntry& entry = m_CallSites[CallSiteKey{ site.file, site.line, type }];
+			entry.site = site;
+			++entry.created;
+			++entry.live;
+			++m_Live[static_cast<size_t>(type)];
+
+			GuiResourceKind kind = GetResourceKind(type);
+			Budget& budget = m_Budgets[static_cast<size_t>(kind)];
+			uint64_t tracked = TrackedCount(kind);
+			if (budget.limit && tracked >= budget.limit && !budget.trackedRaised) {
+				budget.trackedRaised = true;
+				alert = { kind, tracked, budget.limit, false };
+				handler = budget.handler;
+				raise = true;
+			}
+		}
+		if (raise && handler) {
+			handler(alert);
+		}
+	}
+
+	void OnDestroyed(uintptr_t handle) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Objects.find(handle);
+		if (it == m_Objects.end()) {
+			return;
+		}
+		GuiResourceKind kind = GetResourceKind(it->second.type);
+		Forget(it->second);
+		m_Objects.erase(it);
+		// Re-arm the tracked alert once the count dropped back under the budget
+		Budget& budget = m_Budgets[static_cast<size_t>(kind)];
+		if (budget.trackedRaised && TrackedCount(kind) < budget.limit) {
+			budget.trackedRaised = false;
+		}
+	}
+
+	// Re-attributes an object, e.g. when ownership passes from a window to its class
+	void SetOwner(uintptr_t handle, uintptr_t owner) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Objects.find(handle);
+		if (it != m_Objects.end()) {
+			it->second.owner = owner;
+		}
+	}
+
+	// Alerts when the GDI or USER count reaches `limit`; 0 removes the budget
+	void SetBudget(GuiResourceKind kind, uint64_t limit, BudgetHandler handler) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Budgets[static_cast<size_t>(kind)] = { limit, std::move(handler), false, false };
+	}
+
+	void SetLeakHandler(LeakHandler handler) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_LeakHandler = std::move(handler);
+	}
+
+	// Reads the process-wide counts and checks them against the budgets
+	GuiResourceSample Sample() {
+		GuiResourceSample sample;
+		sample.processGdi = m_Backend.GetGdiObjectCount();
+		sample.processUser = m_Backend.GetUserObjectCount();
+
+		std::vector<std::pair<BudgetHandler, GuiBudgetAlert>> alerts;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			sample.trackedGdi = TrackedCount(GuiResourceKind::Gdi);
+			sample.trackedUser = TrackedCount(GuiResourceKind::User);
+			const uint64_t counts[2] = { sample.processGdi, sample.processUser };
+			for (size_t kind = 0; kind < 2; ++kind) {
+				Budget& budget = m_Budgets[kind];
+				if (!budget.limit) {
+					continue;
+				}
+				bool over = counts[kind] >= budget.limit;
+				if (over && !budget.processRaised && budget.handler) {
+					alerts.push_back({ budget.handler, { static_cast<GuiResourceKind>(kind), counts[kind], budget.limit, true } });
+				}
+				budget.processRaised = over;
+			}
+		}
+		for (auto& alert : alerts) {
+			alert.first(alert.second);
+		}
+		return sample;
+	}
+
+	// Reports the objects still attributed to `owner` to the leak handler and returns
+	// their number. The objects stay tracked; they are still alive.
+	size_t OnOwnerDestroyed(uintptr_t owner) {
+		std::vector<GuiObjectRecord> leaked = GetLiveObjects(owner);
+		LeakHandler handler;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			handler = m_LeakHandler;
+		}
+		if (!leaked.empty() && handler) {
+			handler(owner, leaked);
+		}
+		return leaked.size();
+	}
+
+	std::vector<GuiObjectRecord> GetLiveObjects(uintptr_t owner) const {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		std::vector<GuiObjectRecord> objects;
+		for (const auto& entry : m_Objects) {
+			if (entry.second.owner == owner) {
+				objects.push_back(entry.second);
+			}
+		}
+		return objects;
+	}
+
+	uint64_t GetLiveCount(GuiObjectType type) const {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Live[static_cast<size_t>(type)];
+	}
+
+	uint64_t GetLiveCount(GuiResourceKind kind) const {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return TrackedCount(kind);
+	}
+
+	// Call sites, those with the most live objects first
+	std::vector<GuiCallSiteStats> GetCallSites() const {
+		std::vector<GuiCallSiteStats> sites;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			sites.reserve(m_CallSites.size());
+			for (const auto& entry : m_CallSites) {
+				sites.push_back({ entry.second.site, entry.first.type, entry.second.created, entry.second.live });
+			}
+		}
+		std::sort(sites.begin(), sites.end(), [](const GuiCallSiteStats& a, const GuiCallSiteStats& b) {
+			return a.live != b.live ? a.live > b.live : a.created > b.created;
+		});
+		return sites;
+	}
+
+private:
+	// File names are compared by content: each translation unit may have its own copy of
+	// the same string
+	struct CallSiteKey {
+		const char* file;
+		uint32_t line;
+		GuiObjectType type;
+
+		bool operator==(const CallSiteKey& other) const {
+			return line == other.line && type == other.type && std::string_view(file) == std::string_view(other.file);
+		}
+	};
+
+	struct CallSiteHash {
+		size_t operator()(const CallSiteKey& key) const {
+			return std::hash<std::string_view>()(key.file) ^ (static_cast<size_t>(key.line) << 8) ^ static_cast<size_t>(key.type);
+		}
+	};
+
+	struct CallSiteEntry {
+		GuiCallSite site;
+		uint64_t created = 0;
+		uint64_t live = 0;
+	};
+
+	struct Budget {
+		uint64_t limit = 0;
+		BudgetHandler handler;
+		bool trackedRaised = false;
+		bool processRaised = false;
+	};
+
+	void Forget(const GuiObjectRecord& record) {
+		auto site = m_CallSites.find(CallSiteKey{ record.site.file, record.site.line, record.type });
+		if (site != m_CallSites.end() && site->second.live) {
+			--site->second.live;
+		}
+		--m_Live[static_cast<size_t>(record.type)];
+	}
+
+	uint64_t TrackedCount(GuiResourceKind kind) const {
+		uint64_t count = 0;
+		for (size_t type = 0; type < static_cast<size_t>(GuiObjectType::Count); ++type) {
+			if (GetResourceKind(static_cast<GuiObjectType>(type)) == kind) {
+				count += m_Live[type];
+			}
+		}
+		return count;
+	}
+
+	GuiResourceBackend& m_Backend;
+	mutable std::mutex m_Mutex;
+	std::unordered_map<uintptr_t, GuiObjectRecord> m_Objects;
+	std::unordered_map<CallSiteKey, CallSiteEntry, CallSiteHash> m_CallSites;
+	uint64_t m_Live[static_cast<size_t>(GuiObjectType::Count)] = {};
+	Budget m_Budgets[2];
+	LeakHandler m_LeakHandler;
+};
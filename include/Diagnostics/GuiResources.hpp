@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <source_location>
+#include <windows.h>
+
+#include "GuiObjectTracker.hpp"
+
+// Process-wide counts through `GetGuiResources`
+class Win32GuiResourceBackend : public GuiResourceBackend {
+public:
+	uint32_t GetGdiObjectCount() override {
+		return GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS);
+	}
+
+	uint32_t GetUserObjectCount() override {
+		return GetGuiResources(GetCurrentProcess(), GR_USEROBJECTS);
+	}
+};
+
+// The tracker every wrapper in the library reports to
+inline GuiObjectTracker& GetGuiObjectTracker() {
+	static Win32GuiResourceBackend backend;
+	static GuiObjectTracker tracker(backend);
+	return tracker;
+}
+
+// Records a freshly created object (null handles are ignored) and returns it, so a
+// creation call can be wrapped in place:
+//
+//	HBRUSH brush = TrackGuiObject(CreateSolidBrush(color), GuiObjectType::Brush, window);
+template <typename Handle>
+inline Handle TrackGuiObject(Handle handle, GuiObjectType type, HWND owner = NULL, const std::source_location& location = std::source_location::current()) {
+	GetGuiObjectTracker().OnCreated(reinterpret_cast<uintptr_t>(handle), type, reinterpret_cast<uintptr_t>(owner), location);
+	return handle;
+}
+
+// Forgets a tracked object; call right before destroying it
+template <typename Handle>
+inline void UntrackGuiObject(Handle handle) {
+	GetGuiObjectTracker().OnDestroyed(reinterpret_cast<uintptr_t>(handle));
+}
+
+// `DeleteObject` for tracked pens, brushes, fonts, bitmaps and regions
+inline BOOL DeleteTrackedObject(HGDIOBJ object) {
+	UntrackGuiObject(object);
+	return DeleteObject(object);
+}
+
+// `DeleteDC` for tracked memory DCs
+inline BOOL DeleteTrackedDC(HDC dc) {
+	UntrackGuiObject(dc);
+	return DeleteDC(dc);
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+// One dispatched message in the recent message trace
+struct DispatchTraceEntry {
+	uint32_t message = 0;
+	uintptr_t window = 0;
+	// How long before the stalled message this one was dispatched
+	std::chrono::steady_clock::duration age = std::chrono::steady_clock::duration::zero();
+	std::chrono::steady_clock::duration duration = std::chrono::steady_clock::duration::zero();
+};
+
+// What the UI thread was doing when it stalled
+struct HangReport {
+	// Dispatch the thread is stuck in; identifies the stall across reports
+	uint64_t dispatch = 0;
+	uint32_t message = 0;
+	uintptr_t window = 0;
+	// Time spent in the handler so far, or in total once `ongoing` is false
+	std::chrono::steady_clock::duration duration = std::chrono::steady_clock::duration::zero();
+	// True while the handler still runs, false for the report sent when it returns
+	bool ongoing = true;
+	// Messages dispatched before the stalled one, oldest first
+	std::vector<DispatchTraceEntry> trace;
+};
+
+// Stall detection between a message loop, which marks the start and end of each
+// dispatch, and a watchdog thread, which polls `Check`. Platform independent so it can
+// be driven with made-up timestamps. The loop side is a handful of relaxed atomic stores
+// per message; all the work happens on the watchdog side.
+//
+// The dispatch counter is odd while a handler runs, so the watchdog can tell a stalled
+// handler from an idle loop without any locking. Every stall is reported twice: once
+// when it passes the threshold and once when the handler finally returns.
+class HangDetector {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr size_t kTraceSize = 32;
+
+	explicit HangDetector(Clock::duration threshold = std::chrono::milliseconds(200)) : m_Threshold(threshold) {}
+
+	HangDetector(const HangDetector&) = delete;
+	HangDetector& operator=(const HangDetector&) = delete;
+
+	void SetThreshold(Clock::duration threshold) {
+		m_Threshold.store(threshold, std::memory_order_relaxed);
+	}
+
+	Clock::duration GetThreshold() const {
+		return m_Threshold.load(std::memory_order_relaxed);
+	}
+
+	// Loop thread: a handler is about to run
+	void BeginDispatch(uint32_t message, uintptr_t window, Clock::time_point now) {
+		if (m_Depth++ != 0) {
+			return;
+		}
+		// Keeps the fields below from becoming visible before the previous dispatch ended
+		std::atomic_thread_fence(std::memory_order_release);
+		m_Message.store(message, std::memory_order_relaxed);
+		m_Window.store(window, std::memory_order_relaxed);
+		m_Start.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+		m_Dispatch.fetch_add(1, std::memory_order_release);
+	}
+
+	// Loop thread: the handler returned
+	void EndDispatch(Clock::time_point now) {
+		if (m_Depth == 0 || --m_Depth != 0) {
+			return;
+		}
+		uint64_t dispatch = m_Dispatch.load(std::memory_order_relaxed);
+		Clock::time_point start(Clock::duration(m_Start.load(std::memory_order_relaxed)));
+		Clock::duration duration = now - start;
+
+		TraceSlot& slot = m_Trace[m_TraceNext++ % kTraceSize];
+		slot.message.store(m_Message.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		slot.window.store(m_Window.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		slot.end.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+		slot.duration.store(duration.count(), std::memory_order_relaxed);
+		m_TraceCount.store(m_TraceNext, std::memory_order_relaxed);
+
+		// Long handlers are rare, so this survives until the watchdog polls again
+		if (duration >= GetThreshold()) {
+			m_LongDuration.store(duration.count(), std::memory_order_relaxed);
+			m_LongDispatch.store(dispatch, std::memory_order_release);
+		}
+		m_Dispatch.store(dispatch + 1, std::memory_order_release);
+	}
+
+	// Watchdog thread: fills `report` and returns true when a handler passed the threshold
+	// or a reported one returned. Returns false otherwise, in particular while idle.
+	bool Check(Clock::time_point now, HangReport& report) {
+		uint64_t reported = m_Reported.load(std::memory_order_relaxed);
+		uint64_t dispatch = m_Dispatch.load(std::memory_order_acquire);
+
+		if (reported != 0 && dispatch != reported) {
+			// The stalled handler returned; its duration was stored before the counter moved,
+			// unless another long handler overwrote it already
+			report = m_LastReport;
+			report.ongoing = false;
+			report.trace.clear();
+			if (m_LongDispatch.load(std::memory_order_acquire) == reported) {
+				report.duration = Clock::duration(m_LongDuration.load(std::memory_order_relaxed));
+			}
+			else {
+				report.duration = now - m_LastStart;
+			}
+			m_Reported.store(0, std::memory_order_relaxed);
+			return true;
+		}
+		if (dispatch % 2 == 0 || dispatch == reported) {
+			return false;
+		}
+
+		uint32_t message = m_Message.load(std::memory_order_relaxed);
+		uintptr_t window = m_Window.load(std::memory_order_relaxed);
+		Clock::time_point start(Clock::duration(m_Start.load(std::memory_order_relaxed)));
+		// A dispatch that started meanwhile may have torn the fields; catch it next time
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_Dispatch.load(std::memory_order_relaxed) != dispatch) {
+			return false;
+		}
+		Clock::duration elapsed = now - start;
+		if (elapsed < GetThreshold()) {
+			return false;
+		}
+
+		report.dispatch = dispatch;
+		report.message = message;
+		report.window = window;
+		report.duration = elapsed;
+		report.ongoing = true;
+		ReadTrace(start, report.trace);
+		m_LastReport = report;
+		m_LastStart = start;
+		m_Reported.store(dispatch, std::memory_order_release);
+		++m_HangCount;
+		return true;
+	}
+
+	// Stalls detected so far; watchdog thread only
+	uint64_t GetHangCount() const {
+		return m_HangCount;
+	}
+
+	// Messages dispatched so far
+	uint64_t GetDispatchCount() const {
+		return m_Dispatch.load(std::memory_order_relaxed) / 2;
+	}
+
+private:
+	struct TraceSlot {
+		std::atomic<uint32_t> message{ 0 };
+		std::atomic<uintptr_t> window{ 0 };
+		std::atomic<Clock::rep> end{ 0 };
+		std::atomic<Clock::rep> duration{ 0 };
+	};
+
+	// The loop thread is stuck in a handler, so the trace holds still while it is read
+	void ReadTrace(Clock::time_point stallStart, std::vector<DispatchTraceEntry>& trace) const {
+		uint64_t count = m_TraceCount.load(std::memory_order_relaxed);
+		uint64_t first = count > kTraceSize ? count - kTraceSize : 0;
+		trace.clear();
+		trace.reserve(static_cast<size_t>(count - first));
+		for (uint64_t i = first; i < count; ++i) {
+			const TraceSlot& slot = m_Trace[i % kTraceSize];
+			DispatchTraceEntry entry;
+			entry.message = slot.message.load(std::memory_order_relaxed);
+			entry.window = slot.window.load(std::memory_order_relaxed);
+			entry.duration = Clock::duration(slot.duration.load(std::memory_order_relaxed));
+			entry.age = stallStart - (Clock::time_point(Clock::duration(slot.end.load(std::memory_order_relaxed))) - entry.duration);
+			trace.push_back(entry);
+		}
+	}
+
+	std::atomic<Clock::duration> m_Threshold;
+
+	// Written by the loop thread
+	std::atomic<uint64_t> m_Dispatch{ 0 };
+	std::atomic<uint32_t> m_Message{ 0 };
+	std::atomic<uintptr_t> m_Window{ 0 };
+	std::atomic<Clock::rep> m_Start{ 0 };
+	std::atomic<uint64_t> m_LongDispatch{ 0 };
+	std::atomic<Clock::rep> m_LongDuration{ 0 };
+	std::atomic<uint64_t> m_TraceCount{ 0 };
+	TraceSlot m_Trace[kTraceSize];
+	uint64_t m_TraceNext = 0;
+	uint32_t m_Depth = 0;
+
+	// Written by the watchdog thread
+	std::atomic<uint64_t> m_Reported{ 0 };
+	HangReport m_LastReport;
+	Clock::time_point m_LastStart;
+	uint64_t m_HangCount = 0;
+};
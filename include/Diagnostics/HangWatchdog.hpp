@@ -0,0 +1,184 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <stdexcept>
+#include <functional>
+#include <windows.h>
+
+#include "HangDetector.hpp"
+#include "../Loop/RunLoop.hpp"
+#include "../System/ApiTable.hpp"
+
+// Evidence collected on the watchdog thread when a stall is detected
+struct HangCapture {
+	static constexpr size_t kMaxFrames = 64;
+
+	// Return addresses of the stalled thread, innermost first
+	uintptr_t stack[kMaxFrames] = {};
+	size_t stackSize = 0;
+	// Minidump written for the stall, empty if none was
+	std::wstring dumpPath;
+};
+
+// Watches a `RunLoop` for handlers that keep the UI thread busy for too long. The loop
+// marks the start and end of every dispatch in a `HangDetector` (a few atomic stores per
+// message); a background thread polls it and, once a handler passes the threshold,
+// reports the message, the time spent so far and the messages dispatched before it. A
+// second report follows when the handler returns.
+//
+// On detection the watchdog can also sample the UI thread's stack and write a minidump.
+// The stack is walked while the thread is suspended, so nothing on that path allocates.
+// Both run on the watchdog thread; the handler is called there too.
+class HangWatchdog : private RunLoop::DispatchObserver {
+public:
+	using Clock = std::chrono::steady_clock;
+	// Called on the watchdog thread. `capture` is null for the report sent when the
+	// stalled handler returns.
+	using HangHandler = std::function<void(const HangReport& report, const HangCapture* capture)>;
+
+	struct Config {
+		std::chrono::milliseconds threshold{ 200 };
+		// How often the watchdog wakes up; also the detection latency
+		std::chrono::milliseconds pollInterval{ 50 };
+		bool sampleStack = true;
+		// Directory for minidumps of stalls; empty disables dumps
+		std::wstring dumpDirectory;
+		// Most dumps written over the lifetime of the watchdog
+		uint32_t maxDumps = 1;
+	};
+
+	HangWatchdog(RunLoop& loop, HangHandler handler) : HangWatchdog(loop, std::move(handler), Config()) {}
+
+	HangWatchdog(RunLoop& loop, HangHandler handler, const Config& config)
+		: m_Loop(loop), m_Handler(std::move(handler)), m_Config(config), m_Detector(config.threshold) {
+		m_Thread = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, loop.GetThreadId());
+		m_Stop = CreateEventW(NULL, TRUE, FALSE, NULL);
+		if (!m_Thread || !m_Stop) {
+			DWORD error = GetLastError();
+			if (m_Thread) {
+				CloseHandle(m_Thread);
+			}
+			throw std::runtime_error("Failed to start hang watchdog. Error code: " + std::to_string(error));
+		}
+		m_Loop.AddDispatchObserver(this);
+		m_Watcher = std::thread([this] { Watch(); });
+	}
+
+	~HangWatchdog() {
+		m_Loop.RemoveDispatchObserver(this);
+		SetEvent(m_Stop);
+		m_Watcher.join();
+		CloseHandle(m_Stop);
+		CloseHandle(m_Thread);
+	}
+
+	HangWatchdog(const HangWatchdog&) = delete;
+	HangWatchdog& operator=(const HangWatchdog&) = delete;
+
+	void SetThreshold(std::chrono::milliseconds threshold) {
+		m_Detector.SetThreshold(threshold);
+	}
+
+	uint64_t GetHangCount() const {
+		return m_HangCount.load(std::memory_order_relaxed);
+	}
+
+private:
+	void OnDispatchBegin(const MSG& msg) override {
+		m_Detector.BeginDispatch(msg.message, reinterpret_cast<uintptr_t>(msg.hwnd), Clock::now());
+	}
+
+	void OnDispatchEnd(const MSG&) override {
+		m_Detector.EndDispatch(Clock::now());
+	}
+
+	void Watch() {
+		HangReport report;
+		HangCapture capture;
+		while (WaitForSingleObject(m_Stop, static_cast<DWORD>(m_Config.pollInterval.count())) == WAIT_TIMEOUT) {
+			if (!m_Detector.Check(Clock::now(), report)) {
+				continue;
+			}
+			if (!report.ongoing) {
+				m_Handler(report, nullptr);
+				continue;
+			}
+			m_HangCount.fetch_add(1, std::memory_order_relaxed);
+			capture.stackSize = m_Config.sampleStack ? SampleStack(capture.stack, HangCapture::kMaxFrames) : 0;
+			capture.dumpPath.clear();
+			if (!m_Config.dumpDirectory.empty() && m_DumpsWritten < m_Config.maxDumps) {
+				WriteDump(report, capture.dumpPath);
+			}
+			m_Handler(report, &capture);
+		}
+	}
+
+	// Walks the loop thread's stack while it is suspended. Must not allocate: the thread
+	// may be holding the heap lock.
+	size_t SampleStack(uintptr_t* frames, size_t maxFrames) {
+		if (SuspendThread(m_Thread) == static_cast<DWORD>(-1)) {
+			return 0;
+		}
+		size_t count = 0;
+		CONTEXT context = {};
+		context.ContextFlags = CONTEXT_FULL;
+		if (GetThreadContext(m_Thread, &context)) {
+#if defined(_M_X64)
+			while (count < maxFrames && context.Rip) {
+				frames[count++] = static_cast<uintptr_t>(context.Rip);
+				DWORD64 imageBase = 0;
+				PRUNTIME_FUNCTION function = RtlLookupFunctionEntry(context.Rip, &imageBase, NULL);
+				if (function) {
+					PVOID handlerData = NULL;
+					DWORD64 establisherFrame = 0;
+					RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, context.Rip, function, &context, &handlerData, &establisherFrame, NULL);
+				}
+				else {
+					// Leaf function: the return address is on top of the stack
+					context.Rip = *reinterpret_cast<const DWORD64*>(context.Rsp);
+					context.Rsp += sizeof(DWORD64);
+				}
+			}
+#elif defined(_M_IX86)
+			frames[count++] = static_cast<uintptr_t>(context.Eip);
+#elif defined(_M_ARM64)
+			frames[count++] = static_cast<uintptr_t>(context.Pc);
+#endif
+		}
+		ResumeThread(m_Thread);
+		return count;
+	}
+
+	void WriteDump(const HangReport& report, std::wstring& path) {
+		// MiniDumpWithThreadInfo | MiniDumpWithIndirectlyReferencedMemory
+		constexpr DWORD kDumpType = 0x1000 | 0x40;
+		path = m_Config.dumpDirectory + L"\\hang-" + std::to_wstring(GetCurrentProcessId()) + L"-" + std::to_wstring(report.dispatch / 2) + L".dmp";
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			path.clear();
+			return;
+		}
+		BOOL written = GetDbgHelpApi().MiniDumpWriteDump(GetCurrentProcess(), GetCurrentProcessId(), file, kDumpType, NULL, NULL, NULL);
+		CloseHandle(file);
+		if (!written) {
+			DeleteFileW(path.c_str());
+			path.clear();
+			return;
+		}
+		++m_DumpsWritten;
+	}
+
+	RunLoop& m_Loop;
+	HangHandler m_Handler;
+	Config m_Config;
+	HangDetector m_Detector;
+	HANDLE m_Thread = NULL;
+	HANDLE m_Stop = NULL;
+	std::thread m_Watcher;
+	std::atomic<uint64_t> m_HangCount{ 0 };
+	uint32_t m_DumpsWritten = 0;
+};
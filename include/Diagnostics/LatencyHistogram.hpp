@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stdint.h>
+#include <bit>
+#include <chrono>
+
+// Percentiles of a recorded distribution
+struct LatencySummary {
+	uint64_t count = 0;
+	std::chrono::microseconds p50{ 0 };
+	std::chrono::microseconds p90{ 0 };
+	std::chrono::microseconds p99{ 0 };
+	std::chrono::microseconds max{ 0 };
+};
+
+// Fixed-size histogram of non-negative values with log-linear buckets: every power of
+// two is split into 8 buckets, so a percentile is off by at most 12.5% while recording
+// stays a couple of instructions and the whole histogram is 2.5 KB. Values above 2^40
+// land in the last bucket. Units are up to the caller; the `Duration` overloads record
+// microseconds.
+class LatencyHistogram {
+public:
+	static constexpr uint32_t kSubBucketBits = 3;
+	static constexpr uint32_t kSubBuckets = 1u << kSubBucketBits;
+	static constexpr uint32_t kMaxBits = 40;
+	static constexpr size_t kBucketCount = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+	void Record(uint64_t value) {
+		++m_Counts[BucketOf(value)];
+		++m_Count;
+		if (value > m_Max) {
+			m_Max = value;
+		}
+	}
+
+	template <typename Rep, typename Period>
+	void Record(std::chrono::duration<Rep, Period> duration) {
+		auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+		Record(static_cast<uint64_t>(micros > 0 ? micros : 0));
+	}
+
+	// Smallest recorded bucket bound below which `fraction` (0..1) of the values fall
+	uint64_t Percentile(double fraction) const {
+		if (m_Count == 0) {
+			return 0;
+		}
+		uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(m_Count) + 0.5);
+		if (target == 0) {
+			target = 1;
+		}
+		uint64_t seen = 0;
+		for (size_t i = 0; i < kBucketCount; ++i) {
+			seen += m_Counts[i];
+			if (seen >= target) {
+				if (i == kBucketCount - 1) {
+					return m_Max;
+				}
+				uint64_t upper = BucketUpper(i);
+				return upper < m_Max ? upper : m_Max;
+			}
+		}
+		return m_Max;
+	}
+
+	uint64_t GetCount() const {
+		return m_Count;
+	}
+
+	uint64_t GetMax() const {
+		return m_Max;
+	}
+
+	// Percentiles, reading the recorded values as microseconds
+	LatencySummary Summarize() const {
+		LatencySummary summary;
+		summary.count = m_Count;
+		summary.p50 = std::chrono::microseconds(Percentile(0.50));
+		summary.p90 = std::chrono::microseconds(Percentile(0.90));
+		summary.p99 = std::chrono::microseconds(Percentile(0.99));
+		summary.max = std::chrono::microseconds(m_Max);
+		return summary;
+	}
+
+	void Merge(const LatencyHistogram& other) {
+		for (size_t i = 0; i < kBucketCount; ++i) {
+			m_Counts[i] += other.m_Counts[i];
+		}
+		m_Count += other.m_Count;
+		if (other.m_Max > m_Max) {
+			m_Max = other.m_Max;
+		}
+	}
+
+	void Reset() {
+		*this = LatencyHistogram();
+	}
+
+private:
+	static size_t BucketOf(uint64_t value) {
+		if (value < kSubBuckets) {
+			return static_cast<size_t>(value);
+		}
+		uint32_t bits = static_cast<uint32_t>(std::bit_width(value));
+		if (bits > kMaxBits) {
+			return kBucketCount - 1;
+		}
+		uint32_t shift = bits - 1 - kSubBucketBits;
+		return (shift + 1) * kSubBuckets + static_cast<size_t>((value >> shift) & (kSubBuckets - 1));
+	}
+
+	// Largest value that falls into bucket `index`
+	static uint64_t BucketUpper(size_t index) {
+		if (index < kSubBuckets) {
+			return index;
+		}
+		uint32_t shift = static_cast<uint32_t>(index / kSubBuckets) - 1;
+		uint64_t lower = static_cast<uint64_t>(kSubBuckets + index % kSubBuckets) << shift;
+		return lower + (uint64_t(1) << shift) - 1;
+	}
+
+	uint64_t m_Counts[kBucketCount] = {};
+	uint64_t m_Count = 0;
+	uint64_t m_Max = 0;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <windows.h>
+
+#include "RingLogger.hpp"
+
+// Process-wide logger used by the library. Lines go to the debugger through
+// `OutputDebugStringA`; `SetSink` on the logger redirects them.
+//
+// Deliberately leaked: destroying it joins its thread, which would deadlock under the
+// loader lock during static destruction. Call `GetLogger().Stop()` before exiting to
+// drain what is still pending.
+inline RingLogger& GetLogger() {
+	static RingLogger* logger = new RingLogger([](LogLevel, const char* line, size_t) {
+		OutputDebugStringA(line);
+		OutputDebugStringA("\n");
+	});
+	return *logger;
+}
+
+template <typename... Args>
+void LogTrace(const LogFormat& format, const Args&... args) {
+	GetLogger().Log<LogLevel::Trace>(format, args...);
+}
+
+template <typename... Args>
+void LogDebug(const LogFormat& format, const Args&... args) {
+	GetLogger().Log<LogLevel::Debug>(format, args...);
+}
+
+template <typename... Args>
+void LogInfo(const LogFormat& format, const Args&... args) {
+	GetLogger().Log<LogLevel::Info>(format, args...);
+}
+
+template <typename... Args>
+void LogWarning(const LogFormat& format, const Args&... args) {
+	GetLogger().Log<LogLevel::Warning>(format, args...);
+}
+
+template <typename... Args>
+void LogError(const LogFormat& format, const Args&... args) {
+	GetLogger().Log<LogLevel::Error>(format, args...);
+}
+
+template <typename... Args>
+void LogFatal(const LogFormat& format, const Args&... args) {
+	GetLogger().Log<LogLevel::Fatal>(format, args...);
+}
+
+// Writes the logger's history and pending records to a file when the process crashes
+// with an unhandled exception, then chains to the previously installed filter. The file
+// is only created on a crash; nothing on that path allocates.
+class LogCrashDump {
+public:
+	static void Install(const wchar_t* path) {
+		State& state = GetState();
+		lstrcpynW(state.path, path, MAX_PATH);
+		if (!state.installed) {
+			state.installed = true;
+			state.previous = SetUnhandledExceptionFilter(&LogCrashDump::Filter);
+		}
+	}
+
+	// Writes the dump now, e.g. from a custom crash handler
+	static bool Write(const wchar_t* path) {
+		HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		GetLogger().Dump([](void* context, const char* data, size_t size) {
+			DWORD written = 0;
+			WriteFile(static_cast<HANDLE>(context), data, static_cast<DWORD>(size), &written, NULL);
+		}, file);
+		FlushFileBuffers(file);
+		CloseHandle(file);
+		return true;
+	}
+
+private:
+	struct State {
+		wchar_t path[MAX_PATH] = {};
+		LPTOP_LEVEL_EXCEPTION_FILTER previous = NULL;
+		bool installed = false;
+	};
+
+	static State& GetState() {
+		static State state;
+		return state;
+	}
+
+	static LONG WINAPI Filter(EXCEPTION_POINTERS* exception) {
+		State& state = GetState();
+		Write(state.path);
+		return state.previous ? state.previous(exception) : EXCEPTION_CONTINUE_SEARCH;
+	}
+};
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+
+// What a block of accounted memory is used for
+enum class MemoryCategory : uint8_t {
+	BackBuffer,
+	Surface,
+	Cache,
+	Arena,
+	HandlerState,
+	Strings,
+	Other,
+	Count,
+};
+
+inline const char* GetCategoryName(MemoryCategory category) {
+	static const char* const names[] = { "back buffers", "surfaces", "caches", "arenas", "handler state", "strings", "other" };
+	size_t index = static_cast<size_t>(category);
+	return index < static_cast<size_t>(MemoryCategory::Count) ? names[index] : "unknown";
+}
+
+// Current and peak bytes of one node of the report
+struct MemoryUsage {
+	uint64_t current = 0;
+	uint64_t peak = 0;
+};
+
+// Memory of one owner (usually a window), in total and by category
+struct MemoryOwnerReport {
+	uintptr_t owner = 0;
+	std::string name;
+	MemoryUsage total;
+	MemoryUsage categories[static_cast<size_t>(MemoryCategory::Count)];
+};
+
+// Process > owner > category snapshot of the accounted memory
+struct MemoryReport {
+	MemoryUsage total;
+	MemoryUsage categories[static_cast<size_t>(MemoryCategory::Count)];
+	// Largest current usage first
+	std::vector<MemoryOwnerReport> owners;
+
+	// Multi-line text, one line per owner and per non-empty category
+	std::string Format() const {
+		std::string text = "memory " + FormatUsage(total) + "\n";
+		for (const MemoryOwnerReport& owner : owners) {
+			text += "  " + (owner.name.empty() ? FormatOwner(owner.owner) : owner.name) + " " + FormatUsage(owner.total) + "\n";
+			for (size_t i = 0; i < static_cast<size_t>(MemoryCategory::Count); ++i) {
+				if (owner.categories[i].peak) {
+					text += std::string("    ") + GetCategoryName(static_cast<MemoryCategory>(i)) + " " + FormatUsage(owner.categories[i]) + "\n";
+				}
+			}
+		}
+		return text;
+	}
+
+	static std::string FormatBytes(uint64_t bytes) {
+		static const char* const units[] = { "B", "KB", "MB", "GB" };
+		double value = static_cast<double>(bytes);
+		size_t unit = 0;
+		while (value >= 1024.0 && unit < 3) {
+			value /= 1024.0;
+			++unit;
+		}
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), unit ? "%.1f %s" : "%.0f %s", value, units[unit]);
+		return buffer;
+	}
+
+private:
+	static std::string FormatUsage(const MemoryUsage& usage) {
+		return FormatBytes(usage.current) + " (peak " + FormatBytes(usage.peak) + ")";
+	}
+
+	static std::string FormatOwner(uintptr_t owner) {
+		if (!owner) {
+			return "unattributed";
+		}
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(owner));
+		return buffer;
+	}
+};
+
+// Accounting of memory held by windows and library subsystems, by owner and category.
+// Subsystems charge what they allocate through a `MemoryCharge` and the ledger keeps
+// current and peak bytes for every (owner, category) pair, every owner and the process.
+// Only memory that is charged shows up: this is book-keeping, not a heap hook. Owners are
+// opaque integers, in practice the `HWND` of the window the memory serves, 0 for memory
+// no window owns. Thread-safe.
+class MemoryLedger {
+public:
+	void Charge(uintptr_t owner, MemoryCategory category, uint64_t bytes) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		size_t index = static_cast<size_t>(category);
+		Owner& entry = m_Owners[owner];
+		Grow(entry.categories[index], bytes);
+		Grow(entry.total, bytes);
+		Grow(m_Categories[index], bytes);
+		Grow(m_Total, bytes);
+	}
+
+	void Release(uintptr_t owner, MemoryCategory category, uint64_t bytes) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		size_t index = static_cast<size_t>(category);
+		auto it = m_Owners.find(owner);
+		if (it == m_Owners.end()) {
+			return;
+		}
+		Shrink(it->second.categories[index], bytes);
+		Shrink(it->second.total, bytes);
+		Shrink(m_Categories[index], bytes);
+		Shrink(m_Total, bytes);
+	}
+
+	// Names an owner in reports, e.g. after the window title
+	void SetOwnerName(uintptr_t owner, std::string name) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Owners[owner].name = std::move(name);
+	}
+
+	// Drops an owner whose memory was all released, e.g. once its window is destroyed.
+	// Returns the bytes it still held; those stay in the report.
+	uint64_t RemoveOwner(uintptr_t owner) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Owners.find(owner);
+		if (it == m_Owners.end()) {
+			return 0;
+		}
+		uint64_t remaining = it->second.total.current;
+		if (!remaining) {
+			m_Owners.erase(it);
+		}
+		return remaining;
+	}
+
+	MemoryOwnerReport GetOwnerReport(uintptr_t owner) const {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Owners.find(owner);
+		if (it == m_Owners.end()) {
+			MemoryOwnerReport empty;
+			empty.owner = owner;
+			return empty;
+		}
+		return MakeOwnerReport(it->first, it->second);
+	}
+
+	MemoryReport GetReport() const {
+		MemoryReport report;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			report.total = m_Total;
+			std::copy(std::begin(m_Categories), std::end(m_Categories), std::begin(report.categories));
+			report.owners.reserve(m_Owners.size());
+			for (const auto& entry : m_Owners) {
+				report.owners.push_back(MakeOwnerReport(entry.first, entry.second));
+			}
+		}
+		std::sort(report.owners.begin(), report.owners.end(), [](const MemoryOwnerReport& a, const MemoryOwnerReport& b) {
+			return a.total.current > b.total.current;
+		});
+		return report;
+	}
+
+	// Restarts peak tracking from the current values
+	void ResetPeaks() {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto reset = [](MemoryUsage& usage) { usage.peak = usage.current; };
+		reset(m_Total);
+		for (MemoryUsage& usage : m_Categories) {
+			reset(usage);
+		}
+		for (auto& entry : m_Owners) {
+			reset(entry.second.total);
+			for (MemoryUsage& usage : entry.second.categories) {
+				reset(usage);
+			}
+		}
+	}
+
+private:
+	struct Owner {
+		std::string name;
+		MemoryUsage total;
+		MemoryUsage categories[static_cast<size_t>(MemoryCategory::Count)];
+	};
+
+	static void Grow(MemoryUsage& usage, uint64_t bytes) {
+		usage.current += bytes;
+		if (usage.current > usage.peak) {
+			usage.peak = usage.current;
+		}
+	}
+
+	static void Shrink(MemoryUsage& usage, uint64_t bytes) {
+		usage.current = usage.current > bytes ? usage.current - bytes : 0;
+	}
+
+	static MemoryOwnerReport MakeOwnerReport(uintptr_t owner, const Owner& entry) {
+		MemoryOwnerReport report;
+		report.owner = owner;
+		report.name = entry.name;
+		report.total = entry.total;
+		std::copy(std::begin(entry.categories), std::end(entry.categories), std::begin(report.categories));
+		return report;
+	}
+
+	mutable std::mutex m_Mutex;
+	std::unordered_map<uintptr_t, Owner> m_Owners;
+	MemoryUsage m_Categories[static_cast<size_t>(MemoryCategory::Count)];
+	MemoryUsage m_Total;
+};
+
+// The ledger the library charges to. Never destroyed, so charges held by other statics
+// can still be released during static destruction.
+inline MemoryLedger& GetMemoryLedger() {
+	static MemoryLedger* ledger = new MemoryLedger();
+	return *ledger;
+}
+
+// Charge held for as long as the memory is: released on destruction, adjusted with
+// `Resize`. Move-only, so it can live next to the allocation it accounts for.
+class MemoryCharge {
+public:
+	MemoryCharge() = default;
+
+	MemoryCharge(uintptr_t owner, MemoryCategory category, uint64_t bytes) : m_Owner(owner), m_Category(category), m_Bytes(bytes) {
+		if (m_Bytes) {
+			GetMemoryLedger().Charge(m_Owner, m_Category, m_Bytes);
+		}
+	}
+
+	MemoryCharge(MemoryCharge&& other) noexcept
+		: m_Owner(other.m_Owner), m_Category(other.m_Category), m_Bytes(std::exchange(other.m_Bytes, 0)) {}
+
+	MemoryCharge& operator=(MemoryCharge&& other) noexcept {
+		if (this != &other) {
+			Reset();
+			m_Owner = other.m_Owner;
+			m_Category = other.m_Category;
+			m_Bytes = std::exchange(other.m_Bytes, 0);
+		}
+		return *this;
+	}
+
+	MemoryCharge(const MemoryCharge&) = delete;
+	MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+	~MemoryCharge() {
+		Reset();
+	}
+
+	void Resize(uint64_t bytes) {
+		if (bytes > m_Bytes) {
+			GetMemoryLedger().Charge(m_Owner, m_Category, bytes - m_Bytes);
+		}
+		else if (bytes < m_Bytes) {
+			GetMemoryLedger().Release(m_Owner, m_Category, m_Bytes - bytes);
+		}
+		m_Bytes = bytes;
+	}
+
+	// Moves the charge to another owner, e.g. once the window it serves is known
+	void SetOwner(uintptr_t owner) {
+		if (owner == m_Owner) {
+			return;
+		}
+		if (m_Bytes) {
+			GetMemoryLedger().Release(m_Owner, m_Category, m_Bytes);
+			GetMemoryLedger().Charge(owner, m_Category, m_Bytes);
+		}
+		m_Owner = owner;
+	}
+
+	uintptr_t GetOwner() const {
+		return m_Owner;
+	}
+
+	void Reset() {
+		if (m_Bytes) {
+			GetMemoryLedger().Release(m_Owner, m_Category, m_Bytes);
+			m_Bytes = 0;
+		}
+	}
+
+	uint64_t GetBytes() const {
+		return m_Bytes;
+	}
+
+private:
+	uintptr_t m_Owner = 0;
+	MemoryCategory m_Category = MemoryCategory::Other;
+	uint64_t m_Bytes = 0;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <windows.h>
+
+#include "MemoryLedger.hpp"
+
+// Draws `report` as white text on a black panel in the top-left corner of `area`, for
+// debug builds to call at the end of `WM_PAINT`. The panel is sized to the text.
+inline void DrawMemoryOverlay(HDC dc, const RECT& area, const MemoryReport& report) {
+	std::string text = report.Format();
+	// The report is ASCII, widening it byte by byte is enough
+	std::wstring wide(text.begin(), text.end());
+
+	RECT bounds = area;
+	DrawTextW(dc, wide.c_str(), static_cast<int>(wide.size()), &bounds, DT_LEFT | DT_TOP | DT_NOPREFIX | DT_CALCRECT);
+	RECT panel = { bounds.left, bounds.top, bounds.right + 8, bounds.bottom + 8 };
+	FillRect(dc, &panel, static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH)));
+
+	int previousMode = SetBkMode(dc, TRANSPARENT);
+	COLORREF previousColor = SetTextColor(dc, RGB(255, 255, 255));
+	RECT textRect = { bounds.left + 4, bounds.top + 4, bounds.right + 4, bounds.bottom + 4 };
+	DrawTextW(dc, wide.c_str(), static_cast<int>(wide.size()), &textRect, DT_LEFT | DT_TOP | DT_NOPREFIX | DT_NOCLIP);
+	SetTextColor(dc, previousColor);
+	SetBkMode(dc, previousMode);
+}
+
+// Same, with a fresh report of the library's ledger
+inline void DrawMemoryOverlay(HDC dc, const RECT& area) {
+	DrawMemoryOverlay(dc, area, GetMemoryLedger().GetReport());
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <unordered_map>
+#include <windows.h>
+
+#include "LatencyHistogram.hpp"
+#include "../Loop/RunLoop.hpp"
+
+// Separates time spent waiting in the message queue from time spent in handlers. For
+// every message a `RunLoop` dispatches, the delay since it was queued (`MSG::time`, the
+// `GetMessageTime` value) is recorded; for input it is also recorded per window, and the
+// window's oldest input not yet on screen is remembered until `OnPresent` is called for
+// that window, which records input-to-present latency. Queue depth is sampled as the
+// number of messages dispatched back to back before the queue ran dry.
+//
+// Message timestamps come from `GetTickCount`, so queueing delays are only accurate to
+// the system timer resolution (typically 10 to 16 ms). Loop thread only.
+class QueueLatencyMonitor : private RunLoop::DispatchObserver {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit QueueLatencyMonitor(RunLoop& loop) : m_Loop(loop) {
+		m_Loop.AddDispatchObserver(this);
+	}
+
+	~QueueLatencyMonitor() {
+		m_Loop.RemoveDispatchObserver(this);
+	}
+
+	QueueLatencyMonitor(const QueueLatencyMonitor&) = delete;
+	QueueLatencyMonitor& operator=(const QueueLatencyMonitor&) = delete;
+
+	// Call once a frame of `window` reached the screen (after `Present` or `EndPaint`)
+	void OnPresent(HWND window) {
+		auto it = m_Windows.find(window);
+		if (it == m_Windows.end() || !it->second.inputPending) {
+			return;
+		}
+		it->second.inputToPresent.Record(Clock::now() - it->second.oldestInput);
+		it->second.inputPending = false;
+	}
+
+	// Time between posting and dispatch, all messages
+	LatencySummary GetQueueDelay() const {
+		return m_QueueDelay.Summarize();
+	}
+
+	// Input-to-dispatch latency of one window, or of all windows for NULL
+	LatencySummary GetInputToDispatch(HWND window = NULL) const {
+		return Collect(window, &WindowLatency::inputToDispatch).Summarize();
+	}
+
+	// Input-to-present latency of one window, or of all windows for NULL
+	LatencySummary GetInputToPresent(HWND window = NULL) const {
+		return Collect(window, &WindowLatency::inputToPresent).Summarize();
+	}
+
+	// Messages dispatched per drained queue, as plain counts
+	const LatencyHistogram& GetQueueDepth() const {
+		return m_QueueDepth;
+	}
+
+	// Fraction of dispatches that started with input already waiting behind them
+	double GetInputBacklogFraction() const {
+		return m_Dispatches ? static_cast<double>(m_InputBacklog) / m_Dispatches : 0.0;
+	}
+
+	// Drops the statistics of a window, e.g. once it is destroyed
+	void RemoveWindow(HWND window) {
+		m_Windows.erase(window);
+	}
+
+	void Reset() {
+		m_QueueDelay.Reset();
+		m_QueueDepth.Reset();
+		m_Windows.clear();
+		m_Dispatches = 0;
+		m_InputBacklog = 0;
+		m_Burst = 0;
+	}
+
+private:
+	struct WindowLatency {
+		LatencyHistogram inputToDispatch;
+		LatencyHistogram inputToPresent;
+		Clock::time_point oldestInput;
+		bool inputPending = false;
+	};
+
+	static bool IsInput(UINT message) {
+		return (message >= WM_KEYFIRST && message <= WM_KEYLAST) || (message >= WM_MOUSEFIRST && message <= WM_MOUSELAST) ||
+			(message >= WM_POINTERUPDATE && message <= WM_POINTERUP) || message == WM_INPUT;
+	}
+
+	void OnDispatchBegin(const MSG& msg) override {
+		++m_Dispatches;
+		++m_Burst;
+		if (HIWORD(GetQueueStatus(QS_INPUT)) != 0) {
+			++m_InputBacklog;
+		}
+		if (msg.time == 0) {
+			return;
+		}
+		// Unsigned arithmetic handles the tick count wrapping every 49.7 days
+		std::chrono::milliseconds delay(static_cast<DWORD>(GetTickCount() - msg.time));
+		if (delay > std::chrono::hours(1)) {
+			// Not a real timestamp
+			return;
+		}
+		m_QueueDelay.Record(delay);
+
+		if (IsInput(msg.message) && msg.hwnd) {
+			WindowLatency& window = m_Windows[msg.hwnd];
+			window.inputToDispatch.Record(delay);
+			if (!window.inputPending) {
+				window.oldestInput = Clock::now() - delay;
+				window.inputPending = true;
+			}
+		}
+	}
+
+	void OnDispatchEnd(const MSG&) override {
+		// Types currently in the queue are in the high word; none left ends the burst
+		if (HIWORD(GetQueueStatus(QS_ALLINPUT)) == 0) {
+			m_QueueDepth.Record(m_Burst);
+			m_Burst = 0;
+		}
+	}
+
+	LatencyHistogram Collect(HWND window, LatencyHistogram WindowLatency::*member) const {
+		LatencyHistogram histogram;
+		for (const auto& entry : m_Windows) {
+			if (!window || entry.first == window) {
+				histogram.Merge(entry.second.*member);
+			}
+		}
+		return histogram;
+	}
+
+	RunLoop& m_Loop;
+	LatencyHistogram m_QueueDelay;
+	LatencyHistogram m_QueueDepth;
+	std::unordered_map<HWND, WindowLatency> m_Windows;
+	uint64_t m_Dispatches = 0;
+	uint64_t m_InputBacklog = 0;
+	uint64_t m_Burst = 0;
+};
@@ -0,0 +1,779 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <source_location>
+#include <condition_variable>
+
+#include "MemoryLedger.hpp"
+
+// Records below this level are compiled out: 0 trace, 1 debug, 2 info, 3 warning,
+// 4 error, 5 fatal
+#ifndef WINCPP_LOG_MIN_LEVEL
+#define WINCPP_LOG_MIN_LEVEL 1
+#endif
+
+enum class LogLevel : uint8_t {
+	Trace,
+	Debug,
+	Info,
+	Warning,
+	Error,
+	Fatal,
+};
+
+constexpr LogLevel kMinLogLevel = static_cast<LogLevel>(WINCPP_LOG_MIN_LEVEL);
+
+// Format string of a record and where it was logged from. Converts implicitly from a
+// string literal, capturing the caller's location. The text must outlive the logger,
+// which string literals do: it is stored by pointer and formatted later.
+struct LogFormat {
+	LogFormat(const char* text, const std::source_location& location = std::source_location::current()) : text(text), location(location) {}
+
+	const char* text;
+	std::source_location location;
+};
+
+// Structured, binary logger for the library internals. Every thread writes records into
+// its own lock-free single-producer ring: a fixed header (level, time, format string and
+// location by pointer) followed by the raw argument values. A background thread drains
+// the rings, formats records (`{}` placeholders, in order) and hands the lines to the
+// sink, so the logging thread never formats, allocates or blocks. A full ring drops
+// records and counts them. Rings are charged to the memory ledger as arenas.
+//
+// Levels are checked at compile time against `WINCPP_LOG_MIN_LEVEL` and at runtime
+// against `SetLevel`. `Dump` writes the recent history and everything not yet drained
+// without allocating, for use from a crash handler.
+class RingLogger {
+public:
+	// Receives each formatted, null-terminated line (without a newline)
+	using Sink = std::function<void(LogLevel level, const char* line, size_t length)>;
+	// Output of `Dump`; must be usable in a crashing process
+	using DumpWriter = void (*)(void* context, const char* data, size_t size);
+
+	static constexpr size_t kDefaultRingSize = 64 * 1024;
+	static constexpr size_t kMaxLineLength = 1024;
+
+	explicit RingLogger(Sink sink, size_t ringSize = kDefaultRingSize, std::chrono::milliseconds drainInterval = std::chrono::milliseconds(10))
+		: m_Sink(std::move(sink)), m_RingSize(RoundUpToPowerOfTwo(ringSize)), m_DrainInterval(drainInterval), m_Start(std::chrono::steady_clock::now()), m_Id(NextLoggerId()) {
+		m_Thread = std::thread([this]() {
+			Consume();
+		});
+	}
+
+	~RingLogger() {
+		Stop();
+	}
+
+	RingLogger(const RingLogger&) = delete;
+	RingLogger& operator=(const RingLogger&) = delete;
+
+	void SetLevel(LogLevel level) {
+		m_Level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+	}
+
+	LogLevel GetLevel() const {
+		return static_cast<LogLevel>(m_Level.load(std::memory_order_relaxed));
+	}
+
+	template <LogLevel Level>
+	bool IsEnabled() const {
+		if constexpr (Level < kMinLogLevel) {
+			return false;
+		}
+		else {
+			return Level >= GetLevel();
+		}
+	}
+
+	template <LogLevel Level, typename... Args>
+	void Log(const LogFormat& format, const Args&... args) {
+		if constexpr (Level >= kMinLogLevel) {
+			if (Level >= GetLevel()) {
+				Write(Level, format, args...);
+				if constexpr (Level == LogLevel::Fatal) {
+					// The process may not live until the next drain
+					Flush();
+				}
+			}
+		}
+	}
+
+	void SetSink(Sink sink) {
+		std::lock_guard<std::mutex> lock(m_ConsumerMutex);
+		m_Sink = std::move(sink);
+	}
+
+	// Formats and emits everything logged so far on the calling thread
+	void Flush() {
+		std::lock_guard<std::mutex> lock(m_ConsumerMutex);
+		DrainAll();
+	}
+
+	// Drains the rings and stops the background thread; later records are dropped
+	void Stop() {
+		{
+			std::lock_guard<std::mutex> lock(m_WakeMutex);
+			if (m_Stopping.load(std::memory_order_relaxed)) {
+				return;
+			}
+			m_Stopping.store(true, std::memory_order_release);
+		}
+		m_Wake.notify_one();
+		if (m_Thread.joinable()) {
+			m_Thread.join();
+		}
+	}
+
+	// Records dropped because a ring was full
+	uint64_t GetDroppedCount() const {
+		return m_Dropped.load(std::memory_order_relaxed);
+	}
+
+	// Writes the last formatted lines and every record not formatted yet. Allocation-free
+	// and lock-free, so it can run in a crash handler. History lines being written
+	// concurrently may come out garbled; pending records drained or overwritten while
+	// the dump reads them are skipped.
+	void Dump(DumpWriter write, void* context) const {
+		// Keeps retired rings alive until the walk below is done
+		m_Dumping.fetch_add(1, std::memory_order_seq_cst);
+		static const char kHistory[] = "--- recent log ---\n";
+		static const char kPending[] = "--- pending log ---\n";
+		write(context, kHistory, sizeof(kHistory) - 1);
+		size_t position = m_HistoryPosition.load(std::memory_order_acquire);
+		if (m_HistoryWrapped.load(std::memory_order_acquire)) {
+			// Skip the line the oldest part of the history starts in the middle of
+			const char* start = m_History + position;
+			const char* end = m_History + kHistorySize;
+			const char* newline = static_cast<const char*>(memchr(start, '\n', end - start));
+			if (newline) {
+				write(context, newline + 1, end - newline - 1);
+			}
+		}
+		write(context, m_History, position);
+
+		write(context, kPending, sizeof(kPending) - 1);
+		size_t count = m_RingCount.load(std::memory_order_acquire);
+		for (size_t i = 0; i < count; ++i) {
+			const Ring* ring = m_RingTable[i].load(std::memory_order_seq_cst);
+			if (!ring) {
+				continue;
+			}
+			uint64_t tail = ring->tail.load(std::memory_order_acquire);
+			uint64_t head = ring->head.load(std::memory_order_acquire);
+			while (tail < head) {
+				// The consumer may free records under the dump and producers reuse the
+				// space; read from a copy of the header and drop whatever changed
+				uint32_t size;
+				memcpy(&size, ring->At(tail), sizeof(size));
+				uint64_t contiguous = m_RingSize - (tail & ring->mask);
+				if (size == kWrapMarker) {
+					tail += contiguous;
+					continue;
+				}
+				RecordHeader header;
+				if (contiguous < sizeof(RecordHeader)) {
+					break;
+				}
+				memcpy(&header, ring->At(tail), sizeof(header));
+				std::atomic_thread_fence(std::memory_order_acquire);
+				uint64_t freed = ring->tail.load(std::memory_order_relaxed);
+				if (freed > tail) {
+					// Drained meanwhile, so already on its way to the sink
+					tail = freed;
+					continue;
+				}
+				if (header.position != tail || header.size < sizeof(RecordHeader) || header.size > head - tail || header.size > contiguous) {
+					break;
+				}
+				char line[kMaxLineLength];
+				size_t length = FormatRecord(header, reinterpret_cast<const uint8_t*>(ring->At(tail) + 1), line, sizeof(line) - 1);
+				line[length++] = '\n';
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (ring->tail.load(std::memory_order_relaxed) > tail) {
+					continue;
+				}
+				write(context, line, length);
+				tail += header.size;
+			}
+		}
+		m_Dumping.fetch_sub(1, std::memory_order_release);
+	}
+
+private:
+	static constexpr uint32_t kWrapMarker = UINT32_MAX;
+	static constexpr size_t kHistorySize = 16 * 1024;
+	static constexpr size_t kMaxRings = 256;
+	static constexpr size_t kMaxStringArgument = 512;
+
+	enum class ArgumentTag : uint8_t {
+		Int,
+		UInt,
+		Double,
+		Bool,
+		Pointer,
+		String,
+		WideString,
+	};
+
+	// Followed by the encoded arguments; every record starts 8-byte aligned
+	struct RecordHeader {
+		uint32_t size;
+		uint8_t level;
+		uint8_t argumentCount;
+		uint16_t thread;
+		uint64_t time;
+		const char* format;
+		const char* file;
+		uint32_t line;
+		// Ring position the record was written at, stored last: a dump that finds another
+		// value is looking at a record overwritten underneath it
+		uint64_t position;
+	};
+
+	// Written by one thread, read by the consumer; positions grow without wrapping
+	struct Ring {
+		explicit Ring(size_t size, uint16_t thread) : buffer(new uint8_t[size]), mask(size - 1), thread(thread), memory(0, MemoryCategory::Arena, size) {}
+
+		const RecordHeader* At(uint64_t position) const {
+			return reinterpret_cast<const RecordHeader*>(buffer.get() + (position & mask));
+		}
+
+		RecordHeader* At(uint64_t position) {
+			return reinterpret_cast<RecordHeader*>(buffer.get() + (position & mask));
+		}
+
+		std::unique_ptr<uint8_t[]> buffer;
+		uint64_t mask;
+		uint16_t thread;
+		alignas(64) std::atomic<uint64_t> head{ 0 };
+		alignas(64) std::atomic<uint64_t> tail{ 0 };
+		std::atomic<uint64_t> dropped{ 0 };
+		// Set when the thread exits; the consumer frees the ring once drained and no
+		// dump can still be reading it
+		std::atomic<bool> retired{ false };
+		MemoryCharge memory;
+	};
+
+	// Rings of the current thread, by logger id
+	struct ThreadRings {
+		~ThreadRings() {
+			for (auto& entry : rings) {
+				entry.second->retired.store(true, std::memory_order_release);
+			}
+		}
+
+		std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> rings;
+	};
+
+	static uint64_t NextLoggerId() {
+		static std::atomic<uint64_t> id{ 0 };
+		return ++id;
+	}
+
+	static size_t RoundUpToPowerOfTwo(size_t size) {
+		size_t power = 4096;
+		while (power < size) {
+			power <<= 1;
+		}
+		return power;
+	}
+
+	// ---- Producer side ----
+
+	template <typename... Args>
+	void Write(LogLevel level, const LogFormat& format, const Args&... args) {
+		Ring* ring = GetThreadRing();
+		if (!ring) {
+			m_Dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		size_t size = sizeof(RecordHeader);
+		((size += ArgumentSize(args)), ...);
+		size = (size + 7) & ~size_t(7);
+
+		uint64_t head = ring->head.load(std::memory_order_relaxed);
+		uint64_t tail = ring->tail.load(std::memory_order_acquire);
+		uint64_t contiguous = m_RingSize - (head & ring->mask);
+		uint64_t needed = size > contiguous ? contiguous + size : size;
+		if (size > m_RingSize / 2 || head + needed - tail > m_RingSize) {
+			ring->dropped.fetch_add(1, std::memory_order_relaxed);
+			m_Dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		if (size > contiguous) {
+			ring->At(head)->size = kWrapMarker;
+			head += contiguous;
+		}
+
+		RecordHeader* header = ring->At(head);
+		header->size = static_cast<uint32_t>(size);
+		header->level = static_cast<uint8_t>(level);
+		header->argumentCount = static_cast<uint8_t>(sizeof...(Args));
+		header->thread = ring->thread;
+		header->time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start).count());
+		header->format = format.text;
+		header->file = format.location.file_name();
+		header->line = format.location.line();
+		[[maybe_unused]] uint8_t* out = reinterpret_cast<uint8_t*>(header + 1);
+		(WriteArgument(out, args), ...);
+		header->position = head;
+		ring->head.store(head + size, std::memory_order_release);
+	}
+
+	Ring* GetThreadRing() {
+		static thread_local ThreadRings local;
+		for (auto& entry : local.rings) {
+			if (entry.first == m_Id) {
+				return entry.second.get();
+			}
+		}
+		std::lock_guard<std::mutex> lock(m_RegistryMutex);
+		if (m_Stopping.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+		size_t count = m_RingCount.load(std::memory_order_relaxed);
+		size_t slot = kMaxRings;
+		for (size_t i = 0; i < count; ++i) {
+			if (!m_RingTable[i].load(std::memory_order_relaxed)) {
+				slot = i;
+				break;
+			}
+		}
+		if (slot == kMaxRings) {
+			if (count == kMaxRings) {
+				return nullptr;
+			}
+			slot = count;
+		}
+		auto ring = std::make_shared<Ring>(m_RingSize, static_cast<uint16_t>(++m_ThreadCount));
+		m_Rings[slot] = ring;
+		m_RingTable[slot].store(ring.get(), std::memory_order_release);
+		if (slot == count) {
+			m_RingCount.store(count + 1, std::memory_order_release);
+		}
+		local.rings.emplace_back(m_Id, ring);
+		return ring.get();
+	}
+
+	template <typename T>
+	static constexpr ArgumentTag TagOf() {
+		if constexpr (std::is_same_v<T, bool>) {
+			return ArgumentTag::Bool;
+		}
+		else if constexpr (std::is_enum_v<T>) {
+			return TagOf<std::underlying_type_t<T>>();
+		}
+		else if constexpr (std::is_integral_v<T>) {
+			return std::is_signed_v<T> ? ArgumentTag::Int : ArgumentTag::UInt;
+		}
+		else if constexpr (std::is_floating_point_v<T>) {
+			return ArgumentTag::Double;
+		}
+		else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+			return ArgumentTag::String;
+		}
+		else if constexpr (std::is_convertible_v<const T&, std::wstring_view>) {
+			return ArgumentTag::WideString;
+		}
+		else {
+			static_assert(std::is_pointer_v<T>, "Unsupported log argument type");
+			return ArgumentTag::Pointer;
+		}
+	}
+
+	template <typename T>
+	static std::string_view ViewOf(const T& value) {
+		if constexpr (std::is_pointer_v<std::decay_t<T>>) {
+			if (!value) {
+				return "(null)";
+			}
+		}
+		std::string_view view(value);
+		return view.substr(0, kMaxStringArgument);
+	}
+
+	template <typename T>
+	static std::wstring_view WideViewOf(const T& value) {
+		if constexpr (std::is_pointer_v<std::decay_t<T>>) {
+			if (!value) {
+				return L"(null)";
+			}
+		}
+		std::wstring_view view(value);
+		return view.substr(0, kMaxStringArgument);
+	}
+
+	template <typename T>
+	static size_t ArgumentSize(const T& value) {
+		constexpr ArgumentTag tag = TagOf<T>();
+		if constexpr (tag == ArgumentTag::String) {
+			return 1 + sizeof(uint16_t) + ViewOf(value).size();
+		}
+		else if constexpr (tag == ArgumentTag::WideString) {
+			return 1 + sizeof(uint16_t) + WideViewOf(value).size() * sizeof(wchar_t);
+		}
+		else if constexpr (tag == ArgumentTag::Bool) {
+			return 2;
+		}
+		else {
+			return 1 + sizeof(uint64_t);
+		}
+	}
+
+	template <typename T>
+	static void WriteArgument(uint8_t*& out, const T& value) {
+		constexpr ArgumentTag tag = TagOf<T>();
+		*out++ = static_cast<uint8_t>(tag);
+		if constexpr (tag == ArgumentTag::String || tag == ArgumentTag::WideString) {
+			auto view = [&]() {
+				if constexpr (tag == ArgumentTag::String) {
+					return ViewOf(value);
+				}
+				else {
+					return WideViewOf(value);
+				}
+			}();
+			uint16_t length = static_cast<uint16_t>(view.size());
+			memcpy(out, &length, sizeof(length));
+			out += sizeof(length);
+			memcpy(out, view.data(), view.size() * sizeof(view[0]));
+			out += view.size() * sizeof(view[0]);
+		}
+		else if constexpr (tag == ArgumentTag::Bool) {
+			*out++ = value ? 1 : 0;
+		}
+		else {
+			uint64_t bits;
+			if constexpr (tag == ArgumentTag::Double) {
+				double number = static_cast<double>(value);
+				memcpy(&bits, &number, sizeof(bits));
+			}
+			else if constexpr (tag == ArgumentTag::Pointer) {
+				bits = reinterpret_cast<uintptr_t>(value);
+			}
+			else {
+				bits = static_cast<uint64_t>(value);
+			}
+			memcpy(out, &bits, sizeof(bits));
+			out += sizeof(bits);
+		}
+	}
+
+	// ---- Consumer side ----
+
+	void Consume() {
+		std::unique_lock<std::mutex> wakeLock(m_WakeMutex);
+		for (;;) {
+			bool stopping = m_Stopping.load(std::memory_order_relaxed);
+			wakeLock.unlock();
+			{
+				std::lock_guard<std::mutex> lock(m_ConsumerMutex);
+				DrainAll();
+			}
+			wakeLock.lock();
+			if (stopping) {
+				return;
+			}
+			m_Wake.wait_for(wakeLock, m_DrainInterval, [this]() { return m_Stopping.load(std::memory_order_relaxed); });
+		}
+	}
+
+	// Requires m_ConsumerMutex
+	void DrainAll() {
+		size_t count = m_RingCount.load(std::memory_order_acquire);
+		for (size_t i = 0; i < count; ++i) {
+			Ring* ring = m_RingTable[i].load(std::memory_order_acquire);
+			if (!ring) {
+				continue;
+			}
+			bool retired = ring->retired.load(std::memory_order_acquire);
+			Drain(*ring);
+			uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+			if (dropped) {
+				char line[96];
+				int length = snprintf(line, sizeof(line), "[logger] thread %u dropped %llu records", ring->thread, static_cast<unsigned long long>(dropped));
+				Emit(LogLevel::Warning, line, static_cast<size_t>(length));
+			}
+			if (retired) {
+				std::lock_guard<std::mutex> lock(m_RegistryMutex);
+				m_RingTable[i].store(nullptr, std::memory_order_seq_cst);
+				m_Retired.push_back(std::move(m_Rings[i]));
+			}
+		}
+		// A dump that starts after the rings were unpublished cannot reach them, so they
+		// can go once no dump is running; a dump that never returns leaks them
+		if (!m_Retired.empty() && m_Dumping.load(std::memory_order_seq_cst) == 0) {
+			m_Retired.clear();
+		}
+	}
+
+	void Drain(Ring& ring) {
+		uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+		uint64_t head = ring.head.load(std::memory_order_acquire);
+		while (tail < head) {
+			const RecordHeader* header = ring.At(tail);
+			if (header->size == kWrapMarker) {
+				tail += m_RingSize - (tail & ring.mask);
+				continue;
+			}
+			char line[kMaxLineLength];
+			size_t length = FormatRecord(*header, reinterpret_cast<const uint8_t*>(header + 1), line, sizeof(line) - 1);
+			line[length] = '\0';
+			LogLevel level = static_cast<LogLevel>(header->level);
+			tail += header->size;
+			// Free the space before calling out, so producers are not held up by the sink
+			ring.tail.store(tail, std::memory_order_release);
+			Emit(level, line, length);
+		}
+		ring.tail.store(tail, std::memory_order_release);
+	}
+
+	void Emit(LogLevel level, const char* line, size_t length) {
+		AppendHistory(line, length);
+		if (m_Sink) {
+			m_Sink(level, line, length);
+		}
+	}
+
+	void AppendHistory(const char* line, size_t length) {
+		size_t position = m_HistoryPosition.load(std::memory_order_relaxed);
+		auto append = [&](const char* data, size_t size) {
+			while (size) {
+				size_t chunk = std::min(size, kHistorySize - position);
+				memcpy(m_History + position, data, chunk);
+				position += chunk;
+				data += chunk;
+				size -= chunk;
+				if (position == kHistorySize) {
+					position = 0;
+					m_HistoryWrapped.store(true, std::memory_order_release);
+				}
+			}
+		};
+		append(line, length);
+		append("\n", 1);
+		m_HistoryPosition.store(position, std::memory_order_release);
+	}
+
+	// Formats without allocating; returns the length written to `out`. Arguments are only
+	// read within the record's size, so a garbled record cannot read past it.
+	size_t FormatRecord(const RecordHeader& header, const uint8_t* arguments, char* out, size_t capacity) const {
+		static const char kLevels[] = "TDIWEF";
+		size_t length = 0;
+		auto put = [&](const char* data, size_t size) {
+			size_t chunk = std::min(size, capacity - length);
+			memcpy(out + length, data, chunk);
+			length += chunk;
+		};
+		auto print = [&](const char* format, auto... values) {
+			char buffer[64];
+			int size = snprintf(buffer, sizeof(buffer), format, values...);
+			if (size > 0) {
+				put(buffer, std::min(static_cast<size_t>(size), sizeof(buffer) - 1));
+			}
+		};
+
+		auto putUnsigned = [&](uint64_t value, int width) {
+			char digits[20];
+			int count = 0;
+			do {
+				digits[count++] = static_cast<char>('0' + value % 10);
+				value /= 10;
+			} while (value);
+			for (; width > count; --width) {
+				put(" ", 1);
+			}
+			while (count) {
+				put(&digits[--count], 1);
+			}
+		};
+
+		const char* file = header.file ? header.file : "";
+		const char* slash = strrchr(file, '/');
+		const char* backslash = strrchr(file, '\\');
+		const char* name = std::max(slash ? slash + 1 : file, backslash ? backslash + 1 : file);
+		char level[] = { ']', ' ', header.level < 6 ? kLevels[header.level] : '?', ' ', 't' };
+		char micros[7];
+		uint64_t fraction = header.time / 1000 % 1000000;
+		for (int i = 6; i > 0; --i, fraction /= 10) {
+			micros[i] = static_cast<char>('0' + fraction % 10);
+		}
+		micros[0] = '.';
+		put("[", 1);
+		putUnsigned(header.time / 1000000000, 5);
+		put(micros, sizeof(micros));
+		put(level, sizeof(level));
+		putUnsigned(header.thread, 0);
+		put(" ", 1);
+		put(name, strlen(name));
+		put(":", 1);
+		putUnsigned(header.line, 0);
+		put(" ", 1);
+
+		const uint8_t* argument = arguments;
+		const uint8_t* end = arguments + (header.size - sizeof(RecordHeader));
+		size_t remaining = header.argumentCount;
+		// Returns false, leaving the rest of the record, if the argument does not fit in it
+		auto putArgument = [&]() {
+			if (end - argument < 2) {
+				return false;
+			}
+			ArgumentTag tag = static_cast<ArgumentTag>(*argument++);
+			uint64_t bits = 0;
+			uint16_t size = 0;
+			switch (tag) {
+			case ArgumentTag::Bool:
+				put(*argument ? "true" : "false", *argument ? 4 : 5);
+				argument += 1;
+				return true;
+			case ArgumentTag::String:
+			case ArgumentTag::WideString: {
+				if (end - argument < static_cast<ptrdiff_t>(sizeof(size))) {
+					return false;
+				}
+				memcpy(&size, argument, sizeof(size));
+				size_t bytes = size * (tag == ArgumentTag::String ? 1 : sizeof(wchar_t));
+				if (static_cast<size_t>(end - argument) - sizeof(size) < bytes) {
+					return false;
+				}
+				argument += sizeof(size);
+				if (tag == ArgumentTag::String) {
+					put(reinterpret_cast<const char*>(argument), size);
+				}
+				else {
+					PutWide(argument, size, put);
+				}
+				argument += bytes;
+				return true;
+			}
+			default:
+				break;
+			}
+			if (end - argument < static_cast<ptrdiff_t>(sizeof(bits))) {
+				return false;
+			}
+			memcpy(&bits, argument, sizeof(bits));
+			argument += sizeof(bits);
+			if (tag == ArgumentTag::Int) {
+				int64_t value = static_cast<int64_t>(bits);
+				if (value < 0) {
+					put("-", 1);
+				}
+				putUnsigned(value < 0 ? 0 - bits : bits, 0);
+			}
+			else if (tag == ArgumentTag::UInt) {
+				putUnsigned(bits, 0);
+			}
+			else if (tag == ArgumentTag::Double) {
+				double number;
+				memcpy(&number, &bits, sizeof(number));
+				print("%g", number);
+			}
+			else {
+				print("0x%llx", static_cast<unsigned long long>(bits));
+			}
+			return true;
+		};
+
+		for (const char* c = header.format ? header.format : ""; *c; ++c) {
+			if (c[0] == '{' && c[1] == '}' && remaining) {
+				remaining = putArgument() ? remaining - 1 : 0;
+				++c;
+			}
+			else {
+				put(c, 1);
+			}
+		}
+		// Arguments without a placeholder are appended
+		while (remaining) {
+			put(" ", 1);
+			remaining = putArgument() ? remaining - 1 : 0;
+		}
+		return length;
+	}
+
+	// Converts UTF-16 (Windows) or UTF-32 `wchar_t`s to UTF-8
+	template <typename Put>
+	static void PutWide(const uint8_t* data, size_t count, Put& put) {
+		for (size_t i = 0; i < count; ++i) {
+			wchar_t c;
+			memcpy(&c, data + i * sizeof(wchar_t), sizeof(c));
+			uint32_t code = static_cast<uint32_t>(c);
+			if (sizeof(wchar_t) == 2 && code >= 0xD800 && code < 0xDC00 && i + 1 < count) {
+				wchar_t low;
+				memcpy(&low, data + (i + 1) * sizeof(wchar_t), sizeof(low));
+				if (static_cast<uint32_t>(low) >= 0xDC00 && static_cast<uint32_t>(low) < 0xE000) {
+					code = 0x10000 + ((code - 0xD800) << 10) + (static_cast<uint32_t>(low) - 0xDC00);
+					++i;
+				}
+			}
+			char bytes[4];
+			size_t size;
+			if (code < 0x80) {
+				bytes[0] = static_cast<char>(code);
+				size = 1;
+			}
+			else if (code < 0x800) {
+				bytes[0] = static_cast<char>(0xC0 | (code >> 6));
+				bytes[1] = static_cast<char>(0x80 | (code & 0x3F));
+				size = 2;
+			}
+			else if (code < 0x10000) {
+				bytes[0] = static_cast<char>(0xE0 | (code >> 12));
+				bytes[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+				bytes[2] = static_cast<char>(0x80 | (code & 0x3F));
+				size = 3;
+			}
+			else {
+				bytes[0] = static_cast<char>(0xF0 | (code >> 18));
+				bytes[1] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+				bytes[2] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+				bytes[3] = static_cast<char>(0x80 | (code & 0x3F));
+				size = 4;
+			}
+			put(bytes, size);
+		}
+	}
+
+	Sink m_Sink;
+	size_t m_RingSize;
+	std::chrono::milliseconds m_DrainInterval;
+	std::chrono::steady_clock::time_point m_Start;
+	uint64_t m_Id;
+	std::atomic<uint8_t> m_Level{ static_cast<uint8_t>(LogLevel::Info) };
+	std::atomic<uint64_t> m_Dropped{ 0 };
+
+	// Rings are published in a fixed table so that `Dump` can walk them without locking
+	std::mutex m_RegistryMutex;
+	std::shared_ptr<Ring> m_Rings[kMaxRings];
+	std::atomic<Ring*> m_RingTable[kMaxRings] = {};
+	std::atomic<size_t> m_RingCount{ 0 };
+	uint32_t m_ThreadCount = 0;
+	// Unpublished rings waiting for running dumps to finish; requires m_ConsumerMutex
+	std::vector<std::shared_ptr<Ring>> m_Retired;
+	mutable std::atomic<uint32_t> m_Dumping{ 0 };
+
+	std::mutex m_ConsumerMutex;
+	char m_History[kHistorySize] = {};
+	std::atomic<size_t> m_HistoryPosition{ 0 };
+	std::atomic<bool> m_HistoryWrapped{ false };
+
+	std::mutex m_WakeMutex;
+	std::condition_variable m_Wake;
+	// Written under m_WakeMutex, also read by producers under m_RegistryMutex
+	std::atomic<bool> m_Stopping{ false };
+	std::thread m_Thread;
+};
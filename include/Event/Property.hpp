@@ -0,0 +1,264 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+
+class PropertyGraph;
+
+// Node of a property graph: a source `Property`, a derived `Computed` value or a
+// `PropertyEffect`. Dependencies are declared when a node is constructed and must
+// already exist, so the graph is acyclic by construction.
+class PropertyNode {
+public:
+	PropertyNode(const PropertyNode&) = delete;
+	PropertyNode& operator=(const PropertyNode&) = delete;
+
+	// Bumped whenever the node's value actually changes
+	uint64_t GetVersion() const {
+		return m_Version;
+	}
+
+protected:
+	PropertyNode(PropertyGraph& graph, std::initializer_list<PropertyNode*> dependencies) : m_Graph(graph), m_Dependencies(dependencies) {
+		for (PropertyNode* dependency : m_Dependencies) {
+			dependency->m_Dependents.push_back(this);
+		}
+		m_SeenVersions.assign(m_Dependencies.size(), UINT64_MAX);
+	}
+
+	virtual ~PropertyNode() {
+		for (PropertyNode* dependency : m_Dependencies) {
+			Erase(dependency->m_Dependents, this);
+		}
+		for (PropertyNode* dependent : m_Dependents) {
+			size_t index = std::find(dependent->m_Dependencies.begin(), dependent->m_Dependencies.end(), this) - dependent->m_Dependencies.begin();
+			dependent->m_Dependencies.erase(dependent->m_Dependencies.begin() + index);
+			dependent->m_SeenVersions.erase(dependent->m_SeenVersions.begin() + index);
+		}
+	}
+
+	// Brings the node up to date; only derived nodes have work to do
+	virtual void Refresh() {}
+
+	// Called when the node turns dirty
+	virtual void OnDirty() {}
+
+	// Marks everything downstream dirty, stopping at nodes that already are
+	void InvalidateDependents() {
+		for (PropertyNode* dependent : m_Dependents) {
+			dependent->MarkDirty();
+		}
+	}
+
+	// Refreshes the dependencies and returns whether any of them changed since the last
+	// call. Dependencies that recomputed to an equal value do not count.
+	bool RefreshDependencies() {
+		bool changed = false;
+		for (size_t i = 0; i < m_Dependencies.size(); ++i) {
+			m_Dependencies[i]->Refresh();
+			uint64_t version = m_Dependencies[i]->m_Version;
+			if (version != m_SeenVersions[i]) {
+				m_SeenVersions[i] = version;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	PropertyGraph& m_Graph;
+	uint64_t m_Version = 0;
+	bool m_Dirty = true;
+
+private:
+	void MarkDirty() {
+		if (m_Dirty) {
+			return;
+		}
+		m_Dirty = true;
+		OnDirty();
+		InvalidateDependents();
+	}
+
+	template <typename T>
+	static void Erase(std::vector<T>& items, const T& item) {
+		items.erase(std::remove(items.begin(), items.end(), item), items.end());
+	}
+
+	std::vector<PropertyNode*> m_Dependencies;
+	std::vector<uint64_t> m_SeenVersions;
+	std::vector<PropertyNode*> m_Dependents;
+};
+
+class PropertyEffect;
+
+// Owner of the effects waiting for a flush. Changing a property only marks its
+// dependents dirty; `Flush`, typically called once per frame, recomputes what the
+// scheduled effects read, each derived value at most once, and runs the effects whose
+// inputs changed value. Platform independent; single-threaded.
+class PropertyGraph {
+public:
+	struct Stats {
+		uint64_t flushes = 0;
+		uint64_t recomputations = 0;
+		// Dirty derived values whose inputs turned out unchanged
+		uint64_t recomputationsSkipped = 0;
+		uint64_t effectsRun = 0;
+		// Scheduled effects whose inputs turned out unchanged
+		uint64_t effectsSkipped = 0;
+	};
+
+	bool HasPending() const {
+		return !m_Scheduled.empty();
+	}
+
+	// Runs the scheduled effects. Effects that change properties schedule more effects,
+	// which run in the same flush for up to `kMaxPasses` rounds; anything left after that
+	// (a feedback loop) waits for the next flush.
+	inline void Flush();
+
+	const Stats& GetStats() const {
+		return m_Stats;
+	}
+
+	Stats& GetStats() {
+		return m_Stats;
+	}
+
+private:
+	friend class PropertyEffect;
+
+	static constexpr int kMaxPasses = 8;
+
+	void Schedule(PropertyEffect* effect) {
+		m_Scheduled.push_back(effect);
+	}
+
+	void Unschedule(PropertyEffect* effect) {
+		std::replace(m_Scheduled.begin(), m_Scheduled.end(), effect, static_cast<PropertyEffect*>(nullptr));
+		std::replace(m_Running.begin(), m_Running.end(), effect, static_cast<PropertyEffect*>(nullptr));
+	}
+
+	std::vector<PropertyEffect*> m_Scheduled;
+	std::vector<PropertyEffect*> m_Running;
+	Stats m_Stats;
+};
+
+// Node with a value of type `T`, readable by dependents and bindings
+template <typename T>
+class PropertyValue : public PropertyNode {
+public:
+	// The current value, recomputed first if it is stale
+	const T& Get() {
+		Refresh();
+		return m_Value;
+	}
+
+protected:
+	PropertyValue(PropertyGraph& graph, std::initializer_list<PropertyNode*> dependencies, T value)
+		: PropertyNode(graph, dependencies), m_Value(std::move(value)) {}
+
+	T m_Value;
+};
+
+// Source value set by the model
+template <typename T>
+class Property : public PropertyValue<T> {
+public:
+	explicit Property(PropertyGraph& graph, T value = T()) : PropertyValue<T>(graph, {}, std::move(value)) {
+		this->m_Dirty = false;
+	}
+
+	// Does nothing if `value` equals the current value
+	void Set(T value) {
+		if (value == this->m_Value) {
+			return;
+		}
+		this->m_Value = std::move(value);
+		++this->m_Version;
+		this->InvalidateDependents();
+	}
+};
+
+// Value derived from other nodes, recomputed on demand once any of them changed
+template <typename T>
+class Computed : public PropertyValue<T> {
+public:
+	Computed(PropertyGraph& graph, std::initializer_list<PropertyNode*> dependencies, std::function<T()> compute)
+		: PropertyValue<T>(graph, dependencies, T()), m_Compute(std::move(compute)) {}
+
+protected:
+	void Refresh() override {
+		if (!this->m_Dirty) {
+			return;
+		}
+		this->m_Dirty = false;
+		if (!this->RefreshDependencies() && m_Computed) {
+			++this->m_Graph.GetStats().recomputationsSkipped;
+			return;
+		}
+		T value = m_Compute();
+		++this->m_Graph.GetStats().recomputations;
+		if (!m_Computed || !(value == this->m_Value)) {
+			this->m_Value = std::move(value);
+			++this->m_Version;
+		}
+		m_Computed = true;
+	}
+
+private:
+	std::function<T()> m_Compute;
+	bool m_Computed = false;
+};
+
+// Side effect, such as pushing a value to a window, run by `PropertyGraph::Flush` when
+// one of its dependencies changed value; and once on the first flush after creation
+class PropertyEffect : public PropertyNode {
+public:
+	PropertyEffect(PropertyGraph& graph, std::initializer_list<PropertyNode*> dependencies, std::function<void()> action)
+		: PropertyNode(graph, dependencies), m_Action(std::move(action)) {
+		m_Graph.Schedule(this);
+	}
+
+	~PropertyEffect() override {
+		m_Graph.Unschedule(this);
+	}
+
+private:
+	friend class PropertyGraph;
+
+	void OnDirty() override {
+		m_Graph.Schedule(this);
+	}
+
+	void Run() {
+		m_Dirty = false;
+		if (RefreshDependencies()) {
+			++m_Graph.GetStats().effectsRun;
+			m_Action();
+		}
+		else {
+			++m_Graph.GetStats().effectsSkipped;
+		}
+	}
+
+	std::function<void()> m_Action;
+};
+
+inline void PropertyGraph::Flush() {
+	++m_Stats.flushes;
+	for (int pass = 0; pass < kMaxPasses && !m_Scheduled.empty(); ++pass) {
+		m_Running.swap(m_Scheduled);
+		for (size_t i = 0; i < m_Running.size(); ++i) {
+			// Null once unscheduled by an effect destroyed during the flush
+			if (PropertyEffect* effect = m_Running[i]) {
+				effect->Run();
+			}
+		}
+		m_Running.clear();
+	}
+}
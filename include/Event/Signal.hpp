@@ -0,0 +1,265 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+// Handle of one connection. Handles of disconnected slots go stale and are ignored, even
+// after their slot is reused.
+struct SignalConnection {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	explicit operator bool() const {
+		return index != UINT32_MAX;
+	}
+};
+
+class SignalBase {
+public:
+	virtual void Disconnect(SignalConnection connection) = 0;
+
+protected:
+	~SignalBase() = default;
+};
+
+// Disconnects when it goes out of scope. The signal must outlive it.
+class ScopedConnection {
+public:
+	ScopedConnection() = default;
+
+	ScopedConnection(SignalBase& signal, SignalConnection connection) : m_Signal(&signal), m_Connection(connection) {}
+
+	ScopedConnection(ScopedConnection&& other) noexcept
+		: m_Signal(std::exchange(other.m_Signal, nullptr)), m_Connection(other.m_Connection) {}
+
+	ScopedConnection& operator=(ScopedConnection&& other) noexcept {
+		if (this != &other) {
+			Disconnect();
+			m_Signal = std::exchange(other.m_Signal, nullptr);
+			m_Connection = other.m_Connection;
+		}
+		return *this;
+	}
+
+	ScopedConnection(const ScopedConnection&) = delete;
+	ScopedConnection& operator=(const ScopedConnection&) = delete;
+
+	~ScopedConnection() {
+		Disconnect();
+	}
+
+	void Disconnect() {
+		if (m_Signal) {
+			m_Signal->Disconnect(m_Connection);
+			m_Signal = nullptr;
+		}
+	}
+
+private:
+	SignalBase* m_Signal = nullptr;
+	SignalConnection m_Connection;
+};
+
+// Typed event with any number of slots. Slots live in a slot map: fixed-size entries,
+// each holding the callable inline, allocated in chunks that never move, with
+// disconnected entries threaded onto a free list for reuse. Emitting is a loop over the
+// chunks that calls every slot in place and never allocates.
+//
+// Slots must be trivially copyable callables of at most four pointers, e.g. lambdas
+// capturing `this` and a few values, or a method bound with `Connect<&T::Method>(object)`.
+// Slots may connect and disconnect (themselves included) while the signal is emitting:
+// disconnected slots are not called again, and slots connected during an emit are first
+// called by the next one. A slot may also destroy the signal; the emit then stops and
+// frees the slots once it unwinds. Slots are called in no particular order. Not
+// thread-safe.
+template <typename... Args>
+class Signal : public SignalBase {
+public:
+	Signal() = default;
+	Signal(const Signal&) = delete;
+	Signal& operator=(const Signal&) = delete;
+
+	~Signal() {
+		if (m_Frame) {
+			// Destroyed by a slot: stop every emit on the stack and keep the slots, including
+			// the one running, until the outermost emit returns
+			EmitFrame* outermost = m_Frame;
+			for (EmitFrame* frame = m_Frame; frame; frame = frame->outer) {
+				frame->destroyed = true;
+				outermost = frame;
+			}
+			outermost->orphaned = std::move(m_Chunks);
+		}
+	}
+
+	template <typename Callable>
+	SignalConnection Connect(Callable callable) {
+		static_assert(sizeof(Callable) <= sizeof(Storage) && alignof(Callable) <= alignof(Storage), "Slot captures must fit in four pointers");
+		static_assert(std::is_trivially_copyable_v<Callable> && std::is_trivially_destructible_v<Callable>, "Slots must be trivially copyable; capture pointers, not owning objects");
+		uint32_t index = AcquireSlot();
+		Slot& slot = SlotAt(index);
+		new (&slot.storage) Callable(callable);
+		slot.invoke = [](void* storage, Args... args) {
+			(*static_cast<Callable*>(storage))(args...);
+		};
+		++m_Count;
+		return { index, slot.generation };
+	}
+
+	// Connects `object->Method`
+	template <auto Method, typename Object>
+	SignalConnection Connect(Object* object) {
+		return Connect([object](Args... args) {
+			(object->*Method)(args...);
+		});
+	}
+
+	// Like `Connect`, disconnecting when the returned scope ends
+	template <typename Callable>
+	ScopedConnection ConnectScoped(Callable callable) {
+		return ScopedConnection(*this, Connect(callable));
+	}
+
+	void Disconnect(SignalConnection connection) override {
+		if (connection.index >= m_SlotCount) {
+			return;
+		}
+		Slot& slot = SlotAt(connection.index);
+		if (slot.generation != connection.generation || !slot.invoke) {
+			return;
+		}
+		slot.invoke = nullptr;
+		++slot.generation;
+		--m_Count;
+		if (m_Frame) {
+			// Not reused until the emit finishes, or a slot connected meanwhile could run
+			slot.pending = true;
+			m_HasPending = true;
+		}
+		else {
+			Release(connection.index);
+		}
+	}
+
+	void DisconnectAll() {
+		for (uint32_t i = 0; i < m_SlotCount; ++i) {
+			Slot& slot = SlotAt(i);
+			if (slot.invoke) {
+				Disconnect({ i, slot.generation });
+			}
+		}
+	}
+
+	void Emit(Args... args) {
+		if (!m_Count) {
+			return;
+		}
+		EmitFrame frame;
+		frame.outer = m_Frame;
+		m_Frame = &frame;
+		uint32_t count = m_SlotCount;
+		for (uint32_t base = 0; base < count; base += kChunkSize) {
+			// Chunks never move, so slots are called in place even if one connects another
+			Slot* chunk = m_Chunks[base / kChunkSize].get();
+			uint32_t end = count - base < kChunkSize ? count - base : kChunkSize;
+			for (uint32_t i = 0; i < end; ++i) {
+				if (!chunk[i].invoke) {
+					continue;
+				}
+				chunk[i].invoke(&chunk[i].storage, args...);
+				if (frame.destroyed) {
+					return;
+				}
+			}
+		}
+		m_Frame = frame.outer;
+		if (!m_Frame && m_HasPending) {
+			ReleasePending();
+		}
+	}
+
+	void operator()(Args... args) {
+		Emit(args...);
+	}
+
+	size_t GetConnectionCount() const {
+		return m_Count;
+	}
+
+	bool IsEmpty() const {
+		return m_Count == 0;
+	}
+
+private:
+	static constexpr uint32_t kNoSlot = UINT32_MAX;
+	static constexpr uint32_t kChunkSize = 16;
+
+	struct Storage {
+		alignas(void*) unsigned char bytes[4 * sizeof(void*)];
+	};
+
+	struct Slot {
+		Storage storage;
+		void (*invoke)(void*, Args...) = nullptr;
+		uint32_t generation = 0;
+		uint32_t nextFree = kNoSlot;
+		bool pending = false;
+	};
+
+	// One `Emit` on the stack, linked to the one it is nested in
+	struct EmitFrame {
+		EmitFrame* outer = nullptr;
+		// Set when a slot destroyed the signal; nothing in it may be touched after that
+		bool destroyed = false;
+		// Slots of a destroyed signal, freed when the outermost emit returns
+		std::vector<std::unique_ptr<Slot[]>> orphaned;
+	};
+
+	Slot& SlotAt(uint32_t index) {
+		return m_Chunks[index / kChunkSize][index % kChunkSize];
+	}
+
+	uint32_t AcquireSlot() {
+		// While emitting, append so that the new slot lies past the emit's range
+		if (m_FreeHead != kNoSlot && !m_Frame) {
+			uint32_t index = m_FreeHead;
+			m_FreeHead = SlotAt(index).nextFree;
+			SlotAt(index).nextFree = kNoSlot;
+			return index;
+		}
+		if (m_SlotCount % kChunkSize == 0) {
+			m_Chunks.push_back(std::make_unique<Slot[]>(kChunkSize));
+		}
+		return m_SlotCount++;
+	}
+
+	void Release(uint32_t index) {
+		SlotAt(index).nextFree = m_FreeHead;
+		m_FreeHead = index;
+	}
+
+	void ReleasePending() {
+		for (uint32_t i = 0; i < m_SlotCount; ++i) {
+			Slot& slot = SlotAt(i);
+			if (slot.pending) {
+				slot.pending = false;
+				Release(i);
+			}
+		}
+		m_HasPending = false;
+	}
+
+	std::vector<std::unique_ptr<Slot[]>> m_Chunks;
+	// Slots handed out so far, in use or on the free list
+	uint32_t m_SlotCount = 0;
+	uint32_t m_FreeHead = kNoSlot;
+	size_t m_Count = 0;
+	// Innermost emit running, null outside of emits
+	EmitFrame* m_Frame = nullptr;
+	bool m_HasPending = false;
+};
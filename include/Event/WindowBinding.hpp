@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <windows.h>
+
+#include "Property.hpp"
+#include "../Loop/RunLoop.hpp"
+#include "../Window/Window.hpp"
+
+// Binds properties of a `PropertyGraph` to a window's title, styles, visibility and
+// enabled state. The graph is flushed by a `RunLoop` work handler after the messages of
+// a loop pass were dispatched, at most once per `interval`, and a window setter only
+// runs when the value bound to it changed, so a burst of model updates costs one
+// recomputation and one `SetWindowText` per frame at most.
+class WindowBinding {
+public:
+	WindowBinding(RunLoop& loop, PropertyGraph& graph, Window& window, std::chrono::microseconds interval = std::chrono::microseconds(16667))
+		: m_Loop(loop), m_Graph(graph), m_Window(window), m_Interval(interval) {
+		m_WorkHandler = m_Loop.AddWorkHandler([this]() {
+			return Flush();
+		});
+	}
+
+	~WindowBinding() {
+		m_Loop.RemoveWorkHandler(m_WorkHandler);
+	}
+
+	WindowBinding(const WindowBinding&) = delete;
+	WindowBinding& operator=(const WindowBinding&) = delete;
+
+	void BindTitle(PropertyValue<std::wstring>& title) {
+		Bind(title, [this, &title]() {
+			m_Window.SetTitle(title.Get().c_str());
+		});
+	}
+
+	void BindStyle(PropertyValue<DWORD>& style) {
+		Bind(style, [this, &style]() {
+			m_Window.SetStyle(style.Get());
+		});
+	}
+
+	void BindExStyle(PropertyValue<DWORD>& exStyle) {
+		Bind(exStyle, [this, &exStyle]() {
+			m_Window.SetExStyle(exStyle.Get());
+		});
+	}
+
+	void BindVisible(PropertyValue<bool>& visible) {
+		Bind(visible, [this, &visible]() {
+			if (visible.Get()) {
+				m_Window.Show();
+			}
+			else {
+				m_Window.Hide();
+			}
+		});
+	}
+
+	void BindEnabled(PropertyValue<bool>& enabled) {
+		Bind(enabled, [this, &enabled]() {
+			EnableWindow(m_Window.GetHandle(), enabled.Get());
+		});
+	}
+
+	// Values pushed to the window so far
+	uint64_t GetUpdateCount() const {
+		return m_Updates;
+	}
+
+private:
+	template <typename T, typename Action>
+	void Bind(PropertyValue<T>& value, Action action) {
+		m_Effects.push_back(std::make_unique<PropertyEffect>(m_Graph, std::initializer_list<PropertyNode*>{ &value }, [this, action]() {
+			++m_Updates;
+			action();
+		}));
+	}
+
+	RunLoop::Clock::time_point Flush() {
+		if (!m_Graph.HasPending()) {
+			return RunLoop::Clock::time_point::max();
+		}
+		RunLoop::Clock::time_point now = RunLoop::Clock::now();
+		if (now < m_NextFlush) {
+			return m_NextFlush;
+		}
+		m_Graph.Flush();
+		m_NextFlush = now + m_Interval;
+		return m_Graph.HasPending() ? m_NextFlush : RunLoop::Clock::time_point::max();
+	}
+
+	RunLoop& m_Loop;
+	PropertyGraph& m_Graph;
+	Window& m_Window;
+	std::chrono::microseconds m_Interval;
+	size_t m_WorkHandler = 0;
+	RunLoop::Clock::time_point m_NextFlush;
+	std::vector<std::unique_ptr<PropertyEffect>> m_Effects;
+	uint64_t m_Updates = 0;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <windows.h>
+
+#include "Signal.hpp"
+#include "../Window/Window.hpp"
+
+// Window notifications fanned out to any number of subscribers through `Signal`s. A
+// single message layer on the window feeds all of them, so subscribers neither wrap the
+// window procedure nor cost anything for unrelated messages. Messages are never consumed.
+//
+//	WindowEvents events(window);
+//	ScopedConnection connection = events.Resized().ConnectScoped([this](int width, int height) { Layout(width, height); });
+class WindowEvents {
+public:
+	explicit WindowEvents(Window& window) : m_Window(window) {
+		m_Layer = m_Window.AddMessageLayer({ WM_SIZE, WM_MOVE, WM_SETFOCUS, WM_KILLFOCUS, WM_DPICHANGED, WM_CLOSE }, [this](HWND, UINT message, WPARAM wParam, LPARAM lParam, LRESULT&) {
+			Dispatch(message, wParam, lParam);
+			return false;
+		});
+	}
+
+	~WindowEvents() {
+		m_Window.RemoveMessageLayer(m_Layer);
+	}
+
+	WindowEvents(const WindowEvents&) = delete;
+	WindowEvents& operator=(const WindowEvents&) = delete;
+
+	// New client size
+	Signal<int, int>& Resized() {
+		return m_Resized;
+	}
+
+	// New client origin, in screen coordinates
+	Signal<int, int>& Moved() {
+		return m_Moved;
+	}
+
+	// True when the window gains the keyboard focus, false when it loses it
+	Signal<bool>& FocusChanged() {
+		return m_FocusChanged;
+	}
+
+	// New DPI and the window rectangle Windows suggests for it
+	Signal<UINT, const RECT&>& DpiChanged() {
+		return m_DpiChanged;
+	}
+
+	// The user asked to close the window
+	Signal<>& CloseRequested() {
+		return m_CloseRequested;
+	}
+
+private:
+	void Dispatch(UINT message, WPARAM wParam, LPARAM lParam) {
+		switch (message) {
+		case WM_SIZE:
+			m_Resized.Emit(LOWORD(lParam), HIWORD(lParam));
+			break;
+		case WM_MOVE:
+			m_Moved.Emit(static_cast<short>(LOWORD(lParam)), static_cast<short>(HIWORD(lParam)));
+			break;
+		case WM_SETFOCUS:
+		case WM_KILLFOCUS:
+			m_FocusChanged.Emit(message == WM_SETFOCUS);
+			break;
+		case WM_DPICHANGED:
+			m_DpiChanged.Emit(HIWORD(wParam), *reinterpret_cast<const RECT*>(lParam));
+			break;
+		case WM_CLOSE:
+			m_CloseRequested.Emit();
+			break;
+		}
+	}
+
+	Window& m_Window;
+	size_t m_Layer = 0;
+	Signal<int, int> m_Resized;
+	Signal<int, int> m_Moved;
+	Signal<bool> m_FocusChanged;
+	Signal<UINT, const RECT&> m_DpiChanged;
+	Signal<> m_CloseRequested;
+};
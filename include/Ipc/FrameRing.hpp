@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Lock-free exchange of three frame slots between one producer and one consumer.
+// `FrameRing` holds only the words both sides touch. It is a plain standard-layout struct
+// so it can live in memory shared between processes (a file mapping) as well as in
+// ordinary process memory. Each side keeps its own state in a `FrameProducer` or
+// `FrameConsumer` in its own process memory, so the other side can never change it. It
+// does not depend on any Win32 API.
+//
+// The producer always owns one slot, the consumer owns one slot, and the third slot is
+// "in the middle". Publishing swaps the producer's slot with the middle one, acquiring
+// swaps the consumer's slot with the middle one if it holds a newer frame. Neither side
+// ever waits on the other, and a slow consumer simply skips frames.
+//
+// The shared words may be written by another process, so every slot index read from
+// them is checked before it is used. An out-of-range index is counted and ignored.
+struct FrameRing {
+	static constexpr uint32_t kSlotCount = 3;
+	static constexpr uint32_t kNoFrame = 0xFFFFFFFF;
+
+	static_assert(std::atomic<uint32_t>::is_always_lock_free, "FrameRing requires address-free atomics");
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "FrameRing requires address-free atomics");
+
+	// Must be called exactly once by whoever creates the memory, before either side uses it
+	void Initialize() {
+		m_Middle.store(kFirstMiddleSlot, std::memory_order_relaxed);
+		m_Published.store(0, std::memory_order_relaxed);
+		for (uint32_t i = 0; i < kSlotCount; ++i) {
+			m_SlotSequence[i].store(0, std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	// Sequence number of the newest published frame
+	uint64_t PublishedSequence() const {
+		return m_Published.load(std::memory_order_acquire);
+	}
+
+	bool HasNewFrame() const {
+		return (m_Middle.load(std::memory_order_acquire) & kFreshBit) != 0;
+	}
+
+private:
+	friend class FrameProducer;
+	friend class FrameConsumer;
+
+	static constexpr uint32_t kFreshBit = 0x80000000;
+	// Slots each side starts with after `Initialize`
+	static constexpr uint32_t kFirstWriteSlot = 0;
+	static constexpr uint32_t kFirstMiddleSlot = 1;
+	static constexpr uint32_t kFirstReadSlot = 2;
+
+	alignas(64) std::atomic<uint32_t> m_Middle;
+	std::atomic<uint64_t> m_Published;
+	std::atomic<uint64_t> m_SlotSequence[kSlotCount];
+};
+
+// Producer end of a `FrameRing`. Lives in the producer's own memory.
+class FrameProducer {
+public:
+	FrameProducer() = default;
+
+	explicit FrameProducer(FrameRing& ring) : m_Ring(&ring) {}
+
+	// Slot the producer may write into until the next `Publish`
+	uint32_t WriteSlot() const {
+		return m_WriteSlot;
+	}
+
+	// Hands the current write slot to the consumer and returns the frame's sequence number
+	uint64_t Publish() {
+		uint64_t sequence = ++m_Produced;
+		m_Ring->m_SlotSequence[m_WriteSlot].store(sequence, std::memory_order_relaxed);
+		uint32_t previous = m_Ring->m_Middle.exchange(m_WriteSlot | FrameRing::kFreshBit, std::memory_order_acq_rel) & ~FrameRing::kFreshBit;
+		if (previous < FrameRing::kSlotCount) {
+			m_WriteSlot = previous;
+		}
+		else {
+			// Keep drawing into the same slot; the consumer may see a torn frame but
+			// nothing is written outside the slots
+			++m_Rejected;
+		}
+		m_Ring->m_Published.store(sequence, std::memory_order_release);
+		return sequence;
+	}
+
+	// Out-of-range slot indices found in the shared words
+	uint64_t RejectedSlots() const {
+		return m_Rejected;
+	}
+
+private:
+	FrameRing* m_Ring = nullptr;
+	uint32_t m_WriteSlot = FrameRing::kFirstWriteSlot;
+	uint64_t m_Produced = 0;
+	uint64_t m_Rejected = 0;
+};
+
+// Consumer end of a `FrameRing`. Lives in the consumer's own memory.
+class FrameConsumer {
+public:
+	FrameConsumer() = default;
+
+	explicit FrameConsumer(FrameRing& ring) : m_Ring(&ring) {}
+
+	// Takes the newest published frame if there is one. Returns false if the consumer
+	// already holds the latest frame, in which case `ReadSlot` is unchanged.
+	bool Acquire() {
+		if (!(m_Ring->m_Middle.load(std::memory_order_relaxed) & FrameRing::kFreshBit)) {
+			return false;
+		}
+		uint32_t previous = m_Ring->m_Middle.exchange(m_ReadSlot, std::memory_order_acq_rel) & ~FrameRing::kFreshBit;
+		if (previous >= FrameRing::kSlotCount) {
+			++m_Rejected;
+			return false;
+		}
+		m_ReadSlot = previous;
+		uint64_t sequence = m_Ring->m_SlotSequence[m_ReadSlot].load(std::memory_order_relaxed);
+		// Only a sequence that moves forward counts; anything else is a broken producer
+		if (sequence > m_LastConsumed) {
+			if (m_HasFrame) {
+				m_Dropped += sequence - m_LastConsumed - 1;
+			}
+			m_LastConsumed = sequence;
+		}
+		m_HasFrame = true;
+		return true;
+	}
+
+	// Slot holding the frame last returned by `Acquire`, or kNoFrame before the first one.
+	// Always below `kSlotCount` otherwise.
+	uint32_t ReadSlot() const {
+		return m_HasFrame ? m_ReadSlot : FrameRing::kNoFrame;
+	}
+
+	// Sequence number of the frame in `ReadSlot`
+	uint64_t ReadSequence() const {
+		return m_LastConsumed;
+	}
+
+	// Frames published but never acquired because a newer one replaced them
+	uint64_t DroppedFrames() const {
+		return m_Dropped;
+	}
+
+	// Out-of-range slot indices found in the shared words
+	uint64_t RejectedSlots() const {
+		return m_Rejected;
+	}
+
+private:
+	FrameRing* m_Ring = nullptr;
+	uint32_t m_ReadSlot = FrameRing::kFirstReadSlot;
+	bool m_HasFrame = false;
+	uint64_t m_LastConsumed = 0;
+	uint64_t m_Dropped = 0;
+	uint64_t m_Rejected = 0;
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+// Single-producer/single-consumer ring of variable-length records. The struct is the
+// ring header and the record storage immediately follows it in memory, so the whole
+// thing can be placed in a file mapping shared by two processes. It does not depend on
+// any Win32 API.
+//
+// Each record is an 8-byte header (payload size and a caller-defined type) followed by
+// the payload, padded to 8 bytes. A record never wraps: when it does not fit before the
+// end of the storage, a padding record fills the tail and the record starts at offset 0.
+struct MessageRing {
+	static constexpr uint32_t kRecordHeaderSize = 8;
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "MessageRing requires address-free atomics");
+
+	// Bytes needed for the header plus `capacity` bytes of storage
+	static constexpr uint64_t RequiredSize(uint64_t capacity) {
+		return sizeof(MessageRing) + capacity;
+	}
+
+	// Largest payload a single record can carry in a ring of `capacity` bytes
+	static constexpr uint64_t MaxPayload(uint64_t capacity) {
+		return capacity - kRecordHeaderSize;
+	}
+
+	// Must be called once by whoever creates the memory. `capacity` must be a power of two
+	// and at least 64 bytes.
+	void Initialize(uint64_t capacity) {
+		m_Capacity = capacity;
+		m_Head.store(0, std::memory_order_relaxed);
+		m_Tail.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	static constexpr bool IsValidCapacity(uint64_t capacity) {
+		return capacity >= 64 && (capacity & (capacity - 1)) == 0;
+	}
+
+	uint64_t GetCapacity() const {
+		return m_Capacity;
+	}
+
+	// ---- Producer side ----
+
+	// Copies one record into the ring. Returns false if it does not fit right now.
+	bool TryWrite(uint32_t type, const void* data, uint64_t size) {
+		uint64_t need = Align(kRecordHeaderSize + size);
+		if (type == kPaddingType || need > m_Capacity) {
+			return false;
+		}
+
+		uint64_t head = m_Head.load(std::memory_order_relaxed);
+		uint64_t tail = m_Tail.load(std::memory_order_acquire);
+		uint64_t offset = head & (m_Capacity - 1);
+		uint64_t contiguous = m_Capacity - offset;
+		uint64_t total = need > contiguous ? contiguous + need : need;
+		if (head - tail + total > m_Capacity) {
+			return false;
+		}
+
+		if (need > contiguous) {
+			WriteHeader(offset, static_cast<uint32_t>(contiguous - kRecordHeaderSize), kPaddingType);
+			head += contiguous;
+			offset = 0;
+		}
+		WriteHeader(offset, static_cast<uint32_t>(size), type);
+		if (size) {
+			memcpy(Data() + offset + kRecordHeaderSize, data, static_cast<size_t>(size));
+		}
+		m_Head.store(head + need, std::memory_order_release);
+		return true;
+	}
+
+	// ---- Consumer side ----
+
+	// Calls `handler(type, data, size)` for every record currently in the ring and returns
+	// how many were delivered. `data` points into the ring and is only valid during the call.
+	template <typename Handler>
+	uint64_t Drain(Handler&& handler) {
+		return Drain(m_Capacity, handler);
+	}
+
+	// Same, with the capacity the caller created the ring with. The producer may live in
+	// another process and write anything into the shared words, so the indices and record
+	// sizes are checked against this capacity before anything is read. A record that
+	// does not fit discards the rest of the ring.
+	template <typename Handler>
+	uint64_t Drain(uint64_t capacity, Handler&& handler) {
+		uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+		uint64_t head = m_Head.load(std::memory_order_acquire);
+		uint64_t delivered = 0;
+		if (!IsValidCapacity(capacity) || head - tail > capacity) {
+			m_Tail.store(head, std::memory_order_release);
+			return 0;
+		}
+		while (tail != head) {
+			uint64_t offset = tail & (capacity - 1);
+			uint32_t header[2];
+			if (capacity - offset < kRecordHeaderSize) {
+				break;
+			}
+			memcpy(header, Data() + offset, sizeof(header));
+			if (header[0] > capacity - offset - kRecordHeaderSize || Align(kRecordHeaderSize + header[0]) > head - tail) {
+				break;
+			}
+			if (header[1] != kPaddingType) {
+				handler(header[1], static_cast<const void*>(Data() + offset + kRecordHeaderSize), static_cast<uint64_t>(header[0]));
+				++delivered;
+			}
+			tail += Align(kRecordHeaderSize + header[0]);
+			m_Tail.store(tail, std::memory_order_release);
+		}
+		if (tail != head) {
+			m_Tail.store(head, std::memory_order_release);
+		}
+		return delivered;
+	}
+
+	// ---- Either side ----
+
+	bool IsEmpty() const {
+		return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire);
+	}
+
+	uint64_t GetUsedBytes() const {
+		return m_Head.load(std::memory_order_acquire) - m_Tail.load(std::memory_order_acquire);
+	}
+
+private:
+	static constexpr uint32_t kPaddingType = 0xFFFFFFFF;
+
+	static constexpr uint64_t Align(uint64_t size) {
+		return (size + 7) & ~uint64_t(7);
+	}
+
+	uint8_t* Data() {
+		return reinterpret_cast<uint8_t*>(this + 1);
+	}
+
+	void WriteHeader(uint64_t offset, uint32_t size, uint32_t type) {
+		uint32_t header[2] = { size, type };
+		memcpy(Data() + offset, header, sizeof(header));
+	}
+
+	uint64_t m_Capacity;
+	alignas(64) std::atomic<uint64_t> m_Head; // producer-owned
+	alignas(64) std::atomic<uint64_t> m_Tail; // consumer-owned
+};
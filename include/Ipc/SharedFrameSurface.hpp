@@ -0,0 +1,328 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <source_location>
+#include <stdexcept>
+#include <windows.h>
+
+#include "FrameRing.hpp"
+#include "../Diagnostics/GuiResources.hpp"
+#include "../Diagnostics/MemoryLedger.hpp"
+
+// Cross-process 32-bit BGRA surface backed by a `CreateFileMapping` section. The section
+// holds a small header with a `FrameRing` followed by three pixel slots, and each slot is
+// exposed as a DIB section over the same memory. The renderer process writes into its
+// slot and publishes it; the process that owns the `Window` acquires the newest frame and
+// blits straight out of the shared memory, so frames are never copied between processes.
+class SharedFrameSurface {
+public:
+	// A frame slot as seen by the calling process
+	struct Frame {
+		void* pixels;
+		HDC dc;
+		UINT width;
+		UINT height;
+		UINT stride;
+		uint64_t sequence;
+	};
+
+	// Creates a new surface. `name` may be null for an anonymous section that is shared by
+	// duplicating `GetMappingHandle()` into the other process.
+	SharedFrameSurface(LPCWSTR name, UINT width, UINT height, const std::source_location& location = std::source_location::current()) : m_Location(location) {
+		if (width == 0 || height == 0) {
+			throw std::runtime_error("SharedFrameSurface requires a non-empty size.");
+		}
+		if (!IsSupportedSize(width, height)) {
+			throw std::runtime_error("SharedFrameSurface size is too large for a shared section.");
+		}
+		UINT stride = width * 4;
+		uint64_t slotBytes = static_cast<uint64_t>(stride) * height;
+		uint64_t total = kDataOffset + slotBytes * FrameRing::kSlotCount;
+
+		m_Mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, static_cast<DWORD>(total >> 32), static_cast<DWORD>(total), name);
+		if (!m_Mapping) {
+			DWORD error = GetLastError();
+			throw std::runtime_error("Failed to create shared frame mapping. Error code: " + std::to_string(error));
+		}
+		if (GetLastError() == ERROR_ALREADY_EXISTS) {
+			CloseHandle(m_Mapping);
+			throw std::runtime_error("Shared frame mapping already exists.");
+		}
+
+		MapHeader();
+		m_Header->magic = kMagic;
+		m_Header->version = kVersion;
+		m_Header->width = width;
+		m_Header->height = height;
+		m_Header->stride = stride;
+		m_Header->slotBytes = slotBytes;
+		m_Header->presentWindow.store(0, std::memory_order_relaxed);
+		m_Header->presentMessage = 0;
+		m_Header->ring.Initialize();
+		m_Width = width;
+		m_Height = height;
+		m_Stride = stride;
+		m_SlotBytes = slotBytes;
+		CreateSlots();
+	}
+
+	// Opens a surface created by another process under `name`
+	explicit SharedFrameSurface(LPCWSTR name, const std::source_location& location = std::source_location::current()) : m_Location(location) {
+		m_Mapping = OpenFileMappingW(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, name);
+		if (!m_Mapping) {
+			DWORD error = GetLastError();
+			throw std::runtime_error("Failed to open shared frame mapping. Error code: " + std::to_string(error));
+		}
+		Attach();
+	}
+
+	// Adopts a mapping handle inherited from or duplicated by the creating process. This is
+	// the usual route into sandboxed renderers that cannot open named objects.
+	explicit SharedFrameSurface(HANDLE mapping, const std::source_location& location = std::source_location::current()) : m_Location(location) {
+		if (!mapping) {
+			throw std::runtime_error("SharedFrameSurface requires a mapping handle.");
+		}
+		m_Mapping = mapping;
+		Attach();
+	}
+
+	~SharedFrameSurface() {
+		Release();
+	}
+
+	SharedFrameSurface(const SharedFrameSurface&) = delete;
+	SharedFrameSurface& operator=(const SharedFrameSurface&) = delete;
+
+	// Asks the producer to post `message` to `window` after each published frame, so the
+	// consumer can present without polling. Pass NULL to stop notifications. The surface's
+	// memory is charged to `window` from then on.
+	void SetPresentWindow(HWND window, UINT message) {
+		m_Memory.SetOwner(reinterpret_cast<uintptr_t>(window));
+		m_Header->presentMessage = message;
+		m_Header->presentWindow.store(reinterpret_cast<uint64_t>(window), std::memory_order_release);
+	}
+
+	// ---- Producer side ----
+
+	// Returns the slot to draw the next frame into
+	Frame BeginFrame() {
+		return MakeFrame(m_Producer.WriteSlot(), 0);
+	}
+
+	// Publishes the slot returned by `BeginFrame` and returns its sequence number
+	uint64_t EndFrame() {
+		GdiFlush();
+		uint64_t sequence = m_Producer.Publish();
+		uint64_t window = m_Header->presentWindow.load(std::memory_order_acquire);
+		if (window) {
+			PostMessage(reinterpret_cast<HWND>(window), m_Header->presentMessage, 0, static_cast<LPARAM>(sequence));
+		}
+		return sequence;
+	}
+
+	// ---- Consumer side ----
+
+	// Takes the newest published frame. Returns false if there is nothing newer than the
+	// frame already held.
+	bool AcquireFrame() {
+		return m_Consumer.Acquire();
+	}
+
+	// Returns the frame last acquired. `pixels` is null before the first frame arrives.
+	Frame GetFrame() {
+		uint32_t slot = m_Consumer.ReadSlot();
+		if (slot == FrameRing::kNoFrame) {
+			return Frame{ nullptr, NULL, m_Width, m_Height, m_Stride, 0 };
+		}
+		return MakeFrame(slot, m_Consumer.ReadSequence());
+	}
+
+	// Blits the frame last acquired to `target`. Returns false if no frame arrived yet.
+	bool Present(HDC target, int x, int y) {
+		uint32_t slot = m_Consumer.ReadSlot();
+		if (slot == FrameRing::kNoFrame) {
+			return false;
+		}
+		return BitBlt(target, x, y, m_Width, m_Height, SlotDC(slot), 0, 0, SRCCOPY) != 0;
+	}
+
+	uint64_t GetDroppedFrames() const {
+		return m_Consumer.DroppedFrames();
+	}
+
+	// ---- Either side ----
+
+	UINT GetWidth() const {
+		return m_Width;
+	}
+
+	UINT GetHeight() const {
+		return m_Height;
+	}
+
+	uint64_t GetPublishedSequence() const {
+		return m_Header->ring.PublishedSequence();
+	}
+
+	HANDLE GetMappingHandle() const {
+		return m_Mapping;
+	}
+
+private:
+	static constexpr uint32_t kMagic = 0x46524D53; // 'SMRF'
+	static constexpr uint32_t kVersion = 1;
+	// Keeps the pixel slots page aligned, well past the DWORD alignment CreateDIBSection needs
+	static constexpr uint64_t kDataOffset = 4096;
+	// Largest width or height, which keeps the stride well inside a UINT
+	static constexpr uint32_t kMaxDimension = 32768;
+	// `CreateDIBSection` takes the slot offset as a DWORD, so the whole section must fit one
+	static constexpr uint64_t kMaxSectionBytes = MAXDWORD;
+
+	// The one size limit, applied when creating a surface and when attaching to another
+	// process's
+	static bool IsSupportedSize(UINT width, UINT height) {
+		if (width == 0 || width > kMaxDimension || height == 0 || height > kMaxDimension) {
+			return false;
+		}
+		uint64_t slotBytes = static_cast<uint64_t>(width) * 4 * height;
+		return kDataOffset + slotBytes * FrameRing::kSlotCount <= kMaxSectionBytes;
+	}
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t stride;
+		uint32_t presentMessage;
+		uint64_t slotBytes;
+		std::atomic<uint64_t> presentWindow;
+		FrameRing ring;
+	};
+	static_assert(sizeof(Header) <= kDataOffset, "Shared frame header does not fit its page");
+
+	void MapHeader() {
+		m_Header = static_cast<Header*>(MapViewOfFile(m_Mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(kDataOffset)));
+		if (!m_Header) {
+			DWORD error = GetLastError();
+			CloseHandle(m_Mapping);
+			throw std::runtime_error("Failed to map shared frame header. Error code: " + std::to_string(error));
+		}
+	}
+
+	// The header belongs to another process, so its layout is read once and checked here.
+	// Everything after this works on the local copy.
+	void Attach() {
+		MapHeader();
+		m_Width = m_Header->width;
+		m_Height = m_Header->height;
+		m_Stride = m_Header->stride;
+		m_SlotBytes = m_Header->slotBytes;
+		bool valid = m_Header->magic == kMagic && m_Header->version == kVersion
+			&& IsSupportedSize(m_Width, m_Height)
+			&& m_Stride == m_Width * 4 && m_SlotBytes == static_cast<uint64_t>(m_Stride) * m_Height;
+		if (valid) {
+			// The section must really be as large as the header claims
+			void* whole = MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, static_cast<SIZE_T>(kDataOffset + m_SlotBytes * FrameRing::kSlotCount));
+			valid = whole != nullptr;
+			if (whole) {
+				UnmapViewOfFile(whole);
+			}
+		}
+		if (!valid) {
+			UnmapViewOfFile(m_Header);
+			m_Header = nullptr;
+			CloseHandle(m_Mapping);
+			m_Mapping = NULL;
+			throw std::runtime_error("Shared frame mapping has an unknown layout.");
+		}
+		CreateSlots();
+	}
+
+	void CreateSlots() {
+		m_Producer = FrameProducer(m_Header->ring);
+		m_Consumer = FrameConsumer(m_Header->ring);
+
+		BITMAPINFO info = {};
+		info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+		info.bmiHeader.biWidth = static_cast<LONG>(m_Width);
+		info.bmiHeader.biHeight = -static_cast<LONG>(m_Height); // top-down rows
+		info.bmiHeader.biPlanes = 1;
+		info.bmiHeader.biBitCount = 32;
+		info.bmiHeader.biCompression = BI_RGB;
+
+		for (uint32_t i = 0; i < FrameRing::kSlotCount; ++i) {
+			DWORD offset = static_cast<DWORD>(kDataOffset + m_SlotBytes * i);
+			m_Slots[i].bitmap = TrackGuiObject(CreateDIBSection(NULL, &info, DIB_RGB_COLORS, &m_Slots[i].pixels, m_Mapping, offset), GuiObjectType::Bitmap, NULL, m_Location);
+			if (!m_Slots[i].bitmap) {
+				Release();
+				throw std::runtime_error("Failed to create shared frame DIB section.");
+			}
+		}
+		m_Memory = MemoryCharge(0, MemoryCategory::Surface, kDataOffset + m_SlotBytes * FrameRing::kSlotCount);
+	}
+
+	// Memory DCs are created on first use of a slot
+	HDC SlotDC(uint32_t slot) {
+		if (slot >= FrameRing::kSlotCount) {
+			throw std::out_of_range("Shared frame slot index out of range.");
+		}
+		Slot& s = m_Slots[slot];
+		if (!s.dc) {
+			s.dc = TrackGuiObject(CreateCompatibleDC(NULL), GuiObjectType::DeviceContext, NULL, m_Location);
+			s.previous = SelectObject(s.dc, s.bitmap);
+		}
+		return s.dc;
+	}
+
+	Frame MakeFrame(uint32_t slot, uint64_t sequence) {
+		HDC dc = SlotDC(slot);
+		return Frame{ m_Slots[slot].pixels, dc, m_Width, m_Height, m_Stride, sequence };
+	}
+
+	void Release() {
+		m_Memory.Reset();
+		for (Slot& s : m_Slots) {
+			if (s.dc) {
+				SelectObject(s.dc, s.previous);
+				DeleteTrackedDC(s.dc);
+				s.dc = NULL;
+			}
+			if (s.bitmap) {
+				DeleteTrackedObject(s.bitmap);
+				s.bitmap = NULL;
+			}
+		}
+		if (m_Header) {
+			UnmapViewOfFile(m_Header);
+			m_Header = nullptr;
+		}
+		if (m_Mapping) {
+			CloseHandle(m_Mapping);
+			m_Mapping = NULL;
+		}
+	}
+
+	struct Slot {
+		HBITMAP bitmap = NULL;
+		void* pixels = nullptr;
+		HDC dc = NULL;
+		HGDIOBJ previous = NULL;
+	};
+
+	HANDLE m_Mapping = NULL;
+	Header* m_Header = nullptr;
+	// Layout as checked when the surface was created or opened
+	UINT m_Width = 0;
+	UINT m_Height = 0;
+	UINT m_Stride = 0;
+	uint64_t m_SlotBytes = 0;
+	FrameProducer m_Producer;
+	FrameConsumer m_Consumer;
+	Slot m_Slots[FrameRing::kSlotCount];
+	MemoryCharge m_Memory;
+	// Where the surface was created; its GDI objects are attributed there
+	std::source_location m_Location;
+};
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <functional>
+#include <windows.h>
+
+#include "MessageRing.hpp"
+#include "../Diagnostics/MemoryLedger.hpp"
+
+// One-way message channel into a window, possibly owned by another process. Messages are
+// copied once into a shared-memory `MessageRing` and the receiving window is woken with a
+// single posted message per batch, instead of one synchronous kernel round trip per
+// message as with `WM_COPYDATA`.
+//
+// The receiver creates the channel under a name; the sender opens it by the same name.
+// If the mapping cannot be created or opened, or a message is larger than the ring, the
+// sender falls back to `WM_COPYDATA`. The receiver drains the ring before handling a
+// `WM_COPYDATA` fallback, so messages are always delivered in the order they were sent.
+//
+// A channel has exactly one sending thread and one receiving thread. Use one channel per
+// sender when several windows feed the same receiver.
+class WindowChannel {
+public:
+	// Called with the caller-defined message type and the payload. The payload pointer is
+	// only valid during the call.
+	using Handler = std::function<void(uint32_t type, const void* data, size_t size)>;
+
+	// Receiver side: creates the channel `name` delivering to `receiver`. `capacity` is
+	// rounded up to a power of two.
+	WindowChannel(HWND receiver, LPCWSTR name, size_t capacity)
+		: m_Receiver(receiver), m_Id(HashName(name)) {
+		uint64_t ringCapacity = 64;
+		while (ringCapacity < capacity) {
+			ringCapacity <<= 1;
+		}
+		uint64_t total = sizeof(Shared) + ringCapacity;
+		m_Mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, static_cast<DWORD>(total >> 32), static_cast<DWORD>(total), name);
+		if (m_Mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+			CloseHandle(m_Mapping);
+			throw std::runtime_error("Window channel already exists.");
+		}
+		// Without a mapping the channel still works, every message just goes through WM_COPYDATA
+		if (m_Mapping && Map()) {
+			m_Shared->magic = kMagic;
+			m_Shared->wakePending.store(0, std::memory_order_relaxed);
+			m_Shared->ring.Initialize(ringCapacity);
+			m_RingCapacity = ringCapacity;
+			m_Memory = MemoryCharge(reinterpret_cast<uintptr_t>(receiver), MemoryCategory::Arena, total);
+		}
+	}
+
+	// Sender side: opens the channel `name` delivering to `receiver`
+	WindowChannel(HWND receiver, LPCWSTR name)
+		: m_Receiver(receiver), m_Id(HashName(name)) {
+		m_Mapping = OpenFileMappingW(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, name);
+		if (m_Mapping && Map() && m_Shared->magic != kMagic) {
+			Unmap();
+		}
+	}
+
+	~WindowChannel() {
+		Unmap();
+	}
+
+	WindowChannel(const WindowChannel&) = delete;
+	WindowChannel& operator=(const WindowChannel&) = delete;
+
+	// Message posted to the receiving window when the ring goes from idle to non-empty.
+	// `wParam` carries the channel id.
+	static UINT GetWakeMessage() {
+		static const UINT message = RegisterWindowMessageW(L"wincpp.WindowChannel.Wake");
+		return message;
+	}
+
+	// True when messages travel through shared memory rather than `WM_COPYDATA`
+	bool IsShared() const {
+		return m_Shared != nullptr;
+	}
+
+	// ---- Sender side ----
+
+	// Sends one message. Returns false only if the fallback `WM_COPYDATA` was refused.
+	bool Send(uint32_t type, const void* data, size_t size) {
+		if (m_Shared && m_Shared->ring.TryWrite(type, data, size)) {
+			if (!m_Shared->wakePending.exchange(1, std::memory_order_acq_rel)) {
+				PostMessage(m_Receiver, GetWakeMessage(), static_cast<WPARAM>(m_Id), 0);
+			}
+			++m_SharedSends;
+			return true;
+		}
+		++m_CopyDataSends;
+		return SendCopyData(type, data, size);
+	}
+
+	uint64_t GetSharedSendCount() const {
+		return m_SharedSends;
+	}
+
+	uint64_t GetCopyDataSendCount() const {
+		return m_CopyDataSends;
+	}
+
+	// ---- Receiver side ----
+
+	// Delivers everything currently in the ring and returns the number of messages
+	size_t Drain(const Handler& handler) {
+		if (!m_Shared) {
+			return 0;
+		}
+		// The flag must be clear before the head is read, or a message written in between
+		// could find the flag still set, skip the wake, and never be drained. A plain store
+		// may become visible after the head load; the exchange reads the sender's flag, so
+		// a sender that saw it set has its head update ordered before the load below.
+		m_Shared->wakePending.exchange(0, std::memory_order_seq_cst);
+		return static_cast<size_t>(m_Shared->ring.Drain(m_RingCapacity, [&](uint32_t type, const void* data, uint64_t size) {
+			handler(type, data, static_cast<size_t>(size));
+		}));
+	}
+
+	// Call from the receiving window procedure. Returns true if the message belonged to
+	// this channel and was handled; the procedure should then return TRUE.
+	bool HandleMessage(UINT message, WPARAM wParam, LPARAM lParam, const Handler& handler) {
+		if (message == GetWakeMessage() && static_cast<uint32_t>(wParam) == m_Id) {
+			Drain(handler);
+			return true;
+		}
+		if (message == WM_COPYDATA) {
+			const COPYDATASTRUCT* copy = reinterpret_cast<const COPYDATASTRUCT*>(lParam);
+			if (!copy || copy->dwData != kCopyDataTag || copy->cbData < sizeof(CopyDataHeader)) {
+				return false;
+			}
+			CopyDataHeader header;
+			memcpy(&header, copy->lpData, sizeof(header));
+			if (header.channel != m_Id) {
+				return false;
+			}
+			Drain(handler);
+			handler(header.type, static_cast<const uint8_t*>(copy->lpData) + sizeof(header), copy->cbData - sizeof(header));
+			return true;
+		}
+		return false;
+	}
+
+private:
+	static constexpr uint32_t kMagic = 0x4E484357; // 'WCHN'
+	static constexpr ULONG_PTR kCopyDataTag = 0x4E484357;
+
+	struct Shared {
+		uint32_t magic;
+		alignas(64) std::atomic<uint32_t> wakePending;
+		MessageRing ring; // storage follows
+	};
+
+	struct CopyDataHeader {
+		uint32_t channel;
+		uint32_t type;
+	};
+
+	// FNV-1a, so both ends derive the same id from the channel name
+	static uint32_t HashName(LPCWSTR name) {
+		uint32_t hash = 2166136261u;
+		for (; name && *name; ++name) {
+			hash = (hash ^ static_cast<uint32_t>(*name)) * 16777619u;
+		}
+		return hash;
+	}
+
+	bool Map() {
+		m_Shared = static_cast<Shared*>(MapViewOfFile(m_Mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0));
+		if (!m_Shared) {
+			CloseHandle(m_Mapping);
+			m_Mapping = NULL;
+			return false;
+		}
+		return true;
+	}
+
+	void Unmap() {
+		m_Memory.Reset();
+		if (m_Shared) {
+			UnmapViewOfFile(m_Shared);
+			m_Shared = nullptr;
+		}
+		if (m_Mapping) {
+			CloseHandle(m_Mapping);
+			m_Mapping = NULL;
+		}
+	}
+
+	bool SendCopyData(uint32_t type, const void* data, size_t size) {
+		m_CopyBuffer.resize(sizeof(CopyDataHeader) + size);
+		CopyDataHeader header = { m_Id, type };
+		memcpy(m_CopyBuffer.data(), &header, sizeof(header));
+		if (size) {
+			memcpy(m_CopyBuffer.data() + sizeof(header), data, size);
+		}
+		COPYDATASTRUCT copy = {};
+		copy.dwData = kCopyDataTag;
+		copy.cbData = static_cast<DWORD>(m_CopyBuffer.size());
+		copy.lpData = m_CopyBuffer.data();
+		return SendMessage(m_Receiver, WM_COPYDATA, 0, reinterpret_cast<LPARAM>(&copy)) != 0;
+	}
+
+	HWND m_Receiver;
+	uint32_t m_Id;
+	HANDLE m_Mapping = NULL;
+	Shared* m_Shared = nullptr;
+	// Ring size this side created, never read back from the shared header
+	uint64_t m_RingCapacity = 0;
+	std::vector<uint8_t> m_CopyBuffer;
+	MemoryCharge m_Memory;
+	uint64_t m_SharedSends = 0;
+	uint64_t m_CopyDataSends = 0;
+};
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <functional>
+#include <windows.h>
+
+#include "RunLoop.hpp"
+#include "CompletionQueue.hpp"
+
+// I/O completion port serviced on behalf of a `RunLoop`. A pump thread blocks in
+// `GetQueuedCompletionStatus`, queues finished operations and signals an event the loop
+// waits on, so completion callbacks always run on the UI thread between messages and
+// handlers never block in `ReadFile`/`WriteFile`.
+//
+// Close every `AsyncFile` before destroying the `AsyncIo` it was opened with. Operations
+// still in flight at that point are cancelled and discarded without running their
+// callbacks; the destructor waits for the kernel to hand each one back first.
+class AsyncIo {
+public:
+	// An overlapped operation. The OVERLAPPED must stay the first member, the pump casts
+	// the pointer it gets back from the port.
+	struct Operation {
+		OVERLAPPED overlapped = {};
+		std::vector<uint8_t> buffer;
+		std::function<void(DWORD error, const uint8_t* data, DWORD bytes)> callback;
+		DWORD error = ERROR_SUCCESS;
+		DWORD bytes = 0;
+		// File the operation runs on, cleared when the file is closed
+		HANDLE file = NULL;
+		Operation* previous = nullptr;
+		Operation* next = nullptr;
+	};
+
+	explicit AsyncIo(RunLoop& loop) : m_Loop(loop) {
+		m_Port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+		if (!m_Port) {
+			DWORD error = GetLastError();
+			throw std::runtime_error("Failed to create I/O completion port. Error code: " + std::to_string(error));
+		}
+		m_Ready = CreateEventW(NULL, FALSE, FALSE, NULL);
+		if (!m_Ready) {
+			CloseHandle(m_Port);
+			throw std::runtime_error("Failed to create I/O completion event.");
+		}
+		m_Loop.AddWaitHandle(m_Ready, [this] { DispatchCompletions(); });
+		m_Pump = std::thread([this] { PumpCompletions(); });
+	}
+
+	~AsyncIo() {
+		PostQueuedCompletionStatus(m_Port, 0, kStopKey, NULL);
+		m_Pump.join();
+		m_Loop.RemoveWaitHandle(m_Ready);
+		m_Queue.DiscardCompleted();
+		ReapInFlight();
+		CloseHandle(m_Ready);
+		CloseHandle(m_Port);
+	}
+
+	AsyncIo(const AsyncIo&) = delete;
+	AsyncIo& operator=(const AsyncIo&) = delete;
+
+	// Operations whose callbacks have not run yet
+	size_t GetPendingCount() const {
+		return m_Queue.GetPendingCount();
+	}
+
+private:
+	friend class AsyncFile;
+
+	// Binds an overlapped file handle to the port
+	void Associate(HANDLE file) {
+		if (!CreateIoCompletionPort(file, m_Port, kFileKey, 0)) {
+			DWORD error = GetLastError();
+			throw std::runtime_error("Failed to associate handle with I/O completion port. Error code: " + std::to_string(error));
+		}
+	}
+
+	// Completes `operation` with `error` through the port, for calls that failed before
+	// any I/O was started. Keeps callbacks asynchronous even on immediate failure.
+	void Fail(Operation* operation, DWORD error) {
+		operation->error = error;
+		PostQueuedCompletionStatus(m_Port, 0, kFailedKey, &operation->overlapped);
+	}
+
+	// Records an operation that will come back through the port
+	void OnStarted(Operation* operation) {
+		m_Queue.Start(operation);
+	}
+
+	// Forgets `file` in its pending operations; the handle value may be reused once closed
+	void OnClosing(HANDLE file) {
+		m_Queue.ForEachInFlight([file](Operation* operation) {
+			if (operation->file == file) {
+				operation->file = NULL;
+			}
+		});
+	}
+
+	static constexpr ULONG_PTR kFileKey = 1;
+	static constexpr ULONG_PTR kFailedKey = 2;
+	static constexpr ULONG_PTR kStopKey = 3;
+	// How long the destructor waits for cancelled operations to come back
+	static constexpr DWORD kShutdownTimeout = 5000;
+
+	void PumpCompletions() {
+		for (;;) {
+			DWORD bytes = 0;
+			ULONG_PTR key = 0;
+			LPOVERLAPPED overlapped = nullptr;
+			BOOL ok = GetQueuedCompletionStatus(m_Port, &bytes, &key, &overlapped, INFINITE);
+			if (key == kStopKey) {
+				return;
+			}
+			if (!overlapped) {
+				continue;
+			}
+			Operation* operation = reinterpret_cast<Operation*>(overlapped);
+			if (key != kFailedKey) {
+				operation->error = ok ? ERROR_SUCCESS : GetLastError();
+				operation->bytes = bytes;
+			}
+			if (m_Queue.Complete(operation)) {
+				SetEvent(m_Ready);
+			}
+		}
+	}
+
+	// Runs on the loop thread
+	void DispatchCompletions() {
+		m_Queue.Dispatch([](Operation* operation) {
+			if (operation->callback) {
+				operation->callback(operation->error, operation->buffer.data(), operation->bytes);
+			}
+		});
+	}
+
+	// Cancels what the kernel still holds and takes each operation back from the port
+	// before freeing it, as the kernel writes to the OVERLAPPED and buffer until then.
+	// Anything not back within the timeout is leaked rather than freed under the kernel.
+	void ReapInFlight() {
+		m_Queue.ForEachInFlight([](Operation* operation) {
+			if (operation->file) {
+				CancelIoEx(operation->file, &operation->overlapped);
+			}
+		});
+		ULONGLONG deadline = GetTickCount64() + kShutdownTimeout;
+		while (m_Queue.HasInFlight()) {
+			ULONGLONG now = GetTickCount64();
+			if (now >= deadline) {
+				break;
+			}
+			DWORD bytes = 0;
+			ULONG_PTR key = 0;
+			LPOVERLAPPED overlapped = nullptr;
+			GetQueuedCompletionStatus(m_Port, &bytes, &key, &overlapped, static_cast<DWORD>(deadline - now));
+			if (overlapped) {
+				m_Queue.Reap(reinterpret_cast<Operation*>(overlapped));
+			}
+		}
+	}
+
+	RunLoop& m_Loop;
+	HANDLE m_Port = NULL;
+	HANDLE m_Ready = NULL;
+	std::thread m_Pump;
+	CompletionQueue<Operation> m_Queue;
+};
+
+// File opened for overlapped I/O through an `AsyncIo`. Reads and writes return at once;
+// their callbacks run later on the loop thread with a Win32 error code (`ERROR_SUCCESS`,
+// `ERROR_HANDLE_EOF`, `ERROR_OPERATION_ABORTED`, ...).
+class AsyncFile {
+public:
+	using ReadCallback = std::function<void(DWORD error, const uint8_t* data, DWORD bytes)>;
+	using WriteCallback = std::function<void(DWORD error, DWORD bytes)>;
+
+	AsyncFile(AsyncIo& io, LPCWSTR path, DWORD access = GENERIC_READ, DWORD share = FILE_SHARE_READ, DWORD disposition = OPEN_EXISTING)
+		: m_Io(io) {
+		m_File = CreateFileW(path, access, share, NULL, disposition, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, NULL);
+		if (m_File == INVALID_HANDLE_VALUE) {
+			DWORD error = GetLastError();
+			throw std::runtime_error("Failed to open file for async I/O. Error code: " + std::to_string(error));
+		}
+		try {
+			m_Io.Associate(m_File);
+		}
+		catch (...) {
+			CloseHandle(m_File);
+			throw;
+		}
+	}
+
+	// Cancels outstanding operations; their callbacks still run with ERROR_OPERATION_ABORTED
+	~AsyncFile() {
+		CancelIoEx(m_File, NULL);
+		m_Io.OnClosing(m_File);
+		CloseHandle(m_File);
+	}
+
+	AsyncFile(const AsyncFile&) = delete;
+	AsyncFile& operator=(const AsyncFile&) = delete;
+
+	// Reads up to `size` bytes at `offset`. The data passed to `callback` is only valid
+	// during the call.
+	void Read(uint64_t offset, DWORD size, ReadCallback callback) {
+		AsyncIo::Operation* operation = Start(offset);
+		operation->buffer.resize(size);
+		operation->callback = std::move(callback);
+		if (!ReadFile(m_File, operation->buffer.data(), size, NULL, &operation->overlapped)) {
+			Check(operation);
+		}
+	}
+
+	// Writes a copy of `data` at `offset`
+	void Write(uint64_t offset, const void* data, DWORD size, WriteCallback callback) {
+		AsyncIo::Operation* operation = Start(offset);
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		operation->buffer.assign(bytes, bytes + size);
+		if (callback) {
+			operation->callback = [callback = std::move(callback)](DWORD error, const uint8_t*, DWORD written) {
+				callback(error, written);
+			};
+		}
+		if (!WriteFile(m_File, operation->buffer.data(), size, NULL, &operation->overlapped)) {
+			Check(operation);
+		}
+	}
+
+	HANDLE GetHandle() const {
+		return m_File;
+	}
+
+private:
+	AsyncIo::Operation* Start(uint64_t offset) {
+		AsyncIo::Operation* operation = new AsyncIo::Operation();
+		operation->overlapped.Offset = static_cast<DWORD>(offset);
+		operation->overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		operation->file = m_File;
+		m_Io.OnStarted(operation);
+		return operation;
+	}
+
+	// A call that returned FALSE either went pending or failed outright
+	void Check(AsyncIo::Operation* operation) {
+		DWORD error = GetLastError();
+		if (error != ERROR_IO_PENDING) {
+			m_Io.Fail(operation, error);
+		}
+	}
+
+	AsyncIo& m_Io;
+	HANDLE m_File = INVALID_HANDLE_VALUE;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stddef.h>
+#include <mutex>
+#include <vector>
+
+// Bookkeeping between a thread that collects finished I/O and the loop thread that runs
+// the callbacks. Every started operation is linked into an in-flight list until its
+// callback ran, so the owner can cancel and reap whatever is still with the kernel when
+// it shuts down instead of freeing memory the kernel may still write to.
+//
+// `Operation` needs `Operation* previous` and `Operation* next` members and is created
+// with `new`; the queue deletes it. Platform independent; `AsyncIo` drives it with an
+// I/O completion port.
+template <typename Operation>
+class CompletionQueue {
+public:
+	CompletionQueue() = default;
+
+	~CompletionQueue() {
+		DiscardCompleted();
+	}
+
+	CompletionQueue(const CompletionQueue&) = delete;
+	CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+	// ---- Loop thread ----
+
+	// Records an operation about to be handed to the kernel
+	void Start(Operation* operation) {
+		operation->previous = nullptr;
+		operation->next = m_InFlight;
+		if (m_InFlight) {
+			m_InFlight->previous = operation;
+		}
+		m_InFlight = operation;
+		++m_Pending;
+	}
+
+	// Runs `complete(operation)` for every finished operation, then deletes it. Returns
+	// how many ran.
+	template <typename Complete>
+	size_t Dispatch(Complete&& complete) {
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Dispatching.swap(m_Completed);
+		}
+		size_t count = m_Dispatching.size();
+		for (Operation* operation : m_Dispatching) {
+			Unlink(operation);
+			complete(operation);
+			delete operation;
+		}
+		m_Dispatching.clear();
+		return count;
+	}
+
+	// Operations whose callbacks have not run yet
+	size_t GetPendingCount() const {
+		return m_Pending;
+	}
+
+	// ---- Completion thread ----
+
+	// Queues a finished operation. Returns true if the queue was empty, meaning the loop
+	// thread must be woken; later completions ride along with that wakeup.
+	bool Complete(Operation* operation) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Completed.push_back(operation);
+		return m_Completed.size() == 1;
+	}
+
+	// ---- Shutdown, once the completion thread has stopped ----
+
+	// Deletes finished operations without running their callbacks
+	void DiscardCompleted() {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (Operation* operation : m_Completed) {
+			Unlink(operation);
+			delete operation;
+		}
+		m_Completed.clear();
+	}
+
+	// Calls `visit(operation)` for every operation not yet dispatched, e.g. to cancel it.
+	// After `DiscardCompleted` these are exactly the operations still with the kernel.
+	template <typename Visit>
+	void ForEachInFlight(Visit&& visit) {
+		for (Operation* operation = m_InFlight; operation;) {
+			Operation* next = operation->next;
+			visit(operation);
+			operation = next;
+		}
+	}
+
+	// Deletes an operation the kernel handed back during shutdown
+	void Reap(Operation* operation) {
+		Unlink(operation);
+		delete operation;
+	}
+
+	bool HasInFlight() const {
+		return m_InFlight != nullptr;
+	}
+
+private:
+	void Unlink(Operation* operation) {
+		if (operation->previous) {
+			operation->previous->next = operation->next;
+		}
+		else {
+			m_InFlight = operation->next;
+		}
+		if (operation->next) {
+			operation->next->previous = operation->previous;
+		}
+		operation->previous = nullptr;
+		operation->next = nullptr;
+		--m_Pending;
+	}
+
+	std::mutex m_Mutex;
+	std::vector<Operation*> m_Completed;
+	std::vector<Operation*> m_Dispatching;
+	Operation* m_InFlight = nullptr;
+	size_t m_Pending = 0;
+};
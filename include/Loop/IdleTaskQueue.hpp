@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <windows.h>
+
+#include "RunLoop.hpp"
+
+// Time a single idle period grants, passed to every idle task. Tasks doing incremental
+// work should check `ShouldYield` between steps and post a continuation when it is true.
+class IdleDeadline {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit IdleDeadline(Clock::time_point deadline) : m_Deadline(deadline) {}
+
+	std::chrono::microseconds TimeRemaining() const {
+		auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(m_Deadline - Clock::now());
+		return remaining.count() > 0 ? remaining : std::chrono::microseconds(0);
+	}
+
+	// True once the deadline passed or input is waiting in the queue
+	bool ShouldYield() const {
+		return Clock::now() >= m_Deadline || HIWORD(GetQueueStatus(QS_INPUT)) != 0;
+	}
+
+private:
+	Clock::time_point m_Deadline;
+};
+
+// Deferred work (cache warming, prefetch, cache trimming) that only runs when the UI
+// thread has nothing else to do, in the spirit of `requestIdleCallback`. Tasks run in
+// FIFO order while the `RunLoop`'s queue is empty, each idle period is capped by the
+// loop's idle budget and the next frame, and the queue stops as soon as input arrives.
+class IdleTaskQueue {
+public:
+	using Clock = std::chrono::steady_clock;
+	using Task = std::function<void(const IdleDeadline& deadline)>;
+
+	struct Stats {
+		uint64_t tasksRun = 0;
+		uint64_t idlePeriods = 0;
+		// Idle periods that ended with tasks still queued
+		uint64_t yields = 0;
+		// Time spent inside idle tasks
+		Clock::duration timeUsed = Clock::duration::zero();
+		// Time idle periods made available, used or not
+		Clock::duration timeOffered = Clock::duration::zero();
+	};
+
+	explicit IdleTaskQueue(RunLoop& loop, std::chrono::microseconds maxBudget = std::chrono::milliseconds(50)) : m_Loop(loop) {
+		m_Loop.SetIdleHandler([this](Clock::time_point deadline) { return RunTasks(deadline); }, maxBudget);
+	}
+
+	~IdleTaskQueue() {
+		m_Loop.ClearIdleHandler();
+	}
+
+	IdleTaskQueue(const IdleTaskQueue&) = delete;
+	IdleTaskQueue& operator=(const IdleTaskQueue&) = delete;
+
+	// Queues `task` for the next idle period. Safe to call from inside a running task.
+	void Post(Task task) {
+		m_Tasks.push_back(std::move(task));
+	}
+
+	size_t GetPendingCount() const {
+		return m_Tasks.size();
+	}
+
+	const Stats& GetStats() const {
+		return m_Stats;
+	}
+
+	void ResetStats() {
+		m_Stats = Stats();
+	}
+
+private:
+	bool RunTasks(Clock::time_point deadline) {
+		if (m_Tasks.empty()) {
+			return false;
+		}
+		Clock::time_point start = Clock::now();
+		IdleDeadline idle(deadline);
+		++m_Stats.idlePeriods;
+		m_Stats.timeOffered += deadline - start;
+
+		while (!m_Tasks.empty() && !idle.ShouldYield()) {
+			Task task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+			task(idle);
+			++m_Stats.tasksRun;
+		}
+
+		m_Stats.timeUsed += Clock::now() - start;
+		if (!m_Tasks.empty()) {
+			++m_Stats.yields;
+			return true;
+		}
+		return false;
+	}
+
+	RunLoop& m_Loop;
+	std::deque<Task> m_Tasks;
+	Stats m_Stats;
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+
+// Priority lanes for work on the UI thread, highest first
+enum class TaskLane : uint8_t {
+	Input,
+	Animation,
+	Normal,
+	Idle,
+};
+
+// Queueing delay observed by the tasks of one lane
+struct LaneLatency {
+	uint64_t count = 0;
+	std::chrono::steady_clock::duration total = std::chrono::steady_clock::duration::zero();
+	std::chrono::steady_clock::duration max = std::chrono::steady_clock::duration::zero();
+
+	std::chrono::steady_clock::duration Average() const {
+		return count ? total / static_cast<int64_t>(count) : std::chrono::steady_clock::duration::zero();
+	}
+};
+
+// Scheduling policy for UI-thread tasks, independent of any message loop so it can be
+// driven by a simulated clock. Lanes are drained in priority order, each up to its own
+// time budget per frame; the idle lane only runs once every other lane is empty. The
+// budgets belong to the frame, not to the call: `Run` may be called any number of times
+// per frame and each call only spends what the frame has left. A frame starts with
+// `BeginFrame`, or on its own once `frameInterval` has passed since the last one.
+//
+// A task that has waited longer than its lane's starvation threshold is run at the start
+// of the next frame regardless of budgets, so a busy high-priority lane delays lower lanes
+// but cannot starve them.
+class LaneScheduler {
+public:
+	using Clock = std::chrono::steady_clock;
+	using Task = std::function<void()>;
+	using NowFunction = std::function<Clock::time_point()>;
+
+	static constexpr size_t kLaneCount = 4;
+
+	struct Config {
+		// Time each lane may use per frame
+		Clock::duration budget[kLaneCount] = {
+			std::chrono::milliseconds(8),
+			std::chrono::milliseconds(4),
+			std::chrono::milliseconds(4),
+			std::chrono::milliseconds(2),
+		};
+		// Queueing delay after which a task is promoted past budgets (unused for input)
+		Clock::duration starvation[kLaneCount] = {
+			std::chrono::milliseconds(0),
+			std::chrono::milliseconds(100),
+			std::chrono::milliseconds(250),
+			std::chrono::milliseconds(1000),
+		};
+		// Frame length used when nobody calls `BeginFrame`
+		Clock::duration frameInterval = std::chrono::microseconds(16667);
+	};
+
+	explicit LaneScheduler(NowFunction now = [] { return Clock::now(); }) : m_Now(std::move(now)) {}
+
+	LaneScheduler(const Config& config, NowFunction now = [] { return Clock::now(); })
+		: m_Config(config), m_Now(std::move(now)) {}
+
+	void Post(TaskLane lane, Task task) {
+		m_Lanes[Index(lane)].push_back({ std::move(task), m_Now() });
+	}
+
+	// Starts a new frame: refills every lane's budget and lets starved tasks run
+	void BeginFrame() {
+		m_FrameStart = m_Now();
+		m_FrameStarted = true;
+		m_PromotionDue = true;
+		for (Clock::duration& spent : m_Spent) {
+			spent = Clock::duration::zero();
+		}
+		++m_Frames;
+	}
+
+	// Runs tasks until the current frame's budgets are spent or the lanes are empty.
+	// `shouldYield` is checked before every task and stops the call when it returns true
+	// (typically: input is waiting). Returns true if tasks remain.
+	template <typename ShouldYield>
+	bool Run(ShouldYield&& shouldYield) {
+		if (!m_FrameStarted || m_Now() - m_FrameStart >= m_Config.frameInterval) {
+			BeginFrame();
+		}
+
+		// Starved tasks first, at most one per lane; the input lane always runs first anyway
+		if (m_PromotionDue) {
+			for (size_t lane = 1; lane < kLaneCount; ++lane) {
+				if (!m_Lanes[lane].empty() && m_Now() - m_Lanes[lane].front().posted >= m_Config.starvation[lane]) {
+					if (shouldYield()) {
+						return HasPending();
+					}
+					RunFront(lane);
+					++m_Promotions;
+				}
+			}
+			m_PromotionDue = false;
+		}
+
+		for (size_t lane = 0; lane < kLaneCount; ++lane) {
+			if (lane == Index(TaskLane::Idle) && !HigherLanesEmpty(lane)) {
+				break;
+			}
+			while (!m_Lanes[lane].empty() && m_Spent[lane] < m_Config.budget[lane]) {
+				if (shouldYield()) {
+					return HasPending();
+				}
+				RunFront(lane);
+			}
+		}
+		return HasPending();
+	}
+
+	// When `Run` next has something to do: now while a lane with tasks has budget left,
+	// the start of the next frame once all of them have spent theirs, and
+	// `time_point::max()` when nothing is queued
+	Clock::time_point GetNextRunTime() const {
+		if (!HasPending()) {
+			return Clock::time_point::max();
+		}
+		Clock::time_point now = m_Now();
+		if (!m_FrameStarted) {
+			return now;
+		}
+		for (size_t lane = 0; lane < kLaneCount; ++lane) {
+			if (lane == Index(TaskLane::Idle) && !HigherLanesEmpty(lane)) {
+				break;
+			}
+			if (!m_Lanes[lane].empty() && m_Spent[lane] < m_Config.budget[lane]) {
+				return now;
+			}
+		}
+		return m_FrameStart + m_Config.frameInterval;
+	}
+
+	// Time the lane has used in the current frame
+	Clock::duration GetSpent(TaskLane lane) const {
+		return m_Spent[Index(lane)];
+	}
+
+	bool HasPending() const {
+		for (const auto& lane : m_Lanes) {
+			if (!lane.empty()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	size_t GetPendingCount(TaskLane lane) const {
+		return m_Lanes[Index(lane)].size();
+	}
+
+	const LaneLatency& GetLatency(TaskLane lane) const {
+		return m_Latency[Index(lane)];
+	}
+
+	// Tasks run ahead of budgets because they waited past the starvation threshold
+	uint64_t GetPromotionCount() const {
+		return m_Promotions;
+	}
+
+	uint64_t GetFrameCount() const {
+		return m_Frames;
+	}
+
+	void ResetStats() {
+		for (LaneLatency& latency : m_Latency) {
+			latency = LaneLatency();
+		}
+		m_Promotions = 0;
+		m_Frames = 0;
+	}
+
+	Config& GetConfig() {
+		return m_Config;
+	}
+
+private:
+	struct Entry {
+		Task task;
+		Clock::time_point posted;
+	};
+
+	static size_t Index(TaskLane lane) {
+		return static_cast<size_t>(lane);
+	}
+
+	bool HigherLanesEmpty(size_t lane) const {
+		for (size_t i = 0; i < lane; ++i) {
+			if (!m_Lanes[i].empty()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void RunFront(size_t lane) {
+		Entry entry = std::move(m_Lanes[lane].front());
+		m_Lanes[lane].pop_front();
+
+		Clock::duration waited = m_Now() - entry.posted;
+		LaneLatency& latency = m_Latency[lane];
+		++latency.count;
+		latency.total += waited;
+		if (waited > latency.max) {
+			latency.max = waited;
+		}
+		Clock::time_point start = m_Now();
+		entry.task();
+		m_Spent[lane] += m_Now() - start;
+	}
+
+	Config m_Config;
+	NowFunction m_Now;
+	std::deque<Entry> m_Lanes[kLaneCount];
+	LaneLatency m_Latency[kLaneCount];
+	Clock::duration m_Spent[kLaneCount] = {};
+	Clock::time_point m_FrameStart;
+	bool m_FrameStarted = false;
+	bool m_PromotionDue = false;
+	uint64_t m_Promotions = 0;
+	uint64_t m_Frames = 0;
+};
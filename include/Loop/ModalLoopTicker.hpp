@@ -0,0 +1,217 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+#include <functional>
+#include <windows.h>
+
+#include "RunLoop.hpp"
+
+// Keeps a `RunLoop`'s frame handler ticking while `DefWindowProc` runs its modal
+// move/size loop, during which `RunLoop::Run` (and `Window::RunDefaultMessageLoop`) do
+// not get control back. Between `WM_ENTERSIZEMOVE` and `WM_EXITSIZEMOVE` a helper thread
+// waits on a high-resolution waitable timer and posts a tick message to the window; the
+// modal loop dispatches it like any other message and the ticker runs the frame when the
+// loop itself would (`RunLoop::IsContinuous`). Ticks follow the loop's frame throttle:
+// every `divisor` intervals, and only a slow poll while throttling pauses frames.
+//
+// Relayout can be throttled during live resize: `WM_SIZE` is forwarded to the relayout
+// handler at most once per relayout interval while dragging, and the final size is
+// always delivered when the drag ends.
+class ModalLoopTicker {
+public:
+	using RelayoutHandler = std::function<void(int width, int height)>;
+	using Clock = std::chrono::steady_clock;
+
+	// How often a drag checks whether paused frames have resumed
+	static constexpr std::chrono::milliseconds kPausedPollInterval{ 100 };
+
+	ModalLoopTicker(RunLoop& loop, HWND window) : m_Loop(loop), m_Window(window) {}
+
+	~ModalLoopTicker() {
+		if (m_Thread.joinable()) {
+			m_Stopping.store(true, std::memory_order_release);
+			SetEvent(m_Stop);
+			m_Thread.join();
+		}
+		if (m_Timer) {
+			CloseHandle(m_Timer);
+		}
+		if (m_Stop) {
+			CloseHandle(m_Stop);
+		}
+	}
+
+	ModalLoopTicker(const ModalLoopTicker&) = delete;
+	ModalLoopTicker& operator=(const ModalLoopTicker&) = delete;
+
+	// Handler for `WM_SIZE`, throttled to once per `interval` during live resize
+	void SetRelayoutHandler(RelayoutHandler handler, std::chrono::milliseconds interval = std::chrono::milliseconds(50)) {
+		m_Relayout = std::move(handler);
+		m_RelayoutInterval = interval;
+	}
+
+	// Message posted to the window for each tick
+	static UINT GetTickMessage() {
+		static const UINT message = RegisterWindowMessageW(L"wincpp.ModalLoopTicker.Tick");
+		return message;
+	}
+
+	// Call from the window procedure for every message. Returns true if the message was
+	// a tick and has been handled.
+	bool HandleMessage(UINT message, WPARAM, LPARAM lParam) {
+		if (message == GetTickMessage()) {
+			m_TickPending.store(false, std::memory_order_release);
+			if (m_InModalLoop) {
+				if (m_Loop.IsContinuous()) {
+					m_Loop.TickFrame();
+					++m_ModalFrames;
+				}
+				FlushRelayout(false);
+				Arm();
+			}
+			return true;
+		}
+		switch (message) {
+		case WM_ENTERSIZEMOVE:
+			EnterModalLoop();
+			break;
+		case WM_EXITSIZEMOVE:
+			ExitModalLoop();
+			break;
+		case WM_SIZE:
+			if (m_Relayout) {
+				// A size that was never laid out is superseded by this one
+				if (m_RelayoutPending) {
+					++m_RelayoutsSkipped;
+				}
+				m_PendingWidth = LOWORD(lParam);
+				m_PendingHeight = HIWORD(lParam);
+				m_RelayoutPending = true;
+				FlushRelayout(!m_InModalLoop);
+			}
+			break;
+		}
+		return false;
+	}
+
+	bool IsInModalLoop() const {
+		return m_InModalLoop;
+	}
+
+	// Frame rate of the drag in progress, or of the last one when none is in progress
+	double GetDragFrameRate() const {
+		if (!m_InModalLoop) {
+			return m_LastDragFrameRate;
+		}
+		double seconds = std::chrono::duration<double>(Clock::now() - m_DragStart).count();
+		return seconds > 0 ? m_ModalFrames / seconds : 0.0;
+	}
+
+	// Relayouts skipped by throttling over the lifetime of the ticker
+	uint64_t GetRelayoutsSkipped() const {
+		return m_RelayoutsSkipped;
+	}
+
+private:
+	void EnterModalLoop() {
+		if (!m_Loop.HasFrameHandler()) {
+			return;
+		}
+		if (!m_Thread.joinable()) {
+			StartThread();
+		}
+		m_InModalLoop = true;
+		m_ModalFrames = 0;
+		m_DragStart = Clock::now();
+		Arm();
+	}
+
+	void ExitModalLoop() {
+		if (!m_InModalLoop) {
+			return;
+		}
+		m_InModalLoop = false;
+		CancelWaitableTimer(m_Timer);
+		m_LastDragFrameRate = 0.0;
+		double seconds = std::chrono::duration<double>(Clock::now() - m_DragStart).count();
+		if (seconds > 0) {
+			m_LastDragFrameRate = m_ModalFrames / seconds;
+		}
+		FlushRelayout(true);
+	}
+
+	void FlushRelayout(bool force) {
+		if (!m_RelayoutPending) {
+			return;
+		}
+		Clock::time_point now = Clock::now();
+		if (!force && now - m_LastRelayout < m_RelayoutInterval) {
+			return;
+		}
+		m_RelayoutPending = false;
+		m_LastRelayout = now;
+		m_Relayout(m_PendingWidth, m_PendingHeight);
+	}
+
+	void StartThread() {
+		// High resolution timers need Windows 10 1803; older systems get a regular one
+		m_Timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (!m_Timer) {
+			m_Timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+		}
+		m_Stop = CreateEventW(NULL, FALSE, FALSE, NULL);
+		if (!m_Timer || !m_Stop) {
+			throw std::runtime_error("Failed to create modal loop timer.");
+		}
+		m_Thread = std::thread([this] { TimerLoop(); });
+	}
+
+	// Arms the timer for the next frame after throttling; relative due times are in 100 ns
+	// units. Loop thread only, so the timer thread never reads the loop's state.
+	void Arm() {
+		uint32_t divisor = m_Loop.GetFrameDivisor();
+		std::chrono::microseconds delay = divisor != 0 ? m_Loop.GetFrameInterval() * divisor : std::chrono::microseconds(kPausedPollInterval);
+		LARGE_INTEGER due = {};
+		due.QuadPart = -static_cast<LONGLONG>(delay.count()) * 10;
+		SetWaitableTimer(m_Timer, &due, 0, NULL, NULL, FALSE);
+	}
+
+	void TimerLoop() {
+		HANDLE handles[2] = { m_Stop, m_Timer };
+		while (!m_Stopping.load(std::memory_order_acquire)) {
+			if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) {
+				continue;
+			}
+			// One tick in flight at a time, a slow frame must not queue up a backlog; the
+			// tick re-arms the timer once handled
+			if (!m_TickPending.exchange(true, std::memory_order_acq_rel)) {
+				PostMessage(m_Window, GetTickMessage(), 0, 0);
+			}
+		}
+	}
+
+	RunLoop& m_Loop;
+	HWND m_Window;
+	HANDLE m_Timer = NULL;
+	HANDLE m_Stop = NULL;
+	std::thread m_Thread;
+	std::atomic<bool> m_Stopping{ false };
+	std::atomic<bool> m_TickPending{ false };
+	std::atomic<bool> m_InModalLoop{ false };
+
+	RelayoutHandler m_Relayout;
+	std::chrono::milliseconds m_RelayoutInterval{ 50 };
+	Clock::time_point m_LastRelayout;
+	bool m_RelayoutPending = false;
+	int m_PendingWidth = 0;
+	int m_PendingHeight = 0;
+	uint64_t m_RelayoutsSkipped = 0;
+
+	Clock::time_point m_DragStart;
+	uint64_t m_ModalFrames = 0;
+	double m_LastDragFrameRate = 0.0;
+};
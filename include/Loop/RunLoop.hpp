@@ -0,0 +1,522 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <functional>
+#include <windows.h>
+
+// Message loop that also waits on kernel handles. Where `Window::RunDefaultMessageLoop`
+// blocks in `GetMessage`, this loop blocks in `MsgWaitForMultipleObjectsEx`, so events,
+// timers and other handles can wake the UI thread and have their callbacks run there
+// between messages. An optional frame handler is ticked at a fixed interval in between.
+// There is at most one `RunLoop` per thread.
+//
+// In `FrameMode::Automatic` the loop only ticks frames while something animates (an
+// `AnimationScope` is alive) or a frame was requested, and otherwise blocks until the
+// next message like `GetMessage` would.
+class RunLoop {
+public:
+	using Callback = std::function<void()>;
+	using Clock = std::chrono::steady_clock;
+	// Runs when the message queue is empty, until `deadline` at the latest. Returns true
+	// if it still has work, in which case the loop polls instead of blocking.
+	using IdleHandler = std::function<bool(Clock::time_point deadline)>;
+	// Runs once per loop pass and returns when it next wants to run: now (or earlier) to
+	// keep the loop polling, a later time for a timed wait, `Clock::time_point::max()`
+	// when it has nothing to do.
+	using WorkHandler = std::function<Clock::time_point()>;
+
+	// Sees every message `Run` dispatches, e.g. to time handlers. Both calls are made on
+	// the loop thread, right around `DispatchMessage`, and should be cheap.
+	class DispatchObserver {
+	public:
+		virtual ~DispatchObserver() = default;
+		virtual void OnDispatchBegin(const MSG& msg) = 0;
+		virtual void OnDispatchEnd(const MSG& msg) = 0;
+	};
+
+	enum class FrameMode {
+		// Tick every frame interval
+		Continuous,
+		// Tick while animations are active or a frame was requested, block otherwise
+		Automatic,
+	};
+
+	// Loop activity over the interval between two `SampleStats` calls
+	struct Stats {
+		double seconds = 0.0;
+		uint64_t wakeups = 0;
+		uint64_t frames = 0;
+		double wakeupsPerSecond = 0.0;
+		double framesPerSecond = 0.0;
+		// Loop thread CPU time (user + kernel) as a percentage of one core
+		double cpuPercent = 0.0;
+		// Time spent in continuous rendering as a fraction of the interval
+		double continuousFraction = 0.0;
+	};
+
+	RunLoop() {
+		if (CurrentSlot()) {
+			throw std::runtime_error("A RunLoop already exists on this thread.");
+		}
+		CurrentSlot() = this;
+		m_ThreadId = GetCurrentThreadId();
+		m_SampleCpu = ThreadCpuTime();
+	}
+
+	~RunLoop() {
+		CurrentSlot() = nullptr;
+	}
+
+	RunLoop(const RunLoop&) = delete;
+	RunLoop& operator=(const RunLoop&) = delete;
+
+	// Returns the loop of the calling thread, or nullptr if it has none
+	static RunLoop* Current() {
+		return CurrentSlot();
+	}
+
+	DWORD GetThreadId() const {
+		return m_ThreadId;
+	}
+
+	// Runs `callback` on the loop thread every time `handle` is signaled. Auto-reset
+	// objects are the natural fit; a manual-reset event must be reset by the callback.
+	void AddWaitHandle(HANDLE handle, Callback callback) {
+		// One slot of MsgWaitForMultipleObjectsEx is taken by the message queue itself
+		if (m_Handles.size() >= MAXIMUM_WAIT_OBJECTS - 1) {
+			throw std::runtime_error("RunLoop cannot wait on more handles.");
+		}
+		m_Handles.push_back(handle);
+		m_Callbacks.push_back(std::move(callback));
+	}
+
+	void RemoveWaitHandle(HANDLE handle) {
+		for (size_t i = 0; i < m_Handles.size(); ++i) {
+			if (m_Handles[i] == handle) {
+				m_Handles.erase(m_Handles.begin() + i);
+				m_Callbacks.erase(m_Callbacks.begin() + i);
+				return;
+			}
+		}
+	}
+
+	void AddDispatchObserver(DispatchObserver* observer) {
+		m_Observers.push_back(observer);
+	}
+
+	void RemoveDispatchObserver(DispatchObserver* observer) {
+		for (size_t i = 0; i < m_Observers.size(); ++i) {
+			if (m_Observers[i] == observer) {
+				m_Observers.erase(m_Observers.begin() + i);
+				return;
+			}
+		}
+	}
+
+	// Calls `handler` once every `interval` while the loop runs, subject to the frame mode
+	void SetFrameHandler(Callback handler, std::chrono::microseconds interval) {
+		m_FrameHandler = std::move(handler);
+		m_FrameInterval = interval;
+		m_NextFrame = Clock::now();
+	}
+
+	void ClearFrameHandler() {
+		m_FrameHandler = nullptr;
+	}
+
+	bool HasFrameHandler() const {
+		return static_cast<bool>(m_FrameHandler);
+	}
+
+	std::chrono::microseconds GetFrameInterval() const {
+		return m_FrameInterval;
+	}
+
+	// Adds a vote on how fast frames tick, e.g. from a `VisibilityTracker`: every
+	// `divisor`th interval, or never for 0. The loop follows the most demanding vote and
+	// ticks at full rate while there are none. Returns an id for the calls below.
+	size_t AddFrameThrottle(uint32_t divisor) {
+		size_t id = ++m_LastThrottleId;
+		m_Throttles.push_back({ id, divisor });
+		UpdateFrameDivisor();
+		return id;
+	}
+
+	void SetFrameThrottle(size_t id, uint32_t divisor) {
+		for (auto& throttle : m_Throttles) {
+			if (throttle.first == id) {
+				throttle.second = divisor;
+				UpdateFrameDivisor();
+				return;
+			}
+		}
+	}
+
+	void RemoveFrameThrottle(size_t id) {
+		for (size_t i = 0; i < m_Throttles.size(); ++i) {
+			if (m_Throttles[i].first == id) {
+				m_Throttles.erase(m_Throttles.begin() + i);
+				UpdateFrameDivisor();
+				return;
+			}
+		}
+	}
+
+	// Intervals between frames after throttling; 0 while every vote pauses frames
+	uint32_t GetFrameDivisor() const {
+		return m_FrameDivisor;
+	}
+
+	// Runs the frame handler now and schedules the next frame one interval later. Also
+	// meant for code that has to keep frames going while `Run` is not in control, such as
+	// a modal size/move loop.
+	void TickFrame() {
+		if (!m_FrameHandler) {
+			return;
+		}
+		Clock::time_point now = Clock::now();
+		m_NextFrame = now + m_FrameInterval * (m_FrameDivisor ? m_FrameDivisor : 1);
+		m_FrameRequested = false;
+		++m_FrameCount;
+		Callback handler = m_FrameHandler;
+		handler();
+	}
+
+	uint64_t GetFrameCount() const {
+		return m_FrameCount;
+	}
+
+	void SetFrameMode(FrameMode mode) {
+		m_FrameMode = mode;
+	}
+
+	FrameMode GetFrameMode() const {
+		return m_FrameMode;
+	}
+
+	// Animation sources (animations, video, scroll momentum) call `BeginAnimation` when
+	// they start and `EndAnimation` when they settle; prefer `AnimationScope`
+	void BeginAnimation() {
+		if (m_ActiveAnimations++ == 0 && Clock::now() > m_NextFrame) {
+			// Coming out of idle: render the first frame right away
+			m_NextFrame = Clock::now();
+		}
+	}
+
+	void EndAnimation() {
+		if (m_ActiveAnimations > 0) {
+			--m_ActiveAnimations;
+		}
+	}
+
+	size_t GetActiveAnimations() const {
+		return m_ActiveAnimations;
+	}
+
+	// Asks for one frame in automatic mode, e.g. after a state change. Loop thread only.
+	void RequestFrame() {
+		if (!m_FrameRequested) {
+			m_FrameRequested = true;
+			if (Clock::now() > m_NextFrame) {
+				m_NextFrame = Clock::now();
+			}
+		}
+	}
+
+	// True while the loop renders every frame interval rather than waiting for events.
+	// Never while throttling pauses frames, so a hidden window does not wake the thread.
+	bool IsContinuous() const {
+		return m_FrameHandler && m_FrameDivisor != 0 && (m_FrameMode == FrameMode::Continuous || m_ActiveAnimations > 0 || m_FrameRequested);
+	}
+
+	// Returns activity since the previous call and starts a new interval. Loop thread only.
+	Stats SampleStats() {
+		Clock::time_point now = Clock::now();
+		UpdateContinuousTime(now);
+		uint64_t cpu = ThreadCpuTime();
+
+		Stats stats;
+		stats.seconds = std::chrono::duration<double>(now - m_SampleStart).count();
+		stats.wakeups = m_Wakeups - m_SampleWakeups;
+		stats.frames = m_FrameCount - m_SampleFrames;
+		if (stats.seconds > 0) {
+			stats.wakeupsPerSecond = stats.wakeups / stats.seconds;
+			stats.framesPerSecond = stats.frames / stats.seconds;
+			// FILETIME counts 100 ns units
+			stats.cpuPercent = 100.0 * ((cpu - m_SampleCpu) / 1e7) / stats.seconds;
+			stats.continuousFraction = std::chrono::duration<double>(m_ContinuousTime).count() / stats.seconds;
+		}
+
+		m_SampleStart = now;
+		m_SampleWakeups = m_Wakeups;
+		m_SampleFrames = m_FrameCount;
+		m_SampleCpu = cpu;
+		m_ContinuousTime = Clock::duration::zero();
+		return stats;
+	}
+
+	// Adds a handler called once per loop pass, after messages were dispatched and before
+	// the frame. Returns an id for `RemoveWorkHandler`.
+	size_t AddWorkHandler(WorkHandler handler) {
+		size_t id = ++m_LastWorkHandlerId;
+		m_WorkHandlers.push_back({ id, std::move(handler) });
+		return id;
+	}
+
+	void RemoveWorkHandler(size_t id) {
+		for (size_t i = 0; i < m_WorkHandlers.size(); ++i) {
+			if (m_WorkHandlers[i].first == id) {
+				m_WorkHandlers.erase(m_WorkHandlers.begin() + i);
+				return;
+			}
+		}
+	}
+
+	// Installs the handler called whenever the queue has been drained. The loop never
+	// grants it more than `maxBudget`, nor time past the next frame.
+	void SetIdleHandler(IdleHandler handler, std::chrono::microseconds maxBudget = std::chrono::milliseconds(50)) {
+		m_IdleHandler = std::move(handler);
+		m_IdleBudget = maxBudget;
+	}
+
+	void ClearIdleHandler() {
+		m_IdleHandler = nullptr;
+	}
+
+	// Runs until `WM_QUIT` and returns its exit code
+	int Run() {
+		int exitCode = 0;
+		for (;;) {
+			if (!PumpMessages(exitCode)) {
+				return exitCode;
+			}
+			Clock::time_point wake = RunWorkHandlers();
+			if (IsContinuous()) {
+				if (Clock::now() >= m_NextFrame) {
+					TickFrame();
+				}
+				// The frame may have ended the last animation, leaving m_NextFrame stale
+				if (IsContinuous() && m_NextFrame < wake) {
+					wake = m_NextFrame;
+				}
+			}
+			DWORD timeout = wake == Clock::time_point::max() ? INFINITE : MillisecondsUntil(wake);
+			// Messages left over from a full batch wake the wait at once; the idle handler
+			// only runs once the queue is really empty
+			if (m_MessagesLeft) {
+				timeout = 0;
+			}
+			if (timeout != 0 && m_IdleHandler && RunIdle(wake)) {
+				timeout = 0;
+			}
+			Wait(timeout);
+		}
+	}
+
+	// Posts `WM_QUIT` to the loop thread
+	void Quit(int exitCode = 0) {
+		PostThreadMessage(m_ThreadId, WM_QUIT, static_cast<WPARAM>(exitCode), 0);
+	}
+
+protected:
+	// Dispatches queued messages, at most `kMessagesPerPass` of them, so handles, work
+	// handlers and frames get a turn during a message flood. Returns false once `WM_QUIT`
+	// was retrieved.
+	bool PumpMessages(int& exitCode) {
+		MSG msg = {};
+		m_MessagesLeft = false;
+		for (size_t count = 0;; ++count) {
+			if (count == kMessagesPerPass) {
+				m_MessagesLeft = true;
+				break;
+			}
+			if (!PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+				break;
+			}
+			if (msg.message == WM_QUIT) {
+				exitCode = static_cast<int>(msg.wParam);
+				return false;
+			}
+			TranslateMessage(&msg);
+			if (m_Observers.empty()) {
+				DispatchMessage(&msg);
+				continue;
+			}
+			// Index loops, a handler may add or remove observers
+			for (size_t i = 0; i < m_Observers.size(); ++i) {
+				m_Observers[i]->OnDispatchBegin(msg);
+			}
+			DispatchMessage(&msg);
+			for (size_t i = m_Observers.size(); i-- > 0;) {
+				m_Observers[i]->OnDispatchEnd(msg);
+			}
+		}
+		return true;
+	}
+
+	// Blocks until a message arrives, a handle is signaled or `timeout` elapses, and runs
+	// the callback of the signaled handle. Handles are checked before the queue and
+	// `PumpMessages` stops after a batch, so a flood of messages cannot starve them.
+	void Wait(DWORD timeout) {
+		UpdateContinuousTime(Clock::now());
+		DWORD count = static_cast<DWORD>(m_Handles.size());
+		DWORD result = MsgWaitForMultipleObjectsEx(count, m_Handles.data(), timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE | MWMO_ALERTABLE);
+		++m_Wakeups;
+		if (result - WAIT_OBJECT_0 < count) {
+			// Copy, the callback may remove its own handle
+			Callback callback = m_Callbacks[result - WAIT_OBJECT_0];
+			callback();
+		}
+	}
+
+	// Rounds up: a truncated timeout wakes just before the deadline and the loop then
+	// spins with zero timeouts until it passes
+	static DWORD MillisecondsUntil(Clock::time_point deadline) {
+		auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+		return remaining.count() > 0 ? static_cast<DWORD>(remaining.count()) : 0;
+	}
+
+private:
+	// Messages dispatched per pass before handles get a turn
+	static constexpr size_t kMessagesPerPass = 64;
+
+	Clock::time_point RunWorkHandlers() {
+		Clock::time_point next = Clock::time_point::max();
+		// Index loop, handlers may add or remove handlers
+		for (size_t i = 0; i < m_WorkHandlers.size(); ++i) {
+			WorkHandler handler = m_WorkHandlers[i].second;
+			Clock::time_point wanted = handler();
+			if (wanted < next) {
+				next = wanted;
+			}
+		}
+		return next;
+	}
+
+	// Offers the time until the loop next has to wake (or the idle budget) to the idle
+	// handler. `wake` is the next frame in continuous mode or the next work handler run.
+	bool RunIdle(Clock::time_point wake) {
+		Clock::time_point deadline = Clock::now() + m_IdleBudget;
+		if (wake < deadline) {
+			deadline = wake;
+		}
+		if (deadline <= Clock::now()) {
+			return true;
+		}
+		IdleHandler handler = m_IdleHandler;
+		return handler(deadline);
+	}
+
+	void UpdateFrameDivisor() {
+		uint32_t divisor = m_Throttles.empty() ? 1 : 0;
+		for (const auto& throttle : m_Throttles) {
+			if (throttle.second != 0 && (divisor == 0 || throttle.second < divisor)) {
+				divisor = throttle.second;
+			}
+		}
+		if (divisor == m_FrameDivisor) {
+			return;
+		}
+		UpdateContinuousTime(Clock::now());
+		bool faster = m_FrameDivisor == 0 || (divisor != 0 && divisor < m_FrameDivisor);
+		m_FrameDivisor = divisor;
+		// Speeding up takes effect at once instead of after the slow interval
+		if (faster && m_NextFrame > Clock::now()) {
+			m_NextFrame = Clock::now();
+		}
+	}
+
+	// Charges the time since the last call to continuous mode if the loop was in it
+	void UpdateContinuousTime(Clock::time_point now) {
+		if (m_WasContinuous) {
+			m_ContinuousTime += now - m_LastModeCheck;
+		}
+		m_WasContinuous = IsContinuous();
+		m_LastModeCheck = now;
+	}
+
+	static uint64_t ThreadCpuTime() {
+		FILETIME creation, exit, kernel, user;
+		if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+			return 0;
+		}
+		auto toTicks = [](const FILETIME& time) {
+			return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+		};
+		return toTicks(kernel) + toTicks(user);
+	}
+
+	static RunLoop*& CurrentSlot() {
+		static thread_local RunLoop* current = nullptr;
+		return current;
+	}
+
+	DWORD m_ThreadId;
+	std::vector<HANDLE> m_Handles;
+	std::vector<Callback> m_Callbacks;
+	std::vector<DispatchObserver*> m_Observers;
+	Callback m_FrameHandler;
+	std::chrono::microseconds m_FrameInterval{ 16667 };
+	Clock::time_point m_NextFrame;
+	uint64_t m_FrameCount = 0;
+	FrameMode m_FrameMode = FrameMode::Continuous;
+	std::vector<std::pair<size_t, WorkHandler>> m_WorkHandlers;
+	size_t m_LastWorkHandlerId = 0;
+	IdleHandler m_IdleHandler;
+	std::chrono::microseconds m_IdleBudget{ 50000 };
+	size_t m_ActiveAnimations = 0;
+	bool m_FrameRequested = false;
+	std::vector<std::pair<size_t, uint32_t>> m_Throttles;
+	size_t m_LastThrottleId = 0;
+	uint32_t m_FrameDivisor = 1;
+
+	bool m_MessagesLeft = false;
+
+	uint64_t m_Wakeups = 0;
+	bool m_WasContinuous = false;
+	Clock::time_point m_LastModeCheck = Clock::now();
+	Clock::duration m_ContinuousTime = Clock::duration::zero();
+	Clock::time_point m_SampleStart = Clock::now();
+	uint64_t m_SampleWakeups = 0;
+	uint64_t m_SampleFrames = 0;
+	uint64_t m_SampleCpu = 0;
+};
+
+// Keeps a `RunLoop` in continuous rendering for as long as it is alive
+class AnimationScope {
+public:
+	explicit AnimationScope(RunLoop& loop) : m_Loop(&loop) {
+		m_Loop->BeginAnimation();
+	}
+
+	~AnimationScope() {
+		if (m_Loop) {
+			m_Loop->EndAnimation();
+		}
+	}
+
+	AnimationScope(const AnimationScope&) = delete;
+	AnimationScope& operator=(const AnimationScope&) = delete;
+
+	AnimationScope(AnimationScope&& other) noexcept : m_Loop(other.m_Loop) {
+		other.m_Loop = nullptr;
+	}
+
+	AnimationScope& operator=(AnimationScope&& other) noexcept {
+		if (this != &other) {
+			if (m_Loop) {
+				m_Loop->EndAnimation();
+			}
+			m_Loop = other.m_Loop;
+			other.m_Loop = nullptr;
+		}
+		return *this;
+	}
+
+private:
+	RunLoop* m_Loop;
+};
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+#include <utility>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <windows.h>
+
+#include "RunLoop.hpp"
+#include "../Window/Window.hpp"
+
+// Long-running work that has to run on the UI thread, written as a coroutine that
+// reports its progress with `co_yield`:
+//
+//	UiJob FillList(HWND list, std::vector<std::wstring> items) {
+//		for (size_t i = 0; i < items.size(); ++i) {
+//			SendMessage(list, LB_ADDSTRING, 0, reinterpret_cast<LPARAM>(items[i].c_str()));
+//			co_yield static_cast<float>(i + 1) / items.size();
+//		}
+//	}
+//
+// `co_yield` is cheap: it only suspends once the job's time slice is used up, so a job
+// can yield after every item. `co_await UiJob::NextFrame()` always suspends. Jobs are
+// driven by a `UiJobRunner`; the job object only owns the coroutine until it is started.
+class UiJob {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct promise_type {
+		Clock::time_point sliceDeadline;
+		float progress = 0.0f;
+		std::exception_ptr error;
+
+		UiJob get_return_object() {
+			return UiJob(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		// Nothing runs until the runner gives the job its first slice
+		std::suspend_always initial_suspend() noexcept {
+			return {};
+		}
+
+		std::suspend_always final_suspend() noexcept {
+			return {};
+		}
+
+		void return_void() {}
+
+		void unhandled_exception() {
+			error = std::current_exception();
+		}
+
+		struct SliceCheck {
+			const promise_type* promise;
+
+			bool await_ready() const noexcept {
+				return Clock::now() < promise->sliceDeadline;
+			}
+
+			void await_suspend(std::coroutine_handle<>) const noexcept {}
+
+			void await_resume() const noexcept {}
+		};
+
+		// Records the progress and suspends if the slice is over
+		SliceCheck yield_value(float value) {
+			progress = value;
+			return SliceCheck{ this };
+		}
+	};
+
+	using Handle = std::coroutine_handle<promise_type>;
+
+	// Suspends until the next slice regardless of the time left
+	struct NextFrame {
+		bool await_ready() const noexcept {
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<>) const noexcept {}
+
+		void await_resume() const noexcept {}
+	};
+
+	UiJob(UiJob&& other) noexcept : m_Handle(std::exchange(other.m_Handle, nullptr)) {}
+
+	UiJob& operator=(UiJob&& other) noexcept {
+		if (this != &other) {
+			if (m_Handle) {
+				m_Handle.destroy();
+			}
+			m_Handle = std::exchange(other.m_Handle, nullptr);
+		}
+		return *this;
+	}
+
+	UiJob(const UiJob&) = delete;
+	UiJob& operator=(const UiJob&) = delete;
+
+	~UiJob() {
+		if (m_Handle) {
+			m_Handle.destroy();
+		}
+	}
+
+	// Transfers ownership of the coroutine to the caller
+	Handle Release() {
+		return std::exchange(m_Handle, nullptr);
+	}
+
+private:
+	explicit UiJob(Handle handle) : m_Handle(handle) {}
+
+	Handle m_Handle;
+};
+
+// How a job ended
+enum class JobState {
+	Completed,
+	Cancelled,
+	Failed,
+};
+
+// Runs `UiJob`s on a `RunLoop`, one time slice per frame interval. The slice is shared
+// between the running jobs, so many jobs slow each other down instead of the UI. A job
+// started for a `Window` is cancelled by a message layer when the window receives
+// `WM_NCDESTROY`, so it never touches a destroyed window, nor one that reuses its
+// handle. Jobs started for a bare `HWND` can only check `IsWindow` before each slice.
+class UiJobRunner {
+public:
+	using Clock = std::chrono::steady_clock;
+	using JobId = uint64_t;
+	// Called once when a job ends. `error` is set for `JobState::Failed`.
+	using FinishedHandler = std::function<void(JobState state, std::exception_ptr error)>;
+
+	explicit UiJobRunner(RunLoop& loop, std::chrono::microseconds slice = std::chrono::milliseconds(8))
+		: m_Loop(loop), m_Slice(slice) {
+		m_WorkHandler = m_Loop.AddWorkHandler([this] { return RunSlice(); });
+	}
+
+	~UiJobRunner() {
+		m_Loop.RemoveWorkHandler(m_WorkHandler);
+		for (Job& job : m_Jobs) {
+			RemoveOwnerLayer(job);
+			job.handle.destroy();
+		}
+	}
+
+	UiJobRunner(const UiJobRunner&) = delete;
+	UiJobRunner& operator=(const UiJobRunner&) = delete;
+
+	// Starts a job tied to `owner`; pass NULL for a job that is not tied to a window. A
+	// failed job without a finished handler rethrows its exception from the loop.
+	JobId Start(HWND owner, UiJob job, FinishedHandler onFinished = nullptr) {
+		JobId id = ++m_LastId;
+		m_Jobs.push_back({ id, owner, job.Release(), std::move(onFinished), false, nullptr, 0 });
+		return id;
+	}
+
+	// Starts a job that is cancelled as soon as `owner` is destroyed
+	JobId Start(Window& owner, UiJob job, FinishedHandler onFinished = nullptr) {
+		// The id the call below hands out; the layer goes first, in case it throws
+		JobId id = m_LastId + 1;
+		size_t layer = owner.AddMessageLayer({ WM_NCDESTROY }, [this, id](HWND, UINT, WPARAM, LPARAM, LRESULT&) {
+			if (Job* running = Find(id)) {
+				running->cancelled = true;
+				// The layer goes with the window's chain
+				running->window = nullptr;
+			}
+			return false;
+		});
+		Start(owner.GetHandle(), std::move(job), std::move(onFinished));
+		Job* started = Find(id);
+		started->window = &owner;
+		started->layer = layer;
+		return id;
+	}
+
+	// Cancels a job before its next slice. Returns false if it is not running.
+	bool Cancel(JobId id) {
+		Job* job = Find(id);
+		if (!job || job->cancelled) {
+			return false;
+		}
+		job->cancelled = true;
+		return true;
+	}
+
+	void CancelAll() {
+		for (Job& job : m_Jobs) {
+			job.cancelled = true;
+		}
+	}
+
+	bool IsRunning(JobId id) const {
+		return Find(id) != nullptr;
+	}
+
+	// Last progress the job reported, or 1 once it is no longer running
+	float GetProgress(JobId id) const {
+		const Job* job = Find(id);
+		return job ? job->handle.promise().progress : 1.0f;
+	}
+
+	size_t GetActiveCount() const {
+		return m_Jobs.size();
+	}
+
+	uint64_t GetSliceCount() const {
+		return m_Slices;
+	}
+
+	void SetSlice(std::chrono::microseconds slice) {
+		m_Slice = slice;
+	}
+
+private:
+	struct Job {
+		JobId id;
+		HWND owner;
+		UiJob::Handle handle;
+		FinishedHandler onFinished;
+		bool cancelled;
+		// Window whose `WM_NCDESTROY` layer cancels the job, until it is destroyed
+		Window* window;
+		size_t layer;
+	};
+
+	Job* Find(JobId id) {
+		for (Job& job : m_Jobs) {
+			if (job.id == id) {
+				return &job;
+			}
+		}
+		return nullptr;
+	}
+
+	const Job* Find(JobId id) const {
+		return const_cast<UiJobRunner*>(this)->Find(id);
+	}
+
+	Clock::time_point RunSlice() {
+		if (m_Jobs.empty()) {
+			return Clock::time_point::max();
+		}
+		Clock::time_point now = Clock::now();
+		if (now < m_NextSlice) {
+			return m_NextSlice;
+		}
+		m_NextSlice = now + m_Loop.GetFrameInterval();
+		++m_Slices;
+
+		// Jobs started during the slice wait for the next one
+		size_t count = m_Jobs.size();
+		Clock::duration share = m_Slice / static_cast<int64_t>(count);
+		for (size_t i = 0; i < count; ++i) {
+			// Jobs started for a bare handle have no destruction hook
+			if (m_Jobs[i].cancelled || (m_Jobs[i].owner && !IsWindow(m_Jobs[i].owner))) {
+				m_Jobs[i].cancelled = true;
+				continue;
+			}
+			UiJob::Handle handle = m_Jobs[i].handle;
+			handle.promise().sliceDeadline = Clock::now() + share;
+			// The job may start or cancel jobs, which can reallocate m_Jobs
+			handle.resume();
+			// Leave the rest of the slice to messages once input is waiting
+			if (HIWORD(GetQueueStatus(QS_INPUT)) != 0) {
+				break;
+			}
+		}
+		FinishJobs();
+		return m_Jobs.empty() ? Clock::time_point::max() : m_NextSlice;
+	}
+
+	// Removes finished and cancelled jobs, then notifies their handlers
+	void FinishJobs() {
+		std::vector<Job> finished;
+		for (size_t i = 0; i < m_Jobs.size();) {
+			if (m_Jobs[i].handle.done() || m_Jobs[i].cancelled) {
+				finished.push_back(std::move(m_Jobs[i]));
+				m_Jobs.erase(m_Jobs.begin() + i);
+			}
+			else {
+				++i;
+			}
+		}
+
+		std::exception_ptr unhandled;
+		for (Job& job : finished) {
+			JobState state = JobState::Cancelled;
+			std::exception_ptr error;
+			if (job.handle.done()) {
+				error = job.handle.promise().error;
+				state = error ? JobState::Failed : JobState::Completed;
+			}
+			RemoveOwnerLayer(job);
+			job.handle.destroy();
+			if (job.onFinished) {
+				job.onFinished(state, error);
+			}
+			else if (error && !unhandled) {
+				unhandled = error;
+			}
+		}
+		if (unhandled) {
+			std::rethrow_exception(unhandled);
+		}
+	}
+
+	void RemoveOwnerLayer(Job& job) {
+		if (job.window) {
+			job.window->RemoveMessageLayer(job.layer);
+			job.window = nullptr;
+		}
+	}
+
+	RunLoop& m_Loop;
+	size_t m_WorkHandler = 0;
+	std::chrono::microseconds m_Slice;
+	std::vector<Job> m_Jobs;
+	JobId m_LastId = 0;
+	Clock::time_point m_NextSlice;
+	uint64_t m_Slices = 0;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <windows.h>
+
+#include "RunLoop.hpp"
+#include "LaneScheduler.hpp"
+
+// Priority-aware task posting for the UI thread. Tasks are queued in `TaskLane`s and
+// drained by the `RunLoop` once per pass, after pending messages were dispatched and
+// before the frame, under the lane budgets and starvation rules of `LaneScheduler`.
+// Draining stops as soon as input is waiting in the message queue, so a burst of posted
+// work never delays input by more than one task.
+//
+// The budgets are per frame of the loop: they are refilled when the loop ticks a frame,
+// or after the scheduler's frame interval while no frames tick. Once they are spent the
+// loop sleeps until the next frame instead of polling.
+class UiScheduler {
+public:
+	using Task = LaneScheduler::Task;
+
+	explicit UiScheduler(RunLoop& loop, const LaneScheduler::Config& config = LaneScheduler::Config())
+		: m_Loop(loop), m_Scheduler(config) {
+		m_WorkHandler = m_Loop.AddWorkHandler([this] { return RunPass(); });
+	}
+
+	~UiScheduler() {
+		m_Loop.RemoveWorkHandler(m_WorkHandler);
+	}
+
+	UiScheduler(const UiScheduler&) = delete;
+	UiScheduler& operator=(const UiScheduler&) = delete;
+
+	// Queues a task from the loop thread
+	void Post(TaskLane lane, Task task) {
+		m_Scheduler.Post(lane, std::move(task));
+	}
+
+	// Queues a task from any thread and wakes the loop
+	void PostFromAnyThread(TaskLane lane, Task task) {
+		bool wake;
+		{
+			std::lock_guard<std::mutex> lock(m_InboxMutex);
+			wake = m_Inbox.empty();
+			m_Inbox.emplace_back(lane, std::move(task));
+		}
+		if (wake) {
+			PostThreadMessage(m_Loop.GetThreadId(), WM_NULL, 0, 0);
+		}
+	}
+
+	LaneScheduler& GetScheduler() {
+		return m_Scheduler;
+	}
+
+	const LaneLatency& GetLatency(TaskLane lane) const {
+		return m_Scheduler.GetLatency(lane);
+	}
+
+private:
+	RunLoop::Clock::time_point RunPass() {
+		{
+			std::lock_guard<std::mutex> lock(m_InboxMutex);
+			m_Draining.swap(m_Inbox);
+		}
+		for (auto& posted : m_Draining) {
+			m_Scheduler.Post(posted.first, std::move(posted.second));
+		}
+		m_Draining.clear();
+
+		// A frame ticked since the last pass
+		if (m_Loop.GetFrameCount() != m_LastFrame) {
+			m_LastFrame = m_Loop.GetFrameCount();
+			m_Scheduler.BeginFrame();
+		}
+		m_Scheduler.Run([] {
+			return HIWORD(GetQueueStatus(QS_INPUT)) != 0;
+		});
+		return m_Scheduler.GetNextRunTime();
+	}
+
+	RunLoop& m_Loop;
+	size_t m_WorkHandler = 0;
+	uint64_t m_LastFrame = 0;
+	LaneScheduler m_Scheduler;
+	std::mutex m_InboxMutex;
+	std::vector<std::pair<TaskLane, Task>> m_Inbox;
+	std::vector<std::pair<TaskLane, Task>> m_Draining;
+};
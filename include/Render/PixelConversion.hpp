@@ -0,0 +1,181 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define WINCPP_PIXEL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+enum class AlphaConversion : uint8_t {
+	// Copy the pixels unchanged
+	None,
+	// Straight alpha (clipboard, PNG) to premultiplied alpha (surfaces, `AlphaBlend`)
+	Premultiply,
+	// Premultiplied alpha back to straight alpha
+	Unpremultiply,
+};
+
+// Conversion kernels for 32-bit BGRA pixels (`0xAARRGGBB` in memory order B, G, R, A).
+// The row kernels process four pixels per step with SSE2 on x86-64 and fall back to the
+// scalar versions elsewhere and for the tail of a row; both produce identical results.
+// Blocks of opaque pixels, the common case for snapshots, are copied through unchanged.
+// Source and target may be the same buffer. Platform independent.
+class PixelConversion {
+public:
+	// round(c * a / 255) for every color channel; alpha is kept
+	static void PremultiplyRow(const uint32_t* source, uint32_t* target, size_t count) {
+		size_t i = 0;
+#if WINCPP_PIXEL_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+		const __m128i half = _mm_set1_epi16(128);
+		for (; i + 4 <= count; i += 4) {
+			__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+			__m128i alpha = _mm_and_si128(pixels, alphaMask);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) != 0xFFFF) {
+				__m128i low = _mm_unpacklo_epi8(pixels, zero);
+				__m128i high = _mm_unpackhi_epi8(pixels, zero);
+				low = MultiplyDivide255(low, BroadcastAlpha16(low), half);
+				high = MultiplyDivide255(high, BroadcastAlpha16(high), half);
+				pixels = _mm_or_si128(_mm_andnot_si128(alphaMask, _mm_packus_epi16(low, high)), alpha);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), pixels);
+		}
+#endif
+		ScalarPremultiplyRow(source + i, target + i, count - i);
+	}
+
+	// round(c * 255 / a), clamped to 255, for every color channel; pixels with zero alpha
+	// become transparent black
+	static void UnpremultiplyRow(const uint32_t* source, uint32_t* target, size_t count) {
+		size_t i = 0;
+#if WINCPP_PIXEL_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+		for (; i + 4 <= count; i += 4) {
+			__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+			__m128i alpha = _mm_and_si128(pixels, alphaMask);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) != 0xFFFF) {
+				__m128i low = _mm_unpacklo_epi8(pixels, zero);
+				__m128i high = _mm_unpackhi_epi8(pixels, zero);
+				__m128i first = _mm_packs_epi32(UnpremultiplyPixel(_mm_unpacklo_epi16(low, zero)), UnpremultiplyPixel(_mm_unpackhi_epi16(low, zero)));
+				__m128i second = _mm_packs_epi32(UnpremultiplyPixel(_mm_unpacklo_epi16(high, zero)), UnpremultiplyPixel(_mm_unpackhi_epi16(high, zero)));
+				pixels = _mm_or_si128(_mm_andnot_si128(alphaMask, _mm_packus_epi16(first, second)), alpha);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), pixels);
+		}
+#endif
+		ScalarUnpremultiplyRow(source + i, target + i, count - i);
+	}
+
+	static void ScalarPremultiplyRow(const uint32_t* source, uint32_t* target, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			uint32_t pixel = source[i];
+			uint32_t alpha = pixel >> 24;
+			if (alpha != 255) {
+				uint32_t result = alpha << 24;
+				for (int shift = 0; shift < 24; shift += 8) {
+					uint32_t value = ((pixel >> shift) & 0xFF) * alpha + 128;
+					result |= ((value + (value >> 8)) >> 8) << shift;
+				}
+				pixel = result;
+			}
+			target[i] = pixel;
+		}
+	}
+
+	static void ScalarUnpremultiplyRow(const uint32_t* source, uint32_t* target, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			uint32_t pixel = source[i];
+			uint32_t alpha = pixel >> 24;
+			if (alpha == 0) {
+				pixel = 0;
+			}
+			else if (alpha != 255) {
+				uint32_t result = alpha << 24;
+				for (int shift = 0; shift < 24; shift += 8) {
+					uint32_t value = (((pixel >> shift) & 0xFF) * 255 + alpha / 2) / alpha;
+					result |= (value > 255 ? 255 : value) << shift;
+				}
+				pixel = result;
+			}
+			target[i] = pixel;
+		}
+	}
+
+	// Converts a `width` x `height` block between buffers with independent strides in
+	// bytes. A negative stride walks the rows upwards, starting from the row `pixels`
+	// points to, which turns top-down rows into bottom-up DIB rows and back.
+	static void Convert(const void* source, ptrdiff_t sourceStride, void* target, ptrdiff_t targetStride, uint32_t width, uint32_t height, AlphaConversion conversion) {
+		const uint8_t* sourceRow = static_cast<const uint8_t*>(source);
+		uint8_t* targetRow = static_cast<uint8_t*>(target);
+		for (uint32_t y = 0; y < height; ++y, sourceRow += sourceStride, targetRow += targetStride) {
+			const uint32_t* from = reinterpret_cast<const uint32_t*>(sourceRow);
+			uint32_t* to = reinterpret_cast<uint32_t*>(targetRow);
+			switch (conversion) {
+			case AlphaConversion::Premultiply:
+				PremultiplyRow(from, to, width);
+				break;
+			case AlphaConversion::Unpremultiply:
+				UnpremultiplyRow(from, to, width);
+				break;
+			default:
+				if (from != to) {
+					memcpy(to, from, width * sizeof(uint32_t));
+				}
+				break;
+			}
+		}
+	}
+
+	// Expands 24-bit BGR pixels to opaque 32-bit BGRA
+	static void ExpandBgrRow(const uint8_t* source, uint32_t* target, size_t count) {
+		for (size_t i = 0; i < count; ++i, source += 3) {
+			target[i] = 0xFF000000u | (uint32_t(source[2]) << 16) | (uint32_t(source[1]) << 8) | source[0];
+		}
+	}
+
+	// Whether any pixel of the row has a nonzero alpha. 32-bit `BI_RGB` bitmaps leave the
+	// alpha byte undefined and usually zero; such images are treated as opaque.
+	static bool HasAlpha(const uint32_t* pixels, size_t count) {
+		uint32_t any = 0;
+		for (size_t i = 0; i < count; ++i) {
+			any |= pixels[i];
+		}
+		return (any >> 24) != 0;
+	}
+
+	static void SetOpaqueRow(uint32_t* pixels, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			pixels[i] |= 0xFF000000u;
+		}
+	}
+
+private:
+#if WINCPP_PIXEL_SSE2
+	// Copies each pixel's alpha to its four 16-bit lanes
+	static __m128i BroadcastAlpha16(__m128i pixels) {
+		return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	// Exact round(value * alpha / 255) on 16-bit lanes
+	static __m128i MultiplyDivide255(__m128i value, __m128i alpha, __m128i half) {
+		__m128i product = _mm_add_epi16(_mm_mullo_epi16(value, alpha), half);
+		return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+	}
+
+	// One pixel as four 32-bit lanes. The quotient is correctly rounded, so adding one half
+	// and truncating matches the scalar integer rounding for every valid input.
+	static __m128i UnpremultiplyPixel(__m128i pixel) {
+		__m128 value = _mm_cvtepi32_ps(pixel);
+		__m128 alpha = _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 visible = _mm_cmpneq_ps(alpha, _mm_setzero_ps());
+		__m128 result = _mm_div_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_max_ps(alpha, _mm_set1_ps(1.0f)));
+		result = _mm_min_ps(_mm_add_ps(result, _mm_set1_ps(0.5f)), _mm_set1_ps(255.0f));
+		return _mm_cvttps_epi32(_mm_and_ps(result, visible));
+	}
+#endif
+};
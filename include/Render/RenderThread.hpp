@@ -0,0 +1,273 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+#include <functional>
+#include <source_location>
+#include <windows.h>
+
+#include "TripleBuffer.hpp"
+#include "../System/ApiTable.hpp"
+#include "../Diagnostics/GuiResources.hpp"
+#include "../Diagnostics/MemoryLedger.hpp"
+
+// Geometry and input state the UI thread hands to the render thread
+struct RenderSnapshot {
+	int width = 0;
+	int height = 0;
+	UINT dpi = USER_DEFAULT_SCREEN_DPI;
+	POINT cursor = {};
+	WPARAM buttons = 0;
+	// When the newest input in this snapshot was received, for input-to-present latency
+	std::chrono::steady_clock::time_point inputTime = {};
+};
+
+// A 32-bit top-down DIB the render thread draws into
+struct RenderBuffer {
+	HBITMAP bitmap = NULL;
+	HGDIOBJ previous = NULL;
+	HDC dc = NULL;
+	void* pixels = nullptr;
+	int width = 0;
+	int height = 0;
+	std::chrono::steady_clock::time_point inputTime = {};
+	MemoryCharge memory;
+};
+
+// Draws and presents a window's content off the UI thread, so drags, menus and slow
+// message handlers no longer stall animation. Three threads cooperate:
+//
+// - the UI thread forwards geometry and input from the window procedure via
+//   `HandleMessage`, publishing `RenderSnapshot`s through a `TripleBuffer`;
+// - the render thread takes the newest snapshot, calls the draw callback on a free back
+//   buffer and publishes it through a second `TripleBuffer`, staying at most one frame
+//   ahead of presentation;
+// - the present thread blits the newest finished buffer to the window once per
+//   composition cycle (`DwmFlush`), independently of the message loop.
+//
+// The window procedure should validate `WM_PAINT` without painting and call `Redraw`.
+class RenderThread {
+public:
+	using DrawCallback = std::function<void(RenderBuffer& target, const RenderSnapshot& snapshot)>;
+
+	// With `continuous` set a new frame is drawn every cycle, otherwise only after a
+	// snapshot change or `Redraw`. `fallbackInterval` paces presentation when DWM
+	// composition is unavailable.
+	RenderThread(HWND window, DrawCallback draw, bool continuous = true, std::chrono::milliseconds fallbackInterval = std::chrono::milliseconds(16), const std::source_location& location = std::source_location::current())
+		: m_Window(window), m_Draw(std::move(draw)), m_Continuous(continuous), m_FallbackInterval(fallbackInterval), m_Location(location) {
+		m_Wake = CreateEventW(NULL, FALSE, FALSE, NULL);
+		if (!m_Wake) {
+			throw std::runtime_error("Failed to create render thread event.");
+		}
+		RECT client = {};
+		GetClientRect(window, &client);
+		RenderSnapshot& initial = m_Snapshots.GetWriteBuffer();
+		initial.width = client.right - client.left;
+		initial.height = client.bottom - client.top;
+		initial.dpi = GetUser32Api().GetDpiForWindow(window);
+		m_Snapshot = initial;
+		m_Snapshots.Publish();
+
+		m_Renderer = std::thread([this] { RenderLoop(); });
+		m_Presenter = std::thread([this] { PresentLoop(); });
+	}
+
+	~RenderThread() {
+		m_Running.store(false, std::memory_order_release);
+		SetEvent(m_Wake);
+		m_Renderer.join();
+		m_Presenter.join();
+		for (uint32_t i = 0; i < FrameRing::kSlotCount; ++i) {
+			DestroyBuffer(m_Frames[i]);
+		}
+		CloseHandle(m_Wake);
+	}
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	// ---- UI thread ----
+
+	// Call from the window procedure for every message. Records size, DPI, cursor and
+	// button changes and passes them to the render thread.
+	void HandleMessage(UINT message, WPARAM wParam, LPARAM lParam) {
+		switch (message) {
+		case WM_SIZE:
+			m_Snapshot.width = LOWORD(lParam);
+			m_Snapshot.height = HIWORD(lParam);
+			break;
+		case WM_DPICHANGED:
+			m_Snapshot.dpi = HIWORD(wParam);
+			break;
+		case WM_MOUSEMOVE:
+		case WM_LBUTTONDOWN:
+		case WM_LBUTTONUP:
+		case WM_RBUTTONDOWN:
+		case WM_RBUTTONUP:
+		case WM_MBUTTONDOWN:
+		case WM_MBUTTONUP:
+			m_Snapshot.cursor.x = static_cast<short>(LOWORD(lParam));
+			m_Snapshot.cursor.y = static_cast<short>(HIWORD(lParam));
+			m_Snapshot.buttons = wParam;
+			m_Snapshot.inputTime = std::chrono::steady_clock::now();
+			break;
+		default:
+			return;
+		}
+		PublishSnapshot();
+	}
+
+	// Publishes a snapshot built by the caller, for state `HandleMessage` does not track
+	void UpdateSnapshot(const RenderSnapshot& snapshot) {
+		m_Snapshot = snapshot;
+		PublishSnapshot();
+	}
+
+	// Asks for a new frame even if nothing changed
+	void Redraw() {
+		m_RedrawRequested.store(true, std::memory_order_release);
+		SetEvent(m_Wake);
+	}
+
+	// ---- Any thread ----
+
+	uint64_t GetFramesRendered() const {
+		return m_FramesRendered.load(std::memory_order_relaxed);
+	}
+
+	uint64_t GetFramesPresented() const {
+		return m_FramesPresented.load(std::memory_order_relaxed);
+	}
+
+	// Frames rendered but replaced before they could be presented
+	uint64_t GetFramesDropped() const {
+		return m_FramesDropped.load(std::memory_order_relaxed);
+	}
+
+	// Time from the newest input in a frame's snapshot to that frame being presented
+	std::chrono::microseconds GetLastInputLatency() const {
+		return std::chrono::microseconds(m_LastInputLatency.load(std::memory_order_relaxed));
+	}
+
+private:
+	void PublishSnapshot() {
+		m_Snapshots.GetWriteBuffer() = m_Snapshot;
+		m_Snapshots.Publish();
+		SetEvent(m_Wake);
+	}
+
+	void RenderLoop() {
+		bool dirty = true;
+		while (m_Running.load(std::memory_order_acquire)) {
+			if (m_Snapshots.Acquire() || m_RedrawRequested.exchange(false, std::memory_order_acq_rel)) {
+				dirty = true;
+			}
+			// Stay at most one frame ahead of the presenter; it wakes us once it took the last one
+			if ((!dirty && !m_Continuous) || m_Frames.HasNewValue()) {
+				WaitForSingleObject(m_Wake, INFINITE);
+				continue;
+			}
+
+			const RenderSnapshot& snapshot = *m_Snapshots.GetReadBuffer();
+			RenderBuffer& target = m_Frames.GetWriteBuffer();
+			if (target.width != snapshot.width || target.height != snapshot.height) {
+				DestroyBuffer(target);
+				CreateBuffer(target, snapshot.width, snapshot.height);
+			}
+			if (target.dc) {
+				m_Draw(target, snapshot);
+				GdiFlush();
+			}
+			target.inputTime = snapshot.inputTime;
+			m_Frames.Publish();
+			m_FramesRendered.fetch_add(1, std::memory_order_relaxed);
+			dirty = false;
+		}
+	}
+
+	void PresentLoop() {
+		HDC windowDC = GetDC(m_Window);
+		std::chrono::steady_clock::time_point lastInput = {};
+		while (m_Running.load(std::memory_order_acquire)) {
+			if (m_Frames.Acquire()) {
+				SetEvent(m_Wake);
+				RenderBuffer& frame = *m_Frames.GetReadBuffer();
+				if (frame.dc) {
+					BitBlt(windowDC, 0, 0, frame.width, frame.height, frame.dc, 0, 0, SRCCOPY);
+					GdiFlush();
+				}
+				m_FramesPresented.fetch_add(1, std::memory_order_relaxed);
+				m_FramesDropped.store(m_Frames.GetDroppedCount(), std::memory_order_relaxed);
+				// Only the first frame showing a given input counts towards its latency
+				if (frame.inputTime > lastInput) {
+					lastInput = frame.inputTime;
+					auto latency = std::chrono::steady_clock::now() - frame.inputTime;
+					m_LastInputLatency.store(std::chrono::duration_cast<std::chrono::microseconds>(latency).count(), std::memory_order_relaxed);
+				}
+			}
+			// Pace to composition; without DWM fall back to a fixed interval
+			if (FAILED(GetDwmApi().DwmFlush())) {
+				std::this_thread::sleep_for(m_FallbackInterval);
+			}
+		}
+		ReleaseDC(m_Window, windowDC);
+	}
+
+	void CreateBuffer(RenderBuffer& buffer, int width, int height) {
+		buffer.width = width;
+		buffer.height = height;
+		if (width <= 0 || height <= 0) {
+			return;
+		}
+		BITMAPINFO info = {};
+		info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+		info.bmiHeader.biWidth = width;
+		info.bmiHeader.biHeight = -height;
+		info.bmiHeader.biPlanes = 1;
+		info.bmiHeader.biBitCount = 32;
+		info.bmiHeader.biCompression = BI_RGB;
+		buffer.bitmap = TrackGuiObject(CreateDIBSection(NULL, &info, DIB_RGB_COLORS, &buffer.pixels, NULL, 0), GuiObjectType::Bitmap, m_Window, m_Location);
+		if (buffer.bitmap) {
+			buffer.dc = TrackGuiObject(CreateCompatibleDC(NULL), GuiObjectType::DeviceContext, m_Window, m_Location);
+			buffer.previous = SelectObject(buffer.dc, buffer.bitmap);
+			buffer.memory = MemoryCharge(reinterpret_cast<uintptr_t>(m_Window), MemoryCategory::BackBuffer, static_cast<uint64_t>(width) * height * 4);
+		}
+	}
+
+	static void DestroyBuffer(RenderBuffer& buffer) {
+		if (buffer.dc) {
+			SelectObject(buffer.dc, buffer.previous);
+			DeleteTrackedDC(buffer.dc);
+		}
+		if (buffer.bitmap) {
+			DeleteTrackedObject(buffer.bitmap);
+		}
+		buffer = RenderBuffer();
+	}
+
+	HWND m_Window;
+	DrawCallback m_Draw;
+	bool m_Continuous;
+	std::chrono::milliseconds m_FallbackInterval;
+	// Where the thread was created; its back buffers are attributed there
+	std::source_location m_Location;
+	HANDLE m_Wake = NULL;
+
+	// UI thread's working copy
+	RenderSnapshot m_Snapshot;
+	TripleBuffer<RenderSnapshot> m_Snapshots;
+	TripleBuffer<RenderBuffer> m_Frames;
+
+	std::atomic<bool> m_Running{ true };
+	std::atomic<bool> m_RedrawRequested{ false };
+	std::atomic<uint64_t> m_FramesRendered{ 0 };
+	std::atomic<uint64_t> m_FramesPresented{ 0 };
+	std::atomic<uint64_t> m_FramesDropped{ 0 };
+	std::atomic<int64_t> m_LastInputLatency{ 0 };
+
+	std::thread m_Renderer;
+	std::thread m_Presenter;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "../Ipc/FrameRing.hpp"
+
+// Three values of `T` handed from one producer thread to one consumer thread without
+// locks. The producer fills `GetWriteBuffer()` and publishes it; the consumer acquires
+// the newest published value. Neither side ever blocks and intermediate values the
+// consumer did not get to are skipped. Built on the same `FrameRing` protocol that
+// `SharedFrameSurface` uses across processes.
+template <typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() : m_Producer(m_Ring), m_Consumer(m_Ring) {
+		m_Ring.Initialize();
+	}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Direct access to all three values, for setting them up before either thread runs
+	T& operator[](uint32_t index) {
+		return m_Buffers[index];
+	}
+
+	// ---- Producer side ----
+
+	T& GetWriteBuffer() {
+		return m_Buffers[m_Producer.WriteSlot()];
+	}
+
+	// Hands the write buffer to the consumer and returns its sequence number
+	uint64_t Publish() {
+		return m_Producer.Publish();
+	}
+
+	// ---- Consumer side ----
+
+	// Takes the newest published value. Returns false if there is nothing newer.
+	bool Acquire() {
+		return m_Consumer.Acquire();
+	}
+
+	// Value last acquired, or nullptr before the first one
+	T* GetReadBuffer() {
+		uint32_t slot = m_Consumer.ReadSlot();
+		return slot == FrameRing::kNoFrame ? nullptr : &m_Buffers[slot];
+	}
+
+	uint64_t GetReadSequence() const {
+		return m_Consumer.ReadSequence();
+	}
+
+	// Values published but replaced before the consumer acquired them
+	uint64_t GetDroppedCount() const {
+		return m_Consumer.DroppedFrames();
+	}
+
+	// ---- Either side ----
+
+	bool HasNewValue() const {
+		return m_Ring.HasNewFrame();
+	}
+
+	uint64_t GetPublishedSequence() const {
+		return m_Ring.PublishedSequence();
+	}
+
+private:
+	FrameRing m_Ring;
+	// Each side on its own cache line
+	alignas(64) FrameProducer m_Producer;
+	alignas(64) FrameConsumer m_Consumer;
+	T m_Buffers[FrameRing::kSlotCount];
+};
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <atomic>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <stdint.h>
+
+// Stand-ins for the Win32 types the tables use. Off Windows there is nothing to resolve:
+// every table is the stub table made of the fallbacks below, or a test's override, so
+// the tables and the code written against them build and run in Linux tests.
+typedef unsigned int UINT;
+typedef int BOOL;
+typedef uint32_t DWORD;
+typedef int32_t HRESULT;
+typedef void* PVOID;
+typedef const void* LPCVOID;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef const char* LPCSTR;
+typedef const wchar_t* LPCWSTR;
+typedef struct HWND__* HWND;
+typedef struct HMONITOR__* HMONITOR;
+typedef struct DPI_AWARENESS_CONTEXT__* DPI_AWARENESS_CONTEXT;
+typedef struct tagRECT {
+	int32_t left;
+	int32_t top;
+	int32_t right;
+	int32_t bottom;
+} RECT, *LPRECT;
+
+#define WINAPI
+#define TRUE 1
+#define FALSE 0
+#define S_OK ((HRESULT)0)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define USER_DEFAULT_SCREEN_DPI 96
+#endif
+
+// Function pointer tables for Win32 entry points that are not available on every
+// supported Windows version. Nothing here is imported statically, so the binary still
+// loads on systems that lack them. Each table is resolved once, on first use, through
+// `GetProcAddress`; missing entries are replaced by fallbacks so callers never have to
+// check for null and every use is a single indirect call.
+
+// Entry points exported by user32.dll (Windows 10 1607+)
+struct User32Api {
+	using GetDpiForWindowFn = UINT(WINAPI*)(HWND);
+	using GetDpiForSystemFn = UINT(WINAPI*)();
+	using SetProcessDpiAwarenessContextFn = BOOL(WINAPI*)(DPI_AWARENESS_CONTEXT);
+	using AdjustWindowRectExForDpiFn = BOOL(WINAPI*)(LPRECT, DWORD, BOOL, DWORD, UINT);
+	using GetSystemMetricsForDpiFn = int(WINAPI*)(int, UINT);
+
+	GetDpiForWindowFn GetDpiForWindow;
+	GetDpiForSystemFn GetDpiForSystem;
+	SetProcessDpiAwarenessContextFn SetProcessDpiAwarenessContext;
+	AdjustWindowRectExForDpiFn AdjustWindowRectExForDpi;
+	GetSystemMetricsForDpiFn GetSystemMetricsForDpi;
+
+	// True when the entry was found in user32 rather than replaced by a fallback
+	bool hasPerMonitorDpi;
+};
+
+// Entry points exported by dwmapi.dll. The library is only loaded the first time this
+// table is requested, so processes that never touch DWM do not pay for it at startup.
+struct DwmApi {
+	using DwmGetWindowAttributeFn = HRESULT(WINAPI*)(HWND, DWORD, PVOID, DWORD);
+	using DwmSetWindowAttributeFn = HRESULT(WINAPI*)(HWND, DWORD, LPCVOID, DWORD);
+	using DwmFlushFn = HRESULT(WINAPI*)();
+	using DwmIsCompositionEnabledFn = HRESULT(WINAPI*)(BOOL*);
+
+	DwmGetWindowAttributeFn DwmGetWindowAttribute;
+	DwmSetWindowAttributeFn DwmSetWindowAttribute;
+	DwmFlushFn DwmFlush;
+	DwmIsCompositionEnabledFn DwmIsCompositionEnabled;
+
+	// True when dwmapi.dll could be loaded
+	bool available;
+};
+
+// Entry points exported by shcore.dll (Windows 8.1+), loaded on first use
+struct ShcoreApi {
+	// The second parameter is a MONITOR_DPI_TYPE; 0 is MDT_EFFECTIVE_DPI
+	using GetDpiForMonitorFn = HRESULT(WINAPI*)(HMONITOR, int, UINT*, UINT*);
+
+	GetDpiForMonitorFn GetDpiForMonitor;
+
+	// True when the entry was found in shcore rather than replaced by a fallback
+	bool hasPerMonitorDpi;
+};
+
+// Entry points exported by dbghelp.dll, loaded on first use. The dump type and the
+// optional exception, user stream and callback parameters are passed untyped so this
+// header does not need dbghelp.h.
+struct DbgHelpApi {
+	using MiniDumpWriteDumpFn = BOOL(WINAPI*)(HANDLE, DWORD, HANDLE, DWORD, PVOID, PVOID, PVOID);
+
+	MiniDumpWriteDumpFn MiniDumpWriteDump;
+
+	// True when dbghelp.dll could be loaded
+	bool available;
+};
+
+namespace ApiFallbacks {
+	// System DPI, read once from the screen DC and cached
+	inline UINT CachedSystemDpi() {
+#ifdef _WIN32
+		static const UINT dpi = [] {
+			UINT value = USER_DEFAULT_SCREEN_DPI;
+			if (HDC dc = GetDC(NULL)) {
+				value = static_cast<UINT>(GetDeviceCaps(dc, LOGPIXELSX));
+				ReleaseDC(NULL, dc);
+			}
+			return value;
+		}();
+		return dpi;
+#else
+		return USER_DEFAULT_SCREEN_DPI;
+#endif
+	}
+
+	inline UINT WINAPI GetDpiForWindow(HWND) {
+		return CachedSystemDpi();
+	}
+
+	inline UINT WINAPI GetDpiForSystem() {
+		return CachedSystemDpi();
+	}
+
+	inline BOOL WINAPI SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT) {
+#ifdef _WIN32
+		// Best we can do before per-monitor awareness exists: system aware
+		return SetProcessDPIAware();
+#else
+		return FALSE;
+#endif
+	}
+
+	inline BOOL WINAPI AdjustWindowRectExForDpi([[maybe_unused]] LPRECT rect, [[maybe_unused]] DWORD style, [[maybe_unused]] BOOL menu, [[maybe_unused]] DWORD exStyle, UINT) {
+#ifdef _WIN32
+		return AdjustWindowRectEx(rect, style, menu, exStyle);
+#else
+		// No frame to add
+		return TRUE;
+#endif
+	}
+
+	inline int WINAPI GetSystemMetricsForDpi([[maybe_unused]] int index, UINT) {
+#ifdef _WIN32
+		return GetSystemMetrics(index);
+#else
+		return 0;
+#endif
+	}
+
+	inline HRESULT WINAPI DwmGetWindowAttribute(HWND, DWORD, PVOID, DWORD) {
+		return E_NOTIMPL;
+	}
+
+	inline HRESULT WINAPI DwmSetWindowAttribute(HWND, DWORD, LPCVOID, DWORD) {
+		return E_NOTIMPL;
+	}
+
+	inline HRESULT WINAPI DwmFlush() {
+		return E_NOTIMPL;
+	}
+
+	inline HRESULT WINAPI DwmIsCompositionEnabled(BOOL* enabled) {
+		if (enabled) {
+			*enabled = FALSE;
+		}
+		return S_OK;
+	}
+
+	inline HRESULT WINAPI GetDpiForMonitor(HMONITOR, int, UINT* dpiX, UINT* dpiY) {
+		*dpiX = *dpiY = CachedSystemDpi();
+		return S_OK;
+	}
+
+	inline BOOL WINAPI MiniDumpWriteDump(HANDLE, DWORD, HANDLE, DWORD, PVOID, PVOID, PVOID) {
+#ifdef _WIN32
+		SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
+#endif
+		return FALSE;
+	}
+
+	// Module already loaded into the process, or null
+	inline HMODULE FindSystemModule(LPCWSTR name) {
+#ifdef _WIN32
+		return GetModuleHandleW(name);
+#else
+		(void)name;
+		return nullptr;
+#endif
+	}
+
+	// Loads a module from System32, or returns null. The module is intentionally never
+	// freed; the tables live for the whole process.
+	inline HMODULE LoadSystemModule(LPCWSTR name) {
+#ifdef _WIN32
+		return LoadLibraryExW(name, NULL, LOAD_LIBRARY_SEARCH_SYSTEM32);
+#else
+		(void)name;
+		return nullptr;
+#endif
+	}
+
+	template <typename Fn>
+	inline Fn Resolve(HMODULE module, LPCSTR name, Fn fallback) {
+#ifdef _WIN32
+		if (module) {
+			if (FARPROC proc = GetProcAddress(module, name)) {
+				return reinterpret_cast<Fn>(proc);
+			}
+		}
+#else
+		(void)module;
+		(void)name;
+#endif
+		return fallback;
+	}
+
+	inline User32Api ResolveUser32() {
+		HMODULE user32 = FindSystemModule(L"user32.dll");
+		User32Api api = {};
+		api.GetDpiForWindow = Resolve(user32, "GetDpiForWindow", &ApiFallbacks::GetDpiForWindow);
+		api.GetDpiForSystem = Resolve(user32, "GetDpiForSystem", &ApiFallbacks::GetDpiForSystem);
+		api.SetProcessDpiAwarenessContext = Resolve(user32, "SetProcessDpiAwarenessContext", &ApiFallbacks::SetProcessDpiAwarenessContext);
+		api.AdjustWindowRectExForDpi = Resolve(user32, "AdjustWindowRectExForDpi", &ApiFallbacks::AdjustWindowRectExForDpi);
+		api.GetSystemMetricsForDpi = Resolve(user32, "GetSystemMetricsForDpi", &ApiFallbacks::GetSystemMetricsForDpi);
+		api.hasPerMonitorDpi = api.GetDpiForWindow != &ApiFallbacks::GetDpiForWindow;
+		return api;
+	}
+
+	inline DwmApi ResolveDwm() {
+		HMODULE dwm = LoadSystemModule(L"dwmapi.dll");
+		DwmApi api = {};
+		api.DwmGetWindowAttribute = Resolve(dwm, "DwmGetWindowAttribute", &ApiFallbacks::DwmGetWindowAttribute);
+		api.DwmSetWindowAttribute = Resolve(dwm, "DwmSetWindowAttribute", &ApiFallbacks::DwmSetWindowAttribute);
+		api.DwmFlush = Resolve(dwm, "DwmFlush", &ApiFallbacks::DwmFlush);
+		api.DwmIsCompositionEnabled = Resolve(dwm, "DwmIsCompositionEnabled", &ApiFallbacks::DwmIsCompositionEnabled);
+		api.available = dwm != NULL;
+		return api;
+	}
+
+	inline ShcoreApi ResolveShcore() {
+		HMODULE shcore = LoadSystemModule(L"shcore.dll");
+		ShcoreApi api = {};
+		api.GetDpiForMonitor = Resolve(shcore, "GetDpiForMonitor", &ApiFallbacks::GetDpiForMonitor);
+		api.hasPerMonitorDpi = api.GetDpiForMonitor != &ApiFallbacks::GetDpiForMonitor;
+		return api;
+	}
+
+	inline DbgHelpApi ResolveDbgHelp() {
+		HMODULE dbghelp = LoadSystemModule(L"dbghelp.dll");
+		DbgHelpApi api = {};
+		api.MiniDumpWriteDump = Resolve(dbghelp, "MiniDumpWriteDump", &ApiFallbacks::MiniDumpWriteDump);
+		api.available = dbghelp != NULL;
+		return api;
+	}
+
+	inline std::atomic<const User32Api*>& User32Override() {
+		static std::atomic<const User32Api*> table{ nullptr };
+		return table;
+	}
+
+	inline std::atomic<const DwmApi*>& DwmOverride() {
+		static std::atomic<const DwmApi*> table{ nullptr };
+		return table;
+	}
+
+	inline std::atomic<const ShcoreApi*>& ShcoreOverride() {
+		static std::atomic<const ShcoreApi*> table{ nullptr };
+		return table;
+	}
+
+	inline std::atomic<const DbgHelpApi*>& DbgHelpOverride() {
+		static std::atomic<const DbgHelpApi*> table{ nullptr };
+		return table;
+	}
+}
+
+// Returns the user32 table, resolving it on first call
+inline const User32Api& GetUser32Api() {
+	if (const User32Api* table = ApiFallbacks::User32Override().load(std::memory_order_acquire)) {
+		return *table;
+	}
+	static const User32Api table = ApiFallbacks::ResolveUser32();
+	return table;
+}
+
+// Returns the dwmapi table, loading dwmapi.dll on first call
+inline const DwmApi& GetDwmApi() {
+	if (const DwmApi* table = ApiFallbacks::DwmOverride().load(std::memory_order_acquire)) {
+		return *table;
+	}
+	static const DwmApi table = ApiFallbacks::ResolveDwm();
+	return table;
+}
+
+// Returns the shcore table, loading shcore.dll on first call
+inline const ShcoreApi& GetShcoreApi() {
+	if (const ShcoreApi* table = ApiFallbacks::ShcoreOverride().load(std::memory_order_acquire)) {
+		return *table;
+	}
+	static const ShcoreApi table = ApiFallbacks::ResolveShcore();
+	return table;
+}
+
+// Returns the dbghelp table, loading dbghelp.dll on first call
+inline const DbgHelpApi& GetDbgHelpApi() {
+	if (const DbgHelpApi* table = ApiFallbacks::DbgHelpOverride().load(std::memory_order_acquire)) {
+		return *table;
+	}
+	static const DbgHelpApi table = ApiFallbacks::ResolveDbgHelp();
+	return table;
+}
+
+// Replaces the resolved tables with caller-owned stubs, e.g. for tests. Pass nullptr to
+// go back to the real entry points. The table must outlive every call made through it.
+inline void OverrideUser32Api(const User32Api* table) {
+	ApiFallbacks::User32Override().store(table, std::memory_order_release);
+}
+
+inline void OverrideDwmApi(const DwmApi* table) {
+	ApiFallbacks::DwmOverride().store(table, std::memory_order_release);
+}
+
+inline void OverrideShcoreApi(const ShcoreApi* table) {
+	ApiFallbacks::ShcoreOverride().store(table, std::memory_order_release);
+}
+
+inline void OverrideDbgHelpApi(const DbgHelpApi* table) {
+	ApiFallbacks::DbgHelpOverride().store(table, std::memory_order_release);
+}
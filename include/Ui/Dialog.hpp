@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <windows.h>
+
+#include "DialogTemplate.hpp"
+
+// Creates a modeless dialog and all of its controls from an in-memory template in one
+// `CreateDialogIndirectParam` call. The template is encoded on first use and reused by
+// later calls.
+inline HWND CreateDialogFromTemplate(const DialogTemplate& dialogTemplate, HINSTANCE hInstance, HWND parent, DLGPROC procedure, LPARAM param = 0) {
+	const std::vector<uint8_t>& data = dialogTemplate.GetData();
+	HWND dialog = CreateDialogIndirectParam(hInstance, reinterpret_cast<LPCDLGTEMPLATE>(data.data()), parent, procedure, param);
+	if (!dialog) {
+		DWORD error = GetLastError();
+		throw std::runtime_error("Failed to create dialog. Error code: " + std::to_string(error));
+	}
+	return dialog;
+}
+
+// Runs a modal dialog from an in-memory template; returns the value passed to `EndDialog`
+inline INT_PTR ShowDialogFromTemplate(const DialogTemplate& dialogTemplate, HINSTANCE hInstance, HWND parent, DLGPROC procedure, LPARAM param = 0) {
+	const std::vector<uint8_t>& data = dialogTemplate.GetData();
+	INT_PTR result = DialogBoxIndirectParam(hInstance, reinterpret_cast<LPCDLGTEMPLATE>(data.data()), parent, procedure, param);
+	if (result == -1) {
+		DWORD error = GetLastError();
+		throw std::runtime_error("Failed to show dialog. Error code: " + std::to_string(error));
+	}
+	return result;
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <string_view>
+
+#include "../Diagnostics/MemoryLedger.hpp"
+
+// Predefined control classes, encoded as ordinals instead of names
+enum class DialogClass : uint16_t {
+	Button = 0x0080,
+	Edit = 0x0081,
+	Static = 0x0082,
+	ListBox = 0x0083,
+	ScrollBar = 0x0084,
+	ComboBox = 0x0085,
+};
+
+// Builds an extended dialog template (`DLGTEMPLATEEX` followed by `DLGITEMTEMPLATEEX`
+// records) in memory, so a dialog generated at runtime is created with all of its
+// controls by a single `CreateDialogIndirectParam` call (see `Dialog.hpp`). Coordinates
+// are dialog units. The encoded template is cached until the builder is modified, so a
+// template kept around creates any number of dialogs without being re-encoded; the
+// cached bytes are charged to the memory ledger. Platform independent.
+class DialogTemplate {
+public:
+	static constexpr uint32_t kChildStyle = 0x40000000;		// WS_CHILD
+	static constexpr uint32_t kSetFontStyle = 0x00000040;	// DS_SETFONT
+
+	DialogTemplate(std::wstring_view title, int16_t x, int16_t y, int16_t width, int16_t height, uint32_t style, uint32_t exStyle = 0)
+		: m_Title(title), m_X(x), m_Y(y), m_Width(width), m_Height(height), m_Style(style), m_ExStyle(exStyle) {}
+
+	// Font for the dialog and its controls; sets `DS_SETFONT`
+	DialogTemplate& SetFont(std::wstring_view typeface, uint16_t pointSize, uint16_t weight = 400, bool italic = false, uint8_t charset = 1 /* DEFAULT_CHARSET */) {
+		m_Typeface = typeface;
+		m_PointSize = pointSize;
+		m_Weight = weight;
+		m_Italic = italic;
+		m_Charset = charset;
+		m_Style |= kSetFontStyle;
+		m_Encoded.Clear();
+		return *this;
+	}
+
+	// Registered window class for the dialog itself, instead of the system dialog class
+	DialogTemplate& SetClass(std::wstring_view className) {
+		m_ClassName = className;
+		m_Encoded.Clear();
+		return *this;
+	}
+
+	// Menu resource ordinal
+	DialogTemplate& SetMenu(uint16_t menu) {
+		m_Menu = menu;
+		m_Encoded.Clear();
+		return *this;
+	}
+
+	// Adds a control of a predefined class. `WS_CHILD` is always added to `style`;
+	// include `WS_VISIBLE` for controls that should start visible.
+	DialogTemplate& AddControl(DialogClass type, std::wstring_view text, uint32_t id, int16_t x, int16_t y, int16_t width, int16_t height, uint32_t style, uint32_t exStyle = 0) {
+		Item item = MakeItem(text, id, x, y, width, height, style, exStyle);
+		item.ordinal = static_cast<uint16_t>(type);
+		m_Items.push_back(std::move(item));
+		m_Encoded.Clear();
+		return *this;
+	}
+
+	// Adds a control of a registered window class
+	DialogTemplate& AddControl(std::wstring_view className, std::wstring_view text, uint32_t id, int16_t x, int16_t y, int16_t width, int16_t height, uint32_t style, uint32_t exStyle = 0) {
+		Item item = MakeItem(text, id, x, y, width, height, style, exStyle);
+		item.className = className;
+		m_Items.push_back(std::move(item));
+		m_Encoded.Clear();
+		return *this;
+	}
+
+	size_t GetControlCount() const {
+		return m_Items.size();
+	}
+
+	// The encoded template; DWORD-aligned, as `CreateDialogIndirectParam` requires
+	const std::vector<uint8_t>& GetData() const {
+		if (m_Encoded.bytes.empty()) {
+			Encode();
+		}
+		return m_Encoded.bytes;
+	}
+
+private:
+	struct Item {
+		std::wstring className;
+		uint16_t ordinal = 0;
+		std::wstring text;
+		uint32_t id;
+		int16_t x, y, width, height;
+		uint32_t style;
+		uint32_t exStyle;
+	};
+
+	// The encoded bytes and their charge. Copies of a template start without them and
+	// encode on first use.
+	struct EncodedCache {
+		EncodedCache() = default;
+
+		EncodedCache(const EncodedCache&) {}
+
+		EncodedCache& operator=(const EncodedCache&) {
+			Clear();
+			return *this;
+		}
+
+		// Keeps the capacity for the next encoding, so the charge stays too
+		void Clear() {
+			bytes.clear();
+		}
+
+		std::vector<uint8_t> bytes;
+		MemoryCharge memory{ 0, MemoryCategory::Cache, 0 };
+	};
+
+	static Item MakeItem(std::wstring_view text, uint32_t id, int16_t x, int16_t y, int16_t width, int16_t height, uint32_t style, uint32_t exStyle) {
+		Item item;
+		item.text = text;
+		item.id = id;
+		item.x = x;
+		item.y = y;
+		item.width = width;
+		item.height = height;
+		item.style = style | kChildStyle;
+		item.exStyle = exStyle;
+		return item;
+	}
+
+	void Encode() const {
+		if (m_Items.size() > UINT16_MAX) {
+			throw std::runtime_error("Failed to encode dialog template: too many controls.");
+		}
+		std::vector<uint8_t>& out = m_Encoded.bytes;
+		out.reserve(64 + m_Items.size() * 48);
+
+		// DLGTEMPLATEEX
+		Write16(out, 1);		// dlgVer
+		Write16(out, 0xFFFF);	// signature
+		Write32(out, 0);		// helpID
+		Write32(out, m_ExStyle);
+		Write32(out, m_Style);
+		Write16(out, static_cast<uint16_t>(m_Items.size()));
+		WriteCoordinates(out, m_X, m_Y, m_Width, m_Height);
+		if (m_Menu) {
+			Write16(out, 0xFFFF);
+			Write16(out, m_Menu);
+		}
+		else {
+			Write16(out, 0);
+		}
+		if (m_ClassName.empty()) {
+			Write16(out, 0);
+		}
+		else {
+			WriteString(out, m_ClassName);
+		}
+		WriteString(out, m_Title);
+		if (m_Style & kSetFontStyle) {
+			Write16(out, m_PointSize);
+			Write16(out, m_Weight);
+			out.push_back(m_Italic ? 1 : 0);
+			out.push_back(m_Charset);
+			WriteString(out, m_Typeface);
+		}
+
+		// DLGITEMTEMPLATEEX, each DWORD-aligned
+		for (const Item& item : m_Items) {
+			Align(out);
+			Write32(out, 0);	// helpID
+			Write32(out, item.exStyle);
+			Write32(out, item.style);
+			WriteCoordinates(out, item.x, item.y, item.width, item.height);
+			Write32(out, item.id);
+			if (item.ordinal) {
+				Write16(out, 0xFFFF);
+				Write16(out, item.ordinal);
+			}
+			else {
+				WriteString(out, item.className);
+			}
+			WriteString(out, item.text);
+			Write16(out, 0);	// extraCount
+		}
+		Align(out);
+		m_Encoded.memory.Resize(out.capacity());
+	}
+
+	static void Write16(std::vector<uint8_t>& out, uint16_t value) {
+		out.push_back(static_cast<uint8_t>(value));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+	}
+
+	static void Write32(std::vector<uint8_t>& out, uint32_t value) {
+		Write16(out, static_cast<uint16_t>(value));
+		Write16(out, static_cast<uint16_t>(value >> 16));
+	}
+
+	static void WriteCoordinates(std::vector<uint8_t>& out, int16_t x, int16_t y, int16_t width, int16_t height) {
+		Write16(out, static_cast<uint16_t>(x));
+		Write16(out, static_cast<uint16_t>(y));
+		Write16(out, static_cast<uint16_t>(width));
+		Write16(out, static_cast<uint16_t>(height));
+	}
+
+	// Null-terminated UTF-16; `wchar_t` is UTF-32 outside Windows
+	static void WriteString(std::vector<uint8_t>& out, const std::wstring& text) {
+		for (wchar_t c : text) {
+			uint32_t code = static_cast<uint32_t>(c);
+			if (code >= 0x10000) {
+				code -= 0x10000;
+				Write16(out, static_cast<uint16_t>(0xD800 + (code >> 10)));
+				Write16(out, static_cast<uint16_t>(0xDC00 + (code & 0x3FF)));
+			}
+			else {
+				Write16(out, static_cast<uint16_t>(code));
+			}
+		}
+		Write16(out, 0);
+	}
+
+	static void Align(std::vector<uint8_t>& out) {
+		while (out.size() % 4) {
+			out.push_back(0);
+		}
+	}
+
+	std::wstring m_Title;
+	int16_t m_X, m_Y, m_Width, m_Height;
+	uint32_t m_Style;
+	uint32_t m_ExStyle;
+	std::wstring m_ClassName;
+	uint16_t m_Menu = 0;
+	std::wstring m_Typeface;
+	uint16_t m_PointSize = 0;
+	uint16_t m_Weight = 400;
+	bool m_Italic = false;
+	uint8_t m_Charset = 1;
+	std::vector<Item> m_Items;
+	mutable EncodedCache m_Encoded;
+};
@@ -0,0 +1,395 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+// Binary UI description, as written by `UiLayoutCompiler` and read in place by
+// `UiLayoutView`. The layout is a header, the nodes in pre-order (a parent always comes
+// before its children) and a pool of null-terminated UTF-16 strings. Everything is
+// little-endian and 4-byte aligned, so a memory-mapped file can be used without copying.
+//
+//	[UiLayoutHeader][UiLayoutNode x nodeCount][char16_t x stringUnits]
+
+constexpr uint32_t kUiLayoutMagic = 0x4C495557; // "WUIL"
+constexpr uint16_t kUiLayoutVersion = 1;
+constexpr uint32_t kUiNoParent = UINT32_MAX;
+constexpr uint32_t kUiNoString = UINT32_MAX;
+
+struct UiLayoutHeader {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t nodeSize;
+	uint32_t nodeCount;
+	// Size of the string pool in UTF-16 code units
+	uint32_t stringUnits;
+};
+
+enum UiNodeFlags : uint32_t {
+	UiNodeHidden = 1 << 0,
+	UiNodeDisabled = 1 << 1,
+};
+
+// One control. Geometry is in 96 DPI pixels relative to the parent's client area.
+struct UiLayoutNode {
+	// Index of the parent node, `kUiNoParent` for controls placed directly on the host
+	uint32_t parent;
+	// Offsets into the string pool, in code units
+	uint32_t className;
+	uint32_t text;
+	uint32_t style;
+	uint32_t exStyle;
+	uint32_t flags;
+	int32_t x;
+	int32_t y;
+	int32_t width;
+	int32_t height;
+	uint32_t id;
+	uint32_t childCount;
+};
+
+static_assert(sizeof(UiLayoutHeader) == 16, "UiLayoutHeader must stay 16 bytes");
+static_assert(sizeof(UiLayoutNode) == 48, "UiLayoutNode must stay 48 bytes");
+
+// Read-only view of a binary UI description. Validates the whole description up front,
+// so instantiation code can index nodes and strings without further checks. Does not
+// own the memory.
+class UiLayoutView {
+public:
+	UiLayoutView(const void* data, size_t size) {
+		if (reinterpret_cast<uintptr_t>(data) % alignof(UiLayoutNode)) {
+			throw std::runtime_error("Invalid UI description: data is not 4-byte aligned.");
+		}
+		if (size < sizeof(UiLayoutHeader)) {
+			throw std::runtime_error("Invalid UI description: truncated header.");
+		}
+		const UiLayoutHeader* header = static_cast<const UiLayoutHeader*>(data);
+		if (header->magic != kUiLayoutMagic || header->version != kUiLayoutVersion || header->nodeSize != sizeof(UiLayoutNode)) {
+			throw std::runtime_error("Invalid UI description: unknown format or version.");
+		}
+		uint64_t expected = sizeof(UiLayoutHeader) + static_cast<uint64_t>(header->nodeCount) * sizeof(UiLayoutNode) + static_cast<uint64_t>(header->stringUnits) * sizeof(char16_t);
+		if (size < expected) {
+			throw std::runtime_error("Invalid UI description: truncated body.");
+		}
+		m_Nodes = reinterpret_cast<const UiLayoutNode*>(header + 1);
+		m_NodeCount = header->nodeCount;
+		m_Strings = reinterpret_cast<const char16_t*>(m_Nodes + m_NodeCount);
+		m_StringUnits = header->stringUnits;
+
+		// A terminated pool means every in-range offset reads a terminated string
+		if (m_StringUnits && m_Strings[m_StringUnits - 1] != 0) {
+			throw std::runtime_error("Invalid UI description: unterminated string pool.");
+		}
+		for (uint32_t i = 0; i < m_NodeCount; ++i) {
+			const UiLayoutNode& node = m_Nodes[i];
+			if (node.parent != kUiNoParent && node.parent >= i) {
+				throw std::runtime_error("Invalid UI description: node " + std::to_string(i) + " precedes its parent.");
+			}
+			if (node.className >= m_StringUnits || (node.text != kUiNoString && node.text >= m_StringUnits)) {
+				throw std::runtime_error("Invalid UI description: node " + std::to_string(i) + " has a string out of range.");
+			}
+		}
+	}
+
+	size_t GetNodeCount() const {
+		return m_NodeCount;
+	}
+
+	const UiLayoutNode& GetNode(size_t index) const {
+		return m_Nodes[index];
+	}
+
+	const UiLayoutNode* begin() const {
+		return m_Nodes;
+	}
+
+	const UiLayoutNode* end() const {
+		return m_Nodes + m_NodeCount;
+	}
+
+	// Null-terminated string at `offset`; empty for `kUiNoString`
+	const char16_t* GetString(uint32_t offset) const {
+		return offset == kUiNoString ? u"" : m_Strings + offset;
+	}
+
+private:
+	const UiLayoutNode* m_Nodes = nullptr;
+	uint32_t m_NodeCount = 0;
+	const char16_t* m_Strings = nullptr;
+	uint32_t m_StringUnits = 0;
+};
+
+// Compiles the text form of a UI description into the binary form. One control per line:
+//
+//	# comments run to the end of the line
+//	Static "User name:" x=8 y=10 w=80 h=14
+//	Edit id=100 x=92 y=8 w=160 h=18 style=0x00810080
+//	Button "Options" id=3 x=8 y=40 w=244 h=80 style=0x7 {
+//		Button "Fast" id=4 x=8 y=16 w=100 h=16 style=0x9 disabled
+//	}
+//
+// The first word is the window class, an optional quoted string the text, followed by
+// `id`, `x`, `y`, `w`, `h`, `style` and `exstyle` (decimal or 0x hex) and the `hidden`
+// and `disabled` flags. A trailing `{` makes the following lines children of the
+// control, up to the matching `}`. The input is UTF-8. Errors throw with the line number.
+class UiLayoutCompiler {
+public:
+	static std::vector<uint8_t> Compile(std::string_view text) {
+		UiLayoutCompiler compiler;
+		compiler.Parse(text);
+		return compiler.Emit();
+	}
+
+private:
+	struct Token {
+		enum Kind { Word, String, Open, Close } kind;
+		std::string value;
+	};
+
+	void Parse(std::string_view text) {
+		std::vector<uint32_t> open;
+		size_t lineNumber = 0;
+		while (!text.empty()) {
+			size_t end = text.find('\n');
+			std::string_view line = text.substr(0, end);
+			text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+			++lineNumber;
+			m_Line = lineNumber;
+
+			std::vector<Token> tokens = Tokenize(line);
+			if (tokens.empty()) {
+				continue;
+			}
+			if (tokens[0].kind == Token::Close) {
+				if (tokens.size() != 1) {
+					Fail("'}' must be on its own line");
+				}
+				if (open.empty()) {
+					Fail("unmatched '}'");
+				}
+				open.pop_back();
+				continue;
+			}
+			if (tokens[0].kind != Token::Word) {
+				Fail("expected a window class");
+			}
+
+			UiLayoutNode node = {};
+			node.parent = open.empty() ? kUiNoParent : open.back();
+			node.className = Intern(tokens[0].value);
+			node.text = kUiNoString;
+			size_t next = 1;
+			if (next < tokens.size() && tokens[next].kind == Token::String) {
+				node.text = Intern(tokens[next].value);
+				++next;
+			}
+			bool opens = false;
+			for (; next < tokens.size(); ++next) {
+				const Token& token = tokens[next];
+				if (token.kind == Token::Open) {
+					if (next + 1 != tokens.size()) {
+						Fail("'{' must end the line");
+					}
+					opens = true;
+				}
+				else if (token.kind == Token::Word) {
+					ApplyAttribute(node, token.value);
+				}
+				else {
+					Fail("unexpected token");
+				}
+			}
+
+			uint32_t index = static_cast<uint32_t>(m_Nodes.size());
+			if (node.parent != kUiNoParent) {
+				++m_Nodes[node.parent].childCount;
+			}
+			m_Nodes.push_back(node);
+			if (opens) {
+				open.push_back(index);
+			}
+		}
+		if (!open.empty()) {
+			m_Line = lineNumber;
+			Fail("missing '}'");
+		}
+	}
+
+	std::vector<Token> Tokenize(std::string_view line) {
+		std::vector<Token> tokens;
+		size_t i = 0;
+		while (i < line.size()) {
+			char c = line[i];
+			if (c == ' ' || c == '\t' || c == '\r') {
+				++i;
+			}
+			else if (c == '#') {
+				break;
+			}
+			else if (c == '{' || c == '}') {
+				tokens.push_back({ c == '{' ? Token::Open : Token::Close, std::string() });
+				++i;
+			}
+			else if (c == '"') {
+				std::string value;
+				++i;
+				for (;;) {
+					if (i >= line.size()) {
+						Fail("unterminated string");
+					}
+					char current = line[i++];
+					if (current == '"') {
+						break;
+					}
+					if (current == '\\' && i < line.size()) {
+						char escaped = line[i++];
+						current = escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped;
+					}
+					value += current;
+				}
+				tokens.push_back({ Token::String, std::move(value) });
+			}
+			else {
+				size_t start = i;
+				while (i < line.size() && !strchr(" \t\r{}\"#", line[i])) {
+					++i;
+				}
+				tokens.push_back({ Token::Word, std::string(line.substr(start, i - start)) });
+			}
+		}
+		return tokens;
+	}
+
+	void ApplyAttribute(UiLayoutNode& node, const std::string& attribute) {
+		if (attribute == "hidden") {
+			node.flags |= UiNodeHidden;
+			return;
+		}
+		if (attribute == "disabled") {
+			node.flags |= UiNodeDisabled;
+			return;
+		}
+		size_t equals = attribute.find('=');
+		if (equals == std::string::npos) {
+			Fail("unknown flag '" + attribute + "'");
+		}
+		std::string key = attribute.substr(0, equals);
+		int64_t value = ParseNumber(attribute.substr(equals + 1));
+		if (key == "id") node.id = static_cast<uint32_t>(value);
+		else if (key == "x") node.x = static_cast<int32_t>(value);
+		else if (key == "y") node.y = static_cast<int32_t>(value);
+		else if (key == "w") node.width = static_cast<int32_t>(value);
+		else if (key == "h") node.height = static_cast<int32_t>(value);
+		else if (key == "style") node.style = static_cast<uint32_t>(value);
+		else if (key == "exstyle") node.exStyle = static_cast<uint32_t>(value);
+		else Fail("unknown attribute '" + key + "'");
+	}
+
+	int64_t ParseNumber(const std::string& text) {
+		size_t i = 0;
+		bool negative = false;
+		if (i < text.size() && text[i] == '-') {
+			negative = true;
+			++i;
+		}
+		unsigned base = 10;
+		if (text.size() - i > 2 && text[i] == '0' && (text[i + 1] == 'x' || text[i + 1] == 'X')) {
+			base = 16;
+			i += 2;
+		}
+		if (i == text.size()) {
+			Fail("invalid number '" + text + "'");
+		}
+		int64_t value = 0;
+		for (; i < text.size(); ++i) {
+			char c = text[i];
+			unsigned digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+			if (digit >= base || value > UINT32_MAX) {
+				Fail("invalid number '" + text + "'");
+			}
+			value = value * base + digit;
+		}
+		return negative ? -value : value;
+	}
+
+	// Adds a string to the pool once and returns its offset
+	uint32_t Intern(const std::string& text) {
+		auto it = m_Interned.find(text);
+		if (it != m_Interned.end()) {
+			return it->second;
+		}
+		uint32_t offset = static_cast<uint32_t>(m_Strings.size());
+		AppendUtf16(text);
+		m_Strings.push_back(0);
+		m_Interned.emplace(text, offset);
+		return offset;
+	}
+
+	void AppendUtf16(const std::string& text) {
+		size_t i = 0;
+		while (i < text.size()) {
+			uint8_t lead = static_cast<uint8_t>(text[i]);
+			size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+			if (!length || i + length > text.size()) {
+				Fail("invalid UTF-8");
+			}
+			uint32_t code = length == 1 ? lead : lead & (0x7F >> length);
+			for (size_t k = 1; k < length; ++k) {
+				uint8_t continuation = static_cast<uint8_t>(text[i + k]);
+				if ((continuation & 0xC0) != 0x80) {
+					Fail("invalid UTF-8");
+				}
+				code = (code << 6) | (continuation & 0x3F);
+			}
+			i += length;
+			if (code >= 0x10000) {
+				code -= 0x10000;
+				m_Strings.push_back(static_cast<char16_t>(0xD800 + (code >> 10)));
+				m_Strings.push_back(static_cast<char16_t>(0xDC00 + (code & 0x3FF)));
+			}
+			else {
+				m_Strings.push_back(static_cast<char16_t>(code));
+			}
+		}
+	}
+
+	std::vector<uint8_t> Emit() const {
+		UiLayoutHeader header = {};
+		header.magic = kUiLayoutMagic;
+		header.version = kUiLayoutVersion;
+		header.nodeSize = sizeof(UiLayoutNode);
+		header.nodeCount = static_cast<uint32_t>(m_Nodes.size());
+		// Pad the pool so that descriptions can be concatenated without breaking alignment
+		std::vector<char16_t> strings = m_Strings;
+		if (strings.size() % 2) {
+			strings.push_back(0);
+		}
+		header.stringUnits = static_cast<uint32_t>(strings.size());
+
+		std::vector<uint8_t> bytes(sizeof(header) + m_Nodes.size() * sizeof(UiLayoutNode) + strings.size() * sizeof(char16_t));
+		uint8_t* out = bytes.data();
+		memcpy(out, &header, sizeof(header));
+		out += sizeof(header);
+		if (!m_Nodes.empty()) {
+			memcpy(out, m_Nodes.data(), m_Nodes.size() * sizeof(UiLayoutNode));
+			out += m_Nodes.size() * sizeof(UiLayoutNode);
+		}
+		if (!strings.empty()) {
+			memcpy(out, strings.data(), strings.size() * sizeof(char16_t));
+		}
+		return bytes;
+	}
+
+	[[noreturn]] void Fail(const std::string& message) const {
+		throw std::runtime_error("UI description line " + std::to_string(m_Line) + ": " + message + ".");
+	}
+
+	std::vector<UiLayoutNode> m_Nodes;
+	std::vector<char16_t> m_Strings;
+	std::unordered_map<std::string, uint32_t> m_Interned;
+	size_t m_Line = 0;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <optional>
+#include <stdexcept>
+#include <windows.h>
+
+#include "UiLayout.hpp"
+
+// Compiled UI description mapped read-only from disk. The view points straight into the
+// mapping, so loading costs one validation pass and the pages are shared between
+// processes showing the same form.
+class UiLayoutFile {
+public:
+	explicit UiLayoutFile(LPCWSTR path) {
+		m_File = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (m_File == INVALID_HANDLE_VALUE) {
+			DWORD error = GetLastError();
+			throw std::runtime_error("Failed to open UI description. Error code: " + std::to_string(error));
+		}
+		LARGE_INTEGER size = {};
+		if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0) {
+			DWORD error = GetLastError();
+			Close();
+			throw std::runtime_error("Failed to read UI description size. Error code: " + std::to_string(error));
+		}
+		m_Mapping = CreateFileMappingW(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!m_Mapping) {
+			DWORD error = GetLastError();
+			Close();
+			throw std::runtime_error("Failed to map UI description. Error code: " + std::to_string(error));
+		}
+		m_Data = MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!m_Data) {
+			DWORD error = GetLastError();
+			Close();
+			throw std::runtime_error("Failed to map UI description. Error code: " + std::to_string(error));
+		}
+		m_Size = static_cast<size_t>(size.QuadPart);
+		try {
+			m_View.emplace(m_Data, m_Size);
+		}
+		catch (...) {
+			Close();
+			throw;
+		}
+	}
+
+	~UiLayoutFile() {
+		Close();
+	}
+
+	UiLayoutFile(const UiLayoutFile&) = delete;
+	UiLayoutFile& operator=(const UiLayoutFile&) = delete;
+
+	const UiLayoutView& GetView() const {
+		return *m_View;
+	}
+
+	size_t GetSize() const {
+		return m_Size;
+	}
+
+private:
+	void Close() {
+		m_View.reset();
+		if (m_Data) {
+			UnmapViewOfFile(m_Data);
+			m_Data = nullptr;
+		}
+		if (m_Mapping) {
+			CloseHandle(m_Mapping);
+			m_Mapping = NULL;
+		}
+		if (m_File != INVALID_HANDLE_VALUE) {
+			CloseHandle(m_File);
+			m_File = INVALID_HANDLE_VALUE;
+		}
+	}
+
+	HANDLE m_File = INVALID_HANDLE_VALUE;
+	HANDLE m_Mapping = NULL;
+	const void* m_Data = nullptr;
+	size_t m_Size = 0;
+	std::optional<UiLayoutView> m_View;
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <windows.h>
+
+#include "UiLayout.hpp"
+#include "../Window/RedrawSuspend.hpp"
+#include "../System/ApiTable.hpp"
+#include "../Diagnostics/MemoryLedger.hpp"
+
+// Where the time of an instantiation went
+struct UiBuildStats {
+	size_t controls = 0;
+	std::chrono::microseconds create{};
+	std::chrono::microseconds layout{};
+	std::chrono::microseconds total{};
+};
+
+// The controls of a UI description, created on a host window in one pass. Redraw of the
+// host is suspended while the controls are created at zero size; their geometry is then
+// committed with one `DeferWindowPos` batch per parent, scaled to the host's DPI, and
+// the host is repainted once. Controls are owned by their parents and go away with the
+// host; `Destroy` removes them earlier. The per-node tables are charged to the host.
+class UiTree {
+public:
+	UiTree(HWND host, const UiLayoutView& layout, HINSTANCE hInstance, HFONT font = NULL) : m_Host(host), m_Memory(reinterpret_cast<uintptr_t>(host), MemoryCategory::Other, 0) {
+		auto start = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point created;
+		{
+			RedrawSuspend suspend(m_Host);
+			CreateControls(layout, hInstance, font);
+			created = std::chrono::steady_clock::now();
+			CommitGeometry(GetUser32Api().GetDpiForWindow(m_Host));
+		}
+		auto finished = std::chrono::steady_clock::now();
+
+		m_Stats.controls = m_Controls.size();
+		m_Stats.create = std::chrono::duration_cast<std::chrono::microseconds>(created - start);
+		m_Stats.layout = std::chrono::duration_cast<std::chrono::microseconds>(finished - created);
+		m_Stats.total = std::chrono::duration_cast<std::chrono::microseconds>(finished - start);
+		UpdateMemory();
+	}
+
+	UiTree(const UiTree&) = delete;
+	UiTree& operator=(const UiTree&) = delete;
+
+	// First control with `id`, or NULL
+	HWND GetControl(uint32_t id) const {
+		auto it = m_ById.find(id);
+		return it == m_ById.end() ? NULL : it->second;
+	}
+
+	// Control created for node `index` of the description
+	HWND GetNode(size_t index) const {
+		return m_Controls[index];
+	}
+
+	size_t GetCount() const {
+		return m_Controls.size();
+	}
+
+	const UiBuildStats& GetStats() const {
+		return m_Stats;
+	}
+
+	// Re-applies the described geometry for `dpi`, e.g. on `WM_DPICHANGED`
+	void Rescale(UINT dpi) {
+		RedrawSuspend suspend(m_Host);
+		CommitGeometry(dpi);
+	}
+
+	// Destroys the controls now rather than with the host
+	void Destroy() {
+		for (size_t i = 0; i < m_Controls.size(); ++i) {
+			// Destroying a control destroys its descendants
+			if (m_Parents[i] == kUiNoParent) {
+				DestroyWindow(m_Controls[i]);
+			}
+		}
+		m_Controls.clear();
+		m_Geometry.clear();
+		m_Parents.clear();
+		m_Batches.clear();
+		m_ById.clear();
+		UpdateMemory();
+	}
+
+private:
+	// Map nodes are counted as their entry plus two pointers
+	void UpdateMemory() {
+		m_Memory.Resize(m_Controls.capacity() * sizeof(HWND) + m_Geometry.capacity() * sizeof(RECT)
+			+ (m_Parents.capacity() + m_Batches.capacity()) * sizeof(uint32_t)
+			+ m_ById.size() * (sizeof(std::pair<const uint32_t, HWND>) + 2 * sizeof(void*)) + m_ById.bucket_count() * sizeof(void*));
+	}
+
+	void CreateControls(const UiLayoutView& layout, HINSTANCE hInstance, HFONT font) {
+		size_t count = layout.GetNodeCount();
+		m_Controls.reserve(count);
+		m_Geometry.reserve(count);
+		m_Parents.reserve(count);
+		for (size_t i = 0; i < count; ++i) {
+			const UiLayoutNode& node = layout.GetNode(i);
+			HWND parent = node.parent == kUiNoParent ? m_Host : m_Controls[node.parent];
+			DWORD style = node.style | WS_CHILD;
+			style |= (node.flags & UiNodeHidden) ? 0 : WS_VISIBLE;
+			style |= (node.flags & UiNodeDisabled) ? WS_DISABLED : 0;
+			HWND control = CreateWindowEx(node.exStyle, reinterpret_cast<LPCWSTR>(layout.GetString(node.className)), reinterpret_cast<LPCWSTR>(layout.GetString(node.text)),
+				style, 0, 0, 0, 0, parent, reinterpret_cast<HMENU>(static_cast<UINT_PTR>(node.id)), hInstance, NULL);
+			if (!control) {
+				DWORD error = GetLastError();
+				Destroy();
+				throw std::runtime_error("Failed to create control " + std::to_string(i) + ". Error code: " + std::to_string(error));
+			}
+			if (font) {
+				SendMessage(control, WM_SETFONT, reinterpret_cast<WPARAM>(font), FALSE);
+			}
+			m_Controls.push_back(control);
+			m_Geometry.push_back({ node.x, node.y, node.x + node.width, node.y + node.height });
+			m_Parents.push_back(node.parent);
+			if (node.id) {
+				m_ById.emplace(node.id, control);
+			}
+		}
+
+		// Siblings are interleaved with their descendants in pre-order; group them once
+		m_Batches.resize(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			m_Batches[i] = i;
+		}
+		std::stable_sort(m_Batches.begin(), m_Batches.end(), [this](uint32_t a, uint32_t b) {
+			return m_Parents[a] + 1 < m_Parents[b] + 1;
+		});
+	}
+
+	// One `DeferWindowPos` batch per run of siblings
+	void CommitGeometry(UINT dpi) {
+		size_t begin = 0;
+		while (begin < m_Batches.size()) {
+			uint32_t parent = m_Parents[m_Batches[begin]];
+			size_t end = begin;
+			while (end < m_Batches.size() && m_Parents[m_Batches[end]] == parent) {
+				++end;
+			}
+			HDWP batch = BeginDeferWindowPos(static_cast<int>(end - begin));
+			for (size_t i = begin; i < end && batch; ++i) {
+				RECT rect = Scale(m_Batches[i], dpi);
+				batch = DeferWindowPos(batch, m_Controls[m_Batches[i]], NULL, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, SWP_NOZORDER | SWP_NOACTIVATE);
+			}
+			if (batch) {
+				EndDeferWindowPos(batch);
+			}
+			else {
+				// A failed batch is discarded as a whole; place the run one by one
+				for (size_t i = begin; i < end; ++i) {
+					RECT rect = Scale(m_Batches[i], dpi);
+					SetWindowPos(m_Controls[m_Batches[i]], NULL, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, SWP_NOZORDER | SWP_NOACTIVATE);
+				}
+			}
+			begin = end;
+		}
+	}
+
+	RECT Scale(uint32_t node, UINT dpi) const {
+		const RECT& rect = m_Geometry[node];
+		return {
+			MulDiv(rect.left, dpi, USER_DEFAULT_SCREEN_DPI),
+			MulDiv(rect.top, dpi, USER_DEFAULT_SCREEN_DPI),
+			MulDiv(rect.right, dpi, USER_DEFAULT_SCREEN_DPI),
+			MulDiv(rect.bottom, dpi, USER_DEFAULT_SCREEN_DPI),
+		};
+	}
+
+	HWND m_Host;
+	std::vector<HWND> m_Controls;
+	// In 96 DPI pixels
+	std::vector<RECT> m_Geometry;
+	std::vector<uint32_t> m_Parents;
+	// Node indices grouped by parent, host children first
+	std::vector<uint32_t> m_Batches;
+	std::unordered_map<uint32_t, HWND> m_ById;
+	UiBuildStats m_Stats;
+	MemoryCharge m_Memory;
+};
@@ -0,0 +1,391 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <optional>
+#include <windows.h>
+#include <wincodec.h>
+#include <wrl/client.h>
+
+#include "../Render/PixelConversion.hpp"
+#include "../Diagnostics/Log.hpp"
+
+// Image in the library's surface format: top-down rows of premultiplied 32-bit BGRA, the
+// layout of DIB sections drawn with `AlphaBlend` and of `SharedFrameSurface` frames
+struct BgraImage {
+	UINT width = 0;
+	UINT height = 0;
+	std::vector<uint32_t> pixels;
+
+	UINT GetStride() const {
+		return width * 4;
+	}
+};
+
+enum ClipboardImageFormats : UINT {
+	ClipboardDibV5 = 1 << 0,
+	ClipboardPng = 1 << 1,
+	ClipboardAllImageFormats = ClipboardDibV5 | ClipboardPng,
+};
+
+// Image copy and paste through `CF_DIBV5` and the registered "PNG" format. Both store
+// straight alpha; DIBs also store rows bottom-up. The conversion from and to the surface
+// format runs through the SIMD kernels of `PixelConversion`, straight into or out of the
+// clipboard memory. PNG goes through WIC, which needs COM on the calling thread; it is
+// initialized for the duration of the call if it is not.
+//
+// Failures are logged and reported through the return value, as for text.
+class ClipboardImage {
+public:
+	static UINT GetPngFormat() {
+		static UINT format = RegisterClipboardFormatW(L"PNG");
+		return format;
+	}
+
+	static bool IsAvailable() {
+		return IsClipboardFormatAvailable(CF_DIBV5) || IsClipboardFormatAvailable(CF_DIB) || IsClipboardFormatAvailable(GetPngFormat());
+	}
+
+	// Replaces the clipboard contents with the image in `formats`
+	static bool Copy(HWND owner, const void* pixels, UINT width, UINT height, UINT stride, UINT formats = ClipboardAllImageFormats) {
+		if (!OpenClipboard(owner)) {
+			LogWarning("Failed to open the clipboard. Error code: {}", GetLastError());
+			return false;
+		}
+		EmptyClipboard();
+		bool copied = false;
+		if (formats & ClipboardDibV5) {
+			copied |= SetData(CF_DIBV5, EncodeDibV5(pixels, width, height, stride));
+		}
+		if (formats & ClipboardPng) {
+			copied |= SetData(GetPngFormat(), EncodePng(pixels, width, height, stride));
+		}
+		CloseClipboard();
+		return copied;
+	}
+
+	// Reads the clipboard image, preferring PNG, then `CF_DIBV5`, then `CF_DIB`
+	static std::optional<BgraImage> Paste(HWND owner) {
+		if (!OpenClipboard(owner)) {
+			LogWarning("Failed to open the clipboard. Error code: {}", GetLastError());
+			return std::nullopt;
+		}
+		std::optional<BgraImage> image;
+		const UINT formats[] = { GetPngFormat(), CF_DIBV5, CF_DIB };
+		for (UINT format : formats) {
+			HANDLE data = IsClipboardFormatAvailable(format) ? GetClipboardData(format) : NULL;
+			const void* bytes = data ? GlobalLock(data) : nullptr;
+			if (!bytes) {
+				continue;
+			}
+			BgraImage decoded;
+			size_t size = GlobalSize(data);
+			bool valid = format == GetPngFormat() ? DecodePng(bytes, size, decoded) : DecodeDib(bytes, size, decoded);
+			GlobalUnlock(data);
+			if (valid) {
+				image = std::move(decoded);
+				break;
+			}
+		}
+		CloseClipboard();
+		return image;
+	}
+
+	// Places `data` while the clipboard is open, or while answering `WM_RENDERFORMAT`.
+	// The clipboard owns the memory on success; it is freed otherwise.
+	static bool SetData(UINT format, HGLOBAL data) {
+		if (!data) {
+			return false;
+		}
+		if (!SetClipboardData(format, data)) {
+			LogWarning("Failed to set clipboard format {}. Error code: {}", format, GetLastError());
+			GlobalFree(data);
+			return false;
+		}
+		return true;
+	}
+
+	// ---- Encoding ----
+
+	// `CF_DIBV5` memory: a `BITMAPV5HEADER` with an alpha mask and bottom-up straight BGRA
+	static HGLOBAL EncodeDibV5(const void* pixels, UINT width, UINT height, UINT stride) {
+		if (!CheckSize(width, height)) {
+			return NULL;
+		}
+		size_t imageBytes = size_t(width) * height * 4;
+		HGLOBAL memory = GlobalAlloc(GMEM_MOVEABLE, sizeof(BITMAPV5HEADER) + imageBytes);
+		BYTE* bytes = memory ? static_cast<BYTE*>(GlobalLock(memory)) : nullptr;
+		if (!bytes) {
+			LogWarning("Failed to allocate {} bytes of clipboard data. Error code: {}", sizeof(BITMAPV5HEADER) + imageBytes, GetLastError());
+			if (memory) {
+				GlobalFree(memory);
+			}
+			return NULL;
+		}
+		BITMAPV5HEADER header = {};
+		header.bV5Size = sizeof(header);
+		header.bV5Width = static_cast<LONG>(width);
+		header.bV5Height = static_cast<LONG>(height);
+		header.bV5Planes = 1;
+		header.bV5BitCount = 32;
+		header.bV5Compression = BI_BITFIELDS;
+		header.bV5SizeImage = static_cast<DWORD>(imageBytes);
+		header.bV5RedMask = kRedMask;
+		header.bV5GreenMask = kGreenMask;
+		header.bV5BlueMask = kBlueMask;
+		header.bV5AlphaMask = kAlphaMask;
+		header.bV5CSType = LCS_sRGB;
+		header.bV5Intent = LCS_GM_IMAGES;
+		memcpy(bytes, &header, sizeof(header));
+
+		ptrdiff_t targetStride = ptrdiff_t(width) * 4;
+		BYTE* lastRow = bytes + sizeof(header) + targetStride * (height - 1);
+		PixelConversion::Convert(pixels, stride, lastRow, -targetStride, width, height, AlphaConversion::Unpremultiply);
+		GlobalUnlock(memory);
+		return memory;
+	}
+
+	// Memory holding a PNG file with straight alpha
+	static HGLOBAL EncodePng(const void* pixels, UINT width, UINT height, UINT stride) {
+		if (!CheckSize(width, height)) {
+			return NULL;
+		}
+		ComScope com;
+		Microsoft::WRL::ComPtr<IWICImagingFactory> factory = CreateFactory();
+		if (!factory) {
+			return NULL;
+		}
+		std::vector<uint32_t> straight(size_t(width) * height);
+		PixelConversion::Convert(pixels, stride, straight.data(), ptrdiff_t(width) * 4, width, height, AlphaConversion::Unpremultiply);
+
+		// The stream allocates the memory and leaves it to us when released. It may
+		// reallocate while growing, so the handle is only read once encoding is done.
+		HGLOBAL memory = NULL;
+		Microsoft::WRL::ComPtr<IStream> stream;
+		Microsoft::WRL::ComPtr<IWICBitmapEncoder> encoder;
+		Microsoft::WRL::ComPtr<IWICBitmapFrameEncode> frame;
+		WICPixelFormatGUID format = kFormatBgra;
+		HRESULT result = CreateStreamOnHGlobal(NULL, FALSE, &stream);
+		if (SUCCEEDED(result)) {
+			result = factory->CreateEncoder(kContainerPng, NULL, &encoder);
+		}
+		if (SUCCEEDED(result)) {
+			result = encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache);
+		}
+		if (SUCCEEDED(result)) {
+			result = encoder->CreateNewFrame(&frame, NULL);
+		}
+		if (SUCCEEDED(result)) {
+			result = frame->Initialize(NULL);
+		}
+		if (SUCCEEDED(result)) {
+			result = frame->SetSize(width, height);
+		}
+		if (SUCCEEDED(result)) {
+			result = frame->SetPixelFormat(&format);
+		}
+		if (SUCCEEDED(result) && !IsEqualGUID(format, kFormatBgra)) {
+			result = E_FAIL;
+		}
+		if (SUCCEEDED(result)) {
+			result = frame->WritePixels(height, width * 4, static_cast<UINT>(straight.size() * 4), reinterpret_cast<BYTE*>(straight.data()));
+		}
+		if (SUCCEEDED(result)) {
+			result = frame->Commit();
+		}
+		if (SUCCEEDED(result)) {
+			result = encoder->Commit();
+		}
+		if (stream) {
+			HRESULT handleResult = GetHGlobalFromStream(stream.Get(), &memory);
+			if (SUCCEEDED(result)) {
+				result = handleResult;
+			}
+		}
+		if (FAILED(result)) {
+			LogWarning("Failed to encode a {}x{} PNG. Error code: {}", width, height, static_cast<uint32_t>(result));
+			frame.Reset();
+			encoder.Reset();
+			stream.Reset();
+			if (memory) {
+				GlobalFree(memory);
+			}
+			return NULL;
+		}
+		return memory;
+	}
+
+	// ---- Decoding ----
+
+	// Reads `CF_DIB` or `CF_DIBV5` memory with 24- or 32-bit pixels in either row order.
+	// 32-bit images without an alpha mask are taken as opaque unless they carry alpha.
+	static bool DecodeDib(const void* data, size_t size, BgraImage& image) {
+		const BYTE* bytes = static_cast<const BYTE*>(data);
+		BITMAPINFOHEADER info;
+		if (size < sizeof(info)) {
+			return false;
+		}
+		memcpy(&info, bytes, sizeof(info));
+		if (info.biSize < sizeof(info) || info.biSize > size || info.biWidth <= 0 || info.biHeight == 0 || info.biPlanes != 1) {
+			return false;
+		}
+		if (info.biBitCount != 32 && info.biBitCount != 24) {
+			LogDebug("Unsupported clipboard DIB with {} bits per pixel", info.biBitCount);
+			return false;
+		}
+		UINT width = static_cast<UINT>(info.biWidth);
+		UINT height = static_cast<UINT>(info.biHeight < 0 ? -static_cast<int64_t>(info.biHeight) : info.biHeight);
+		if (!CheckSize(width, height)) {
+			return false;
+		}
+
+		size_t offset = info.biSize;
+		bool hasAlphaMask = false;
+		if (info.biCompression == BI_BITFIELDS && info.biBitCount == 32) {
+			DWORD masks[4] = {};
+			if (info.biSize >= sizeof(BITMAPV4HEADER)) {
+				memcpy(masks, bytes + sizeof(BITMAPINFOHEADER), sizeof(masks));
+			}
+			else {
+				// A plain BITMAPINFOHEADER is followed by the three color masks
+				if (size < offset + 3 * sizeof(DWORD)) {
+					return false;
+				}
+				memcpy(masks, bytes + offset, 3 * sizeof(DWORD));
+				offset += 3 * sizeof(DWORD);
+			}
+			if (masks[0] != kRedMask || masks[1] != kGreenMask || masks[2] != kBlueMask) {
+				LogDebug("Unsupported clipboard DIB color masks");
+				return false;
+			}
+			hasAlphaMask = masks[3] == kAlphaMask;
+		}
+		else if (info.biCompression != BI_RGB) {
+			return false;
+		}
+		offset += size_t(info.biClrUsed) * sizeof(RGBQUAD);
+
+		size_t sourceStride = (size_t(width) * info.biBitCount / 8 + 3) & ~size_t(3);
+		if (size < offset || (size - offset) / sourceStride < height) {
+			return false;
+		}
+		image.width = width;
+		image.height = height;
+		image.pixels.resize(size_t(width) * height);
+
+		// Bottom-up DIBs are read from their last row upwards
+		const BYTE* firstRow = bytes + offset;
+		ptrdiff_t step = static_cast<ptrdiff_t>(sourceStride);
+		if (info.biHeight > 0) {
+			firstRow += sourceStride * (height - 1);
+			step = -step;
+		}
+		if (info.biBitCount == 24) {
+			for (UINT y = 0; y < height; ++y) {
+				PixelConversion::ExpandBgrRow(firstRow + step * ptrdiff_t(y), image.pixels.data() + size_t(y) * width, width);
+			}
+			return true;
+		}
+		PixelConversion::Convert(firstRow, step, image.pixels.data(), image.GetStride(), width, height, AlphaConversion::None);
+		if (!hasAlphaMask && !PixelConversion::HasAlpha(image.pixels.data(), image.pixels.size())) {
+			PixelConversion::SetOpaqueRow(image.pixels.data(), image.pixels.size());
+		}
+		else {
+			PixelConversion::Convert(image.pixels.data(), image.GetStride(), image.pixels.data(), image.GetStride(), width, height, AlphaConversion::Premultiply);
+		}
+		return true;
+	}
+
+	static bool DecodePng(const void* data, size_t size, BgraImage& image) {
+		ComScope com;
+		Microsoft::WRL::ComPtr<IWICImagingFactory> factory = CreateFactory();
+		if (!factory || size > UINT32_MAX) {
+			return false;
+		}
+		Microsoft::WRL::ComPtr<IWICStream> stream;
+		Microsoft::WRL::ComPtr<IWICBitmapDecoder> decoder;
+		Microsoft::WRL::ComPtr<IWICBitmapFrameDecode> frame;
+		Microsoft::WRL::ComPtr<IWICFormatConverter> converter;
+		HRESULT result = factory->CreateStream(&stream);
+		if (SUCCEEDED(result)) {
+			result = stream->InitializeFromMemory(static_cast<BYTE*>(const_cast<void*>(data)), static_cast<DWORD>(size));
+		}
+		if (SUCCEEDED(result)) {
+			result = factory->CreateDecoderFromStream(stream.Get(), NULL, WICDecodeMetadataCacheOnDemand, &decoder);
+		}
+		if (SUCCEEDED(result)) {
+			result = decoder->GetFrame(0, &frame);
+		}
+		if (SUCCEEDED(result)) {
+			result = factory->CreateFormatConverter(&converter);
+		}
+		if (SUCCEEDED(result)) {
+			result = converter->Initialize(frame.Get(), kFormatBgra, WICBitmapDitherTypeNone, NULL, 0.0, WICBitmapPaletteTypeCustom);
+		}
+		UINT width = 0;
+		UINT height = 0;
+		if (SUCCEEDED(result)) {
+			result = converter->GetSize(&width, &height);
+		}
+		if (SUCCEEDED(result) && !CheckSize(width, height)) {
+			result = E_FAIL;
+		}
+		if (SUCCEEDED(result)) {
+			image.width = width;
+			image.height = height;
+			image.pixels.resize(size_t(width) * height);
+			result = converter->CopyPixels(NULL, image.GetStride(), static_cast<UINT>(image.pixels.size() * 4), reinterpret_cast<BYTE*>(image.pixels.data()));
+		}
+		if (FAILED(result)) {
+			LogWarning("Failed to decode a clipboard PNG. Error code: {}", static_cast<uint32_t>(result));
+			return false;
+		}
+		PixelConversion::Convert(image.pixels.data(), image.GetStride(), image.pixels.data(), image.GetStride(), width, height, AlphaConversion::Premultiply);
+		return true;
+	}
+
+private:
+	static constexpr DWORD kRedMask = 0x00FF0000;
+	static constexpr DWORD kGreenMask = 0x0000FF00;
+	static constexpr DWORD kBlueMask = 0x000000FF;
+	static constexpr DWORD kAlphaMask = 0xFF000000;
+	// Larger images are rejected, keeping every byte count within 32 bits
+	static constexpr uint64_t kMaxPixels = uint64_t(1) << 28;
+
+	// Defined here rather than taken from windowscodecs.lib, so nothing is imported statically
+	static constexpr GUID kImagingFactory = { 0xcacaf262, 0x9370, 0x4615, { 0xa1, 0x3b, 0x9f, 0x55, 0x39, 0xda, 0x4c, 0x0a } };
+	static constexpr GUID kContainerPng = { 0x1b7cfaf4, 0x713f, 0x473c, { 0xbb, 0xcd, 0x61, 0x37, 0x42, 0x5f, 0xae, 0xaf } };
+	static constexpr GUID kFormatBgra = { 0x6fddc324, 0x4e03, 0x4bfe, { 0xb1, 0x85, 0x3d, 0x77, 0x76, 0x8d, 0xc9, 0x0f } };
+
+	// Initializes COM for the calling thread unless it already is
+	class ComScope {
+	public:
+		ComScope() : m_Initialized(SUCCEEDED(CoInitializeEx(NULL, COINIT_APARTMENTTHREADED))) {}
+
+		~ComScope() {
+			if (m_Initialized) {
+				CoUninitialize();
+			}
+		}
+
+		ComScope(const ComScope&) = delete;
+		ComScope& operator=(const ComScope&) = delete;
+
+	private:
+		bool m_Initialized;
+	};
+
+	static bool CheckSize(UINT width, UINT height) {
+		return width > 0 && height > 0 && uint64_t(width) * height <= kMaxPixels;
+	}
+
+	static Microsoft::WRL::ComPtr<IWICImagingFactory> CreateFactory() {
+		Microsoft::WRL::ComPtr<IWICImagingFactory> factory;
+		HRESULT result = CoCreateInstance(kImagingFactory, NULL, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+		if (FAILED(result)) {
+			LogWarning("Failed to create the WIC imaging factory. Error code: {}", static_cast<uint32_t>(result));
+		}
+		return factory;
+	}
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stdint.h>
+#include <windows.h>
+
+#include "Window.hpp"
+#include "ClipboardImage.hpp"
+
+// Puts an image on the clipboard with delayed rendering: `Offer` only copies the pixels
+// and announces the formats, and each format is encoded when an application first pastes
+// it (`WM_RENDERFORMAT`). Copying a large snapshot therefore costs a memcpy, and the PNG
+// encoder only runs if someone asks for PNG. Formats still unrendered when the window is
+// destroyed are rendered then (`WM_RENDERALLFORMATS`), so the image outlives the window.
+// Requests for formats this object did not announce, and `WM_DESTROYCLIPBOARD`, go on to
+// the window's other handlers.
+class DelayedClipboardImage {
+public:
+	explicit DelayedClipboardImage(Window& window) : m_Window(window) {
+		m_Layer = m_Window.AddMessageLayer({ WM_RENDERFORMAT, WM_RENDERALLFORMATS, WM_DESTROYCLIPBOARD }, [this](HWND window, UINT message, WPARAM wParam, LPARAM, LRESULT& result) {
+			switch (message) {
+			case WM_RENDERFORMAT:
+				if (!(m_Pending & GetFlag(static_cast<UINT>(wParam)))) {
+					return false;
+				}
+				// The requesting application holds the clipboard open
+				Render(static_cast<UINT>(wParam));
+				break;
+			case WM_RENDERALLFORMATS:
+				if (!m_Pending) {
+					return false;
+				}
+				RenderAll(window);
+				break;
+			case WM_DESTROYCLIPBOARD:
+				// Other clipboard users of the window may own data too
+				Release();
+				return false;
+			}
+			result = 0;
+			return true;
+		});
+	}
+
+	// Renders what is still pending, as the window can no longer answer requests
+	~DelayedClipboardImage() {
+		if (m_Pending && IsWindow(m_Window.GetHandle())) {
+			RenderAll(m_Window.GetHandle());
+		}
+		m_Window.RemoveMessageLayer(m_Layer);
+	}
+
+	DelayedClipboardImage(const DelayedClipboardImage&) = delete;
+	DelayedClipboardImage& operator=(const DelayedClipboardImage&) = delete;
+
+	// Replaces the clipboard contents with `formats` of a copy of the image
+	bool Offer(const void* pixels, UINT width, UINT height, UINT stride, UINT formats = ClipboardAllImageFormats) {
+		BgraImage image;
+		image.width = width;
+		image.height = height;
+		image.pixels.resize(size_t(width) * height);
+		PixelConversion::Convert(pixels, stride, image.pixels.data(), image.GetStride(), width, height, AlphaConversion::None);
+		return Offer(std::move(image), formats);
+	}
+
+	bool Offer(BgraImage image, UINT formats = ClipboardAllImageFormats) {
+		HWND window = m_Window.GetHandle();
+		if (!OpenClipboard(window)) {
+			LogWarning("Failed to open the clipboard. Error code: {}", GetLastError());
+			return false;
+		}
+		// Sends WM_DESTROYCLIPBOARD to the previous owner, which may be this object
+		EmptyClipboard();
+		m_Image = std::move(image);
+		m_Pending = 0;
+		if (formats & ClipboardDibV5) {
+			Announce(CF_DIBV5, ClipboardDibV5);
+		}
+		if (formats & ClipboardPng) {
+			Announce(ClipboardImage::GetPngFormat(), ClipboardPng);
+		}
+		CloseClipboard();
+		if (!m_Pending) {
+			Release();
+			return false;
+		}
+		return true;
+	}
+
+	// Whether this object still owns an image on the clipboard
+	bool IsOffered() const {
+		return !m_Image.pixels.empty();
+	}
+
+	// Formats encoded on request so far
+	uint64_t GetRenderCount() const {
+		return m_Renders;
+	}
+
+private:
+	void Announce(UINT format, UINT flag) {
+		// Announcing returns null on success too; only the last error tells them apart
+		SetLastError(ERROR_SUCCESS);
+		SetClipboardData(format, NULL);
+		if (GetLastError() == ERROR_SUCCESS) {
+			m_Pending |= flag;
+		}
+		else {
+			LogWarning("Failed to announce clipboard format {}. Error code: {}", format, GetLastError());
+		}
+	}
+
+	// The `ClipboardImageFormats` flag of a clipboard format, 0 for formats never offered
+	static UINT GetFlag(UINT format) {
+		return format == CF_DIBV5 ? UINT(ClipboardDibV5) : format == ClipboardImage::GetPngFormat() ? UINT(ClipboardPng) : 0;
+	}
+
+	void Render(UINT format) {
+		UINT flag = GetFlag(format);
+		if (!(m_Pending & flag) || m_Image.pixels.empty()) {
+			return;
+		}
+		m_Pending &= ~flag;
+		const void* pixels = m_Image.pixels.data();
+		HGLOBAL data = flag == ClipboardDibV5 ? ClipboardImage::EncodeDibV5(pixels, m_Image.width, m_Image.height, m_Image.GetStride())
+			: ClipboardImage::EncodePng(pixels, m_Image.width, m_Image.height, m_Image.GetStride());
+		if (ClipboardImage::SetData(format, data)) {
+			++m_Renders;
+		}
+	}
+
+	void RenderAll(HWND window) {
+		if (!m_Pending || !OpenClipboard(window)) {
+			return;
+		}
+		// Another application may have taken the clipboard in the meantime
+		if (GetClipboardOwner() == window) {
+			Render(CF_DIBV5);
+			Render(ClipboardImage::GetPngFormat());
+		}
+		CloseClipboard();
+		Release();
+	}
+
+	void Release() {
+		m_Image = BgraImage();
+		m_Pending = 0;
+	}
+
+	Window& m_Window;
+	size_t m_Layer = 0;
+	BgraImage m_Image;
+	UINT m_Pending = 0;
+	uint64_t m_Renders = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+
+// Set of window message IDs. System messages (below `WM_USER`) live in a 1024-bit
+// bitmap, so testing them is one load and a bit test; the few application and
+// registered messages a layer cares about are kept sorted next to it. Platform
+// independent.
+class MessageMask {
+public:
+	MessageMask() = default;
+
+	MessageMask(std::initializer_list<uint32_t> messages) {
+		for (uint32_t message : messages) {
+			Add(message);
+		}
+	}
+
+	// Every message, for layers that must see all traffic
+	static MessageMask All() {
+		MessageMask mask;
+		std::fill(std::begin(mask.m_Dense), std::end(mask.m_Dense), UINT64_MAX);
+		mask.m_All = true;
+		return mask;
+	}
+
+	MessageMask& Add(uint32_t message) {
+		if (message < kDenseLimit) {
+			m_Dense[message / 64] |= uint64_t(1) << (message % 64);
+		}
+		else {
+			auto it = std::lower_bound(m_Sparse.begin(), m_Sparse.end(), message);
+			if (it == m_Sparse.end() || *it != message) {
+				m_Sparse.insert(it, message);
+			}
+		}
+		return *this;
+	}
+
+	// Adds `first` through `last`, inclusive
+	MessageMask& AddRange(uint32_t first, uint32_t last) {
+		for (uint32_t message = first; message <= last && message >= first; ++message) {
+			Add(message);
+		}
+		return *this;
+	}
+
+	bool Test(uint32_t message) const {
+		if (message < kDenseLimit) {
+			return (m_Dense[message / 64] >> (message % 64)) & 1;
+		}
+		return m_All || (!m_Sparse.empty() && std::binary_search(m_Sparse.begin(), m_Sparse.end(), message));
+	}
+
+	bool IsEmpty() const {
+		return !m_All && m_Sparse.empty() && std::all_of(std::begin(m_Dense), std::end(m_Dense), [](uint64_t word) { return word == 0; });
+	}
+
+	MessageMask& operator|=(const MessageMask& other) {
+		for (size_t i = 0; i < kDenseWords; ++i) {
+			m_Dense[i] |= other.m_Dense[i];
+		}
+		for (uint32_t message : other.m_Sparse) {
+			Add(message);
+		}
+		m_All = m_All || other.m_All;
+		return *this;
+	}
+
+private:
+	static constexpr uint32_t kDenseLimit = 0x0400; // WM_USER
+	static constexpr size_t kDenseWords = kDenseLimit / 64;
+
+	uint64_t m_Dense[kDenseWords] = {};
+	std::vector<uint32_t> m_Sparse;
+	bool m_All = false;
+};
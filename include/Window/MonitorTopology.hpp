@@ -0,0 +1,235 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <windows.h>
+
+#include "../System/ApiTable.hpp"
+#include "../Diagnostics/MemoryLedger.hpp"
+
+// One display as seen by the topology cache
+struct MonitorInfo {
+	HMONITOR handle = NULL;
+	RECT bounds = {};
+	// Bounds minus taskbar and docked app bars
+	RECT workArea = {};
+	UINT dpi = USER_DEFAULT_SCREEN_DPI;
+	// In Hz; 0 if the driver does not report it
+	UINT refreshRate = 0;
+	bool primary = false;
+	std::wstring device;
+};
+
+// Snapshot of the display layout, so that placing and snapping windows does not call
+// `MonitorFromWindow`, `GetMonitorInfo` and `EnumDisplayMonitors` per operation. The
+// snapshot is taken on first use and again on the first query after a layout change.
+// Layout changes are picked up by a hidden top-level window created on first use, which
+// receives the `WM_DISPLAYCHANGE` and `WM_SETTINGCHANGE` broadcasts; windows may also
+// forward their messages to `HandleMessage` to catch their own `WM_DPICHANGED`. Queries
+// are linear scans over a handful of rectangles. The snapshot is charged to the memory
+// ledger as an unattributed cache. UI thread only; the hidden window
+// belongs to the thread of the first query, which must pump messages.
+class MonitorTopology {
+public:
+	// The process-wide cache
+	static MonitorTopology& Get() {
+		static MonitorTopology topology;
+		return topology;
+	}
+
+	// Call from the window procedure; marks the cache stale on layout changes. Never
+	// consumes the message.
+	bool HandleMessage(UINT message, WPARAM wParam, LPARAM) {
+		switch (message) {
+		case WM_DISPLAYCHANGE:
+		case WM_DPICHANGED:
+			Invalidate();
+			break;
+		case WM_SETTINGCHANGE:
+			if (wParam == SPI_SETWORKAREA) {
+				Invalidate();
+			}
+			break;
+		}
+		return false;
+	}
+
+	void Invalidate() {
+		m_Stale = true;
+	}
+
+	// Re-reads the layout now
+	void Refresh() {
+		m_Monitors.clear();
+		EnumDisplayMonitors(NULL, NULL, [](HMONITOR monitor, HDC, LPRECT, LPARAM param) -> BOOL {
+			reinterpret_cast<MonitorTopology*>(param)->Add(monitor);
+			return TRUE;
+		}, reinterpret_cast<LPARAM>(this));
+		m_Primary = 0;
+		for (size_t i = 0; i < m_Monitors.size(); ++i) {
+			if (m_Monitors[i].primary) {
+				m_Primary = i;
+			}
+		}
+		m_Stale = false;
+		++m_Generation;
+	}
+
+	const std::vector<MonitorInfo>& GetMonitors() {
+		Update();
+		return m_Monitors;
+	}
+
+	const MonitorInfo& GetPrimary() {
+		Update();
+		return m_Monitors[m_Primary];
+	}
+
+	// Monitor containing `point`, or the nearest one
+	const MonitorInfo& FromPoint(POINT point) {
+		Update();
+		for (const MonitorInfo& monitor : m_Monitors) {
+			if (PtInRect(&monitor.bounds, point)) {
+				return monitor;
+			}
+		}
+		RECT rect = { point.x, point.y, point.x + 1, point.y + 1 };
+		return Nearest(rect);
+	}
+
+	// Monitor with the largest intersection with `rect`, or the nearest one
+	const MonitorInfo& FromRect(const RECT& rect) {
+		Update();
+		const MonitorInfo* best = nullptr;
+		int64_t bestArea = 0;
+		for (const MonitorInfo& monitor : m_Monitors) {
+			RECT overlap;
+			if (IntersectRect(&overlap, &monitor.bounds, &rect)) {
+				int64_t area = static_cast<int64_t>(overlap.right - overlap.left) * (overlap.bottom - overlap.top);
+				if (area > bestArea) {
+					best = &monitor;
+					bestArea = area;
+				}
+			}
+		}
+		return best ? *best : Nearest(rect);
+	}
+
+	const MonitorInfo& FromWindow(HWND window) {
+		RECT rect = {};
+		GetWindowRect(window, &rect);
+		return FromRect(rect);
+	}
+
+	// Incremented on every refresh, for callers caching derived layouts
+	uint64_t GetGeneration() const {
+		return m_Generation;
+	}
+
+private:
+	MonitorTopology() = default;
+
+	~MonitorTopology() {
+		if (m_Listener) {
+			DestroyWindow(m_Listener);
+		}
+	}
+
+	MonitorTopology(const MonitorTopology&) = delete;
+	MonitorTopology& operator=(const MonitorTopology&) = delete;
+
+	// Message-only windows do not receive broadcasts, so the listener is a top-level
+	// window that is never shown
+	void CreateListener() {
+		m_ListenerTried = true;
+		WNDCLASS windowClass = {};
+		windowClass.lpfnWndProc = [](HWND window, UINT message, WPARAM wParam, LPARAM lParam) -> LRESULT {
+			MonitorTopology::Get().HandleMessage(message, wParam, lParam);
+			return DefWindowProc(window, message, wParam, lParam);
+		};
+		windowClass.hInstance = GetModuleHandleW(NULL);
+		windowClass.lpszClassName = kListenerClass;
+		if (!RegisterClass(&windowClass) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
+			return;
+		}
+		m_Listener = CreateWindowEx(WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE, kListenerClass, L"", WS_POPUP, 0, 0, 0, 0, NULL, NULL, windowClass.hInstance, NULL);
+	}
+
+	void Update() {
+		if (!m_ListenerTried) {
+			CreateListener();
+		}
+		// Without the listener nothing reports changes, so the cache cannot be trusted
+		if (m_Stale || m_Monitors.empty() || !m_Listener) {
+			Refresh();
+		}
+		// No display at all (e.g. a disconnected remote session): pretend there is one
+		if (m_Monitors.empty()) {
+			MonitorInfo fallback;
+			fallback.bounds = { 0, 0, GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN) };
+			fallback.workArea = fallback.bounds;
+			fallback.primary = true;
+			m_Monitors.push_back(fallback);
+			m_Primary = 0;
+		}
+		uint64_t bytes = m_Monitors.capacity() * sizeof(MonitorInfo);
+		for (const MonitorInfo& monitor : m_Monitors) {
+			bytes += monitor.device.size() * sizeof(wchar_t);
+		}
+		m_Memory.Resize(bytes);
+	}
+
+	void Add(HMONITOR handle) {
+		MONITORINFOEXW info = {};
+		info.cbSize = sizeof(info);
+		if (!GetMonitorInfoW(handle, reinterpret_cast<MONITORINFO*>(&info))) {
+			return;
+		}
+		MonitorInfo monitor;
+		monitor.handle = handle;
+		monitor.bounds = info.rcMonitor;
+		monitor.workArea = info.rcWork;
+		monitor.primary = (info.dwFlags & MONITORINFOF_PRIMARY) != 0;
+		monitor.device = info.szDevice;
+
+		UINT dpiX = 0;
+		UINT dpiY = 0;
+		if (SUCCEEDED(GetShcoreApi().GetDpiForMonitor(handle, 0 /* MDT_EFFECTIVE_DPI */, &dpiX, &dpiY)) && dpiX) {
+			monitor.dpi = dpiX;
+		}
+		DEVMODEW mode = {};
+		mode.dmSize = sizeof(mode);
+		if (EnumDisplaySettingsW(info.szDevice, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1) {
+			// 0 and 1 both mean "hardware default"
+			monitor.refreshRate = mode.dmDisplayFrequency;
+		}
+		m_Monitors.push_back(monitor);
+	}
+
+	// Monitor whose bounds are closest to `rect`
+	const MonitorInfo& Nearest(const RECT& rect) {
+		const MonitorInfo* best = &m_Monitors[m_Primary];
+		int64_t bestDistance = INT64_MAX;
+		for (const MonitorInfo& monitor : m_Monitors) {
+			int64_t dx = rect.right <= monitor.bounds.left ? monitor.bounds.left - rect.right : rect.left >= monitor.bounds.right ? rect.left - monitor.bounds.right : 0;
+			int64_t dy = rect.bottom <= monitor.bounds.top ? monitor.bounds.top - rect.bottom : rect.top >= monitor.bounds.bottom ? rect.top - monitor.bounds.bottom : 0;
+			int64_t distance = dx * dx + dy * dy;
+			if (distance < bestDistance) {
+				best = &monitor;
+				bestDistance = distance;
+			}
+		}
+		return *best;
+	}
+
+	static constexpr LPCWSTR kListenerClass = L"wincpp.MonitorTopology";
+
+	std::vector<MonitorInfo> m_Monitors;
+	size_t m_Primary = 0;
+	bool m_Stale = true;
+	uint64_t m_Generation = 0;
+	HWND m_Listener = NULL;
+	bool m_ListenerTried = false;
+	MemoryCharge m_Memory{ 0, MemoryCategory::Cache, 0 };
+};
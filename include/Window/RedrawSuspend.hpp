@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+#include <windows.h>
+
+// Counters of all redraw scopes on the thread
+struct RedrawStats {
+	// Outermost scopes entered
+	uint64_t suspensions = 0;
+	// Invalidations issued when outermost scopes ended
+	uint64_t redraws = 0;
+	// Scopes entered while the window was already suspended
+	uint64_t nestedScopes = 0;
+	// `Invalidate` calls merged into those redraws
+	uint64_t mergedInvalidations = 0;
+};
+
+// Turns off drawing of a window for the lifetime of the scope, for bulk updates such as
+// filling lists, reparenting or restyling many children. Scopes nest: only the outermost
+// sends `WM_SETREDRAW`, and when it ends it re-enables drawing and issues one
+// invalidation, of the rectangles passed to `Invalidate` or else the whole window and its
+// children. Windows that are hidden when the scope starts are left alone, because
+// `WM_SETREDRAW TRUE` would show them. UI thread only.
+//
+//	{
+//		RedrawSuspend suspend = window.SuspendRedraw();
+//		for (...) SendMessage(list, LB_ADDSTRING, 0, item);
+//	}
+class RedrawSuspend {
+public:
+	explicit RedrawSuspend(HWND window) : m_Window(window) {
+		State& state = States()[m_Window];
+		if (state.depth++) {
+			++Stats().nestedScopes;
+			return;
+		}
+		state.visible = IsWindowVisible(m_Window) != FALSE;
+		if (state.visible) {
+			SendMessage(m_Window, WM_SETREDRAW, FALSE, 0);
+		}
+		++Stats().suspensions;
+	}
+
+	~RedrawSuspend() {
+		auto it = States().find(m_Window);
+		if (--it->second.depth) {
+			return;
+		}
+		State state = it->second;
+		States().erase(it);
+		Stats().mergedInvalidations += state.invalidations;
+		if (!state.visible || !IsWindow(m_Window)) {
+			return;
+		}
+		SendMessage(m_Window, WM_SETREDRAW, TRUE, 0);
+		if (state.whole || IsRectEmpty(&state.dirty)) {
+			RedrawWindow(m_Window, NULL, NULL, RDW_ERASE | RDW_FRAME | RDW_INVALIDATE | RDW_ALLCHILDREN);
+		}
+		else {
+			RedrawWindow(m_Window, &state.dirty, NULL, RDW_ERASE | RDW_INVALIDATE | RDW_ALLCHILDREN);
+		}
+		++Stats().redraws;
+	}
+
+	RedrawSuspend(const RedrawSuspend&) = delete;
+	RedrawSuspend& operator=(const RedrawSuspend&) = delete;
+
+	// Marks `rect` (client coordinates) for the final redraw; `nullptr` for the whole window
+	void Invalidate(const RECT* rect = nullptr) {
+		State& state = States()[m_Window];
+		if (rect) {
+			UnionRect(&state.dirty, &state.dirty, rect);
+		}
+		else {
+			state.whole = true;
+		}
+		++state.invalidations;
+	}
+
+	static bool IsSuspended(HWND window) {
+		return States().count(window) != 0;
+	}
+
+	static const RedrawStats& GetStats() {
+		return Stats();
+	}
+
+private:
+	struct State {
+		uint32_t depth = 0;
+		bool visible = false;
+		bool whole = false;
+		RECT dirty = {};
+		uint64_t invalidations = 0;
+	};
+
+	static std::unordered_map<HWND, State>& States() {
+		static thread_local std::unordered_map<HWND, State> states;
+		return states;
+	}
+
+	static RedrawStats& Stats() {
+		static thread_local RedrawStats stats;
+		return stats;
+	}
+
+	HWND m_Window;
+};
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#include <windows.h>
+
+#include "MessageMask.hpp"
+#include "../Diagnostics/MemoryLedger.hpp"
+
+// Counters of one chain
+struct SubclassStats {
+	// Messages that reached the chain
+	uint64_t messages = 0;
+	// Messages no layer asked for, forwarded after a single mask test
+	uint64_t bypassed = 0;
+	// Handler invocations
+	uint64_t layerCalls = 0;
+	// Layers passed over because their mask did not contain the message
+	uint64_t layersSkipped = 0;
+};
+
+// Layered window procedure for behaviors such as dragging, snapping or telemetry that
+// each care about a handful of messages. One procedure is installed on the window;
+// every layer declares the messages it handles as a `MessageMask` and is only called
+// for those. The union of all masks is kept up to date, so the common case of a message
+// nobody asked for costs one bit test before reaching the original procedure, instead of
+// a call through every nested procedure as with `SetWindowSubclass`.
+//
+// Layers run newest first. A handler returns true to consume the message with the
+// result it stored, false to pass it on. Layers may be added and removed from inside
+// handlers; the changes apply once the outermost dispatch returns. A handler may also
+// destroy the chain, e.g. by deleting the `Window` that owns it: the running handlers
+// are then kept alive until the outermost dispatch returns, and the dispatch stops
+// touching the chain. The chain detaches itself on `WM_NCDESTROY`. The layer table is
+// charged to the window as handler state. UI thread only.
+class SubclassChain {
+public:
+	using Handler = std::function<bool(HWND window, UINT message, WPARAM wParam, LPARAM lParam, LRESULT& result)>;
+
+	explicit SubclassChain(HWND window) : m_Window(window), m_Memory(reinterpret_cast<uintptr_t>(window), MemoryCategory::HandlerState, 0) {
+		if (GetProp(m_Window, kChainProperty)) {
+			throw std::runtime_error("Window already has a subclass chain.");
+		}
+		m_Original = reinterpret_cast<WNDPROC>(GetWindowLongPtr(m_Window, GWLP_WNDPROC));
+		if (!SetProp(m_Window, kChainProperty, this) || !SetProp(m_Window, kOriginalProperty, reinterpret_cast<HANDLE>(m_Original))) {
+			DWORD error = GetLastError();
+			RemoveProp(m_Window, kChainProperty);
+			throw std::runtime_error("Failed to install subclass chain. Error code: " + std::to_string(error));
+		}
+		SetWindowLongPtr(m_Window, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(&SubclassChain::Procedure));
+	}
+
+	~SubclassChain() {
+		if (m_Frame) {
+			// Destroyed from inside a handler: tell every dispatch on the stack and hand the
+			// layers, including the running handlers, to the outermost one to free
+			DispatchFrame* outermost = m_Frame;
+			for (DispatchFrame* frame = m_Frame; frame; frame = frame->outer) {
+				frame->destroyed = true;
+				outermost = frame;
+			}
+			outermost->orphaned = std::move(m_Layers);
+			for (Layer& layer : m_Added) {
+				outermost->orphaned.push_back(std::move(layer));
+			}
+		}
+		Detach();
+	}
+
+	SubclassChain(const SubclassChain&) = delete;
+	SubclassChain& operator=(const SubclassChain&) = delete;
+
+	// Returns an id for `RemoveLayer`
+	size_t AddLayer(const MessageMask& mask, Handler handler) {
+		size_t id = ++m_NextId;
+		if (m_Depth) {
+			// Appending could move the handler that is running; merged after dispatch
+			m_Added.push_back({ id, mask, std::move(handler), false });
+			m_Changed = true;
+			UpdateMemory();
+			return id;
+		}
+		m_Layers.push_back({ id, mask, std::move(handler), false });
+		m_Union |= mask;
+		UpdateMemory();
+		return id;
+	}
+
+	void RemoveLayer(size_t id) {
+		for (std::vector<Layer>* layers : { &m_Layers, &m_Added }) {
+			for (Layer& layer : *layers) {
+				if (layer.id == id) {
+					// Erased once no dispatch is running, so a handler can remove itself
+					layer.removed = true;
+					m_Changed = true;
+				}
+			}
+		}
+		if (!m_Depth) {
+			Compact();
+		}
+	}
+
+	// Procedure messages fall through to; replaces what `GWLP_WNDPROC` held before
+	void SetBaseProcedure(WNDPROC procedure) {
+		m_Original = procedure;
+		if (m_Window) {
+			SetProp(m_Window, kOriginalProperty, reinterpret_cast<HANDLE>(m_Original));
+		}
+	}
+
+	size_t GetLayerCount() const {
+		return m_Layers.size() + m_Added.size();
+	}
+
+	const SubclassStats& GetStats() const {
+		return m_Stats;
+	}
+
+	// Stops intercepting messages. If another procedure was installed on top of the chain
+	// it stays in place and messages keep reaching the original procedure through it.
+	void Detach() {
+		if (!m_Window) {
+			return;
+		}
+		if (GetWindowLongPtr(m_Window, GWLP_WNDPROC) == reinterpret_cast<LONG_PTR>(&SubclassChain::Procedure)) {
+			SetWindowLongPtr(m_Window, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(m_Original));
+			RemoveProp(m_Window, kOriginalProperty);
+		}
+		RemoveProp(m_Window, kChainProperty);
+		m_Window = NULL;
+	}
+
+private:
+	static constexpr LPCWSTR kChainProperty = L"wincpp.SubclassChain";
+	static constexpr LPCWSTR kOriginalProperty = L"wincpp.SubclassChain.Original";
+
+	struct Layer {
+		size_t id;
+		MessageMask mask;
+		Handler handler;
+		bool removed;
+	};
+
+	// One `Dispatch` on the stack, linked to the one it is nested in
+	struct DispatchFrame {
+		DispatchFrame* outer;
+		// Set when a handler destroyed the chain; nothing in it may be touched after that
+		bool destroyed = false;
+		// Layers of a destroyed chain, freed when the outermost dispatch returns
+		std::vector<Layer> orphaned;
+	};
+
+	static LRESULT CALLBACK Procedure(HWND window, UINT message, WPARAM wParam, LPARAM lParam) {
+		SubclassChain* chain = static_cast<SubclassChain*>(GetProp(window, kChainProperty));
+		if (!chain) {
+			WNDPROC original = reinterpret_cast<WNDPROC>(GetProp(window, kOriginalProperty));
+			// The chain is gone but a later subclass still calls through us
+			if (message == WM_NCDESTROY) {
+				RemoveProp(window, kOriginalProperty);
+			}
+			return original ? CallWindowProc(original, window, message, wParam, lParam) : DefWindowProc(window, message, wParam, lParam);
+		}
+		return chain->Dispatch(message, wParam, lParam);
+	}
+
+	LRESULT Dispatch(UINT message, WPARAM wParam, LPARAM lParam) {
+		++m_Stats.messages;
+		HWND window = m_Window;
+		if (m_Union.Test(message)) {
+			DispatchFrame frame{ m_Frame };
+			m_Frame = &frame;
+			++m_Depth;
+			WNDPROC original = m_Original;
+			LRESULT result = 0;
+			bool handled = false;
+			for (size_t i = m_Layers.size(); i-- > 0 && !handled;) {
+				if (!m_Layers[i].mask.Test(message)) {
+					++m_Stats.layersSkipped;
+					continue;
+				}
+				if (m_Layers[i].removed) {
+					continue;
+				}
+				++m_Stats.layerCalls;
+				handled = m_Layers[i].handler(window, message, wParam, lParam, result);
+				if (frame.destroyed) {
+					break;
+				}
+				original = m_Original;
+			}
+			if (frame.destroyed) {
+				// `this` is gone; `frame.orphaned` frees the handlers on return
+				if (handled || !IsWindow(window)) {
+					return result;
+				}
+				return CallWindowProc(original, window, message, wParam, lParam);
+			}
+			m_Frame = frame.outer;
+			if (--m_Depth == 0) {
+				Compact();
+			}
+			if (handled && message != WM_NCDESTROY) {
+				return result;
+			}
+		}
+		else {
+			++m_Stats.bypassed;
+		}
+
+		WNDPROC original = m_Original;
+		if (message == WM_NCDESTROY) {
+			Detach();
+		}
+		return CallWindowProc(original, window, message, wParam, lParam);
+	}
+
+	// Applies additions and removals made while handlers were running
+	void Compact() {
+		if (!m_Changed) {
+			return;
+		}
+		m_Changed = false;
+		for (Layer& layer : m_Added) {
+			m_Layers.push_back(std::move(layer));
+		}
+		m_Added.clear();
+		m_Layers.erase(std::remove_if(m_Layers.begin(), m_Layers.end(), [](const Layer& layer) { return layer.removed; }), m_Layers.end());
+		m_Union = MessageMask();
+		for (const Layer& layer : m_Layers) {
+			m_Union |= layer.mask;
+		}
+		UpdateMemory();
+	}
+
+	// The handlers' captures are not counted; they are usually a pointer or two
+	void UpdateMemory() {
+		m_Memory.Resize((m_Layers.capacity() + m_Added.capacity()) * sizeof(Layer));
+	}
+
+	HWND m_Window;
+	WNDPROC m_Original = nullptr;
+	std::vector<Layer> m_Layers;
+	std::vector<Layer> m_Added;
+	// Messages at least one layer handles
+	MessageMask m_Union;
+	size_t m_NextId = 0;
+	uint32_t m_Depth = 0;
+	// Innermost dispatch running, null outside of dispatch
+	DispatchFrame* m_Frame = nullptr;
+	bool m_Changed = false;
+	SubclassStats m_Stats;
+	MemoryCharge m_Memory;
+};
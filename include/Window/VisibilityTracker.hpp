@@ -0,0 +1,319 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <stdexcept>
+#include <windows.h>
+
+#include "../System/ApiTable.hpp"
+#include "../Loop/RunLoop.hpp"
+
+// How visible a top-level window currently is, from most to least visible
+enum class VisibilityState {
+	Visible,
+	Inactive,
+	Occluded,
+	Minimized,
+};
+
+// Throttling applied to a window in one visibility state
+struct VisibilityThrottle {
+	// Render every Nth frame; 1 renders every frame, 0 pauses rendering
+	uint32_t frameDivisor = 1;
+	// Multiplies timer intervals; 1 keeps them as is, 0 pauses the timers
+	uint32_t timerMultiplier = 1;
+};
+
+// Tracks whether a window is minimized, cloaked or covered by other windows, or merely
+// inactive, and throttles its frames and timers accordingly. Forward every message to
+// `HandleMessage`, ask `ShouldRenderFrame` at the top of the window's frame callback, and
+// create timers through the tracker so they can be slowed down or paused. Timer id
+// `kPollTimerId` is reserved for the tracker's own poll on the window it tracks.
+//
+// The tracker votes on the frame rate of the `RunLoop` of the thread it is created on.
+// The loop follows the most visible tracked window, so once all of them are paused it
+// stops ticking frames and the thread sleeps; `ShouldRenderFrame` thins out the frames
+// of the less visible ones.
+//
+// Full occlusion is detected by subtracting the rectangles of the visible top-level
+// windows above it in z-order from the window rectangle. DWM cloaking (other virtual
+// desktops, suspended UWP hosts) is read through `DWMWA_CLOAKED`. Both are checked on
+// position and activation changes and, while the window is not in front, on a slow poll.
+class VisibilityTracker {
+public:
+	// Window timer id of the tracker's poll; not available to `SetTimer`
+	static constexpr UINT_PTR kPollTimerId = 0x56495354;	// 'VIST'
+
+	explicit VisibilityTracker(HWND window) : m_Window(window), m_Loop(RunLoop::Current()) {
+		m_Policy[static_cast<size_t>(VisibilityState::Occluded)] = { 0, 0 };
+		m_Policy[static_cast<size_t>(VisibilityState::Minimized)] = { 0, 0 };
+		if (m_Loop) {
+			m_Throttle = m_Loop->AddFrameThrottle(1);
+		}
+		Refresh();
+	}
+
+	~VisibilityTracker() {
+		::KillTimer(m_Window, kPollTimerId);
+		if (m_Loop) {
+			m_Loop->RemoveFrameThrottle(m_Throttle);
+		}
+	}
+
+	VisibilityTracker(const VisibilityTracker&) = delete;
+	VisibilityTracker& operator=(const VisibilityTracker&) = delete;
+
+	void SetPolicy(VisibilityState state, VisibilityThrottle throttle) {
+		m_Policy[static_cast<size_t>(state)] = throttle;
+		ApplyTimers();
+		ApplyFrameThrottle();
+	}
+
+	VisibilityThrottle GetPolicy(VisibilityState state) const {
+		return m_Policy[static_cast<size_t>(state)];
+	}
+
+	VisibilityState GetState() const {
+		return m_State;
+	}
+
+	// Call from the window procedure for every message. Returns true for the tracker's
+	// own poll timer, which needs no further handling.
+	bool HandleMessage(UINT message, WPARAM wParam, LPARAM) {
+		switch (message) {
+		case WM_TIMER:
+			if (wParam == kPollTimerId) {
+				Refresh();
+				return true;
+			}
+			break;
+		case WM_SIZE:
+		case WM_ACTIVATE:
+		case WM_ACTIVATEAPP:
+		case WM_SHOWWINDOW:
+		case WM_WINDOWPOSCHANGED:
+			Refresh();
+			break;
+		}
+		return false;
+	}
+
+	// Re-evaluates the visibility state. Called automatically; call it directly after
+	// anything the tracker cannot see, like another window moving on top.
+	void Refresh() {
+		VisibilityState state = ComputeState();
+		if (state == m_State && m_Initialized) {
+			return;
+		}
+		VisibilityState previous = m_State;
+		m_State = state;
+		m_Initialized = true;
+		++m_Transitions;
+		// Re-creating a timer restarts its period, so leave timers alone unless the rate changed
+		if (GetPolicy(state).timerMultiplier != GetPolicy(previous).timerMultiplier || m_Transitions == 1) {
+			ApplyTimers();
+		}
+		ApplyFrameThrottle();
+
+		// Poll only while not in front; being covered, uncovered or cloaked sends no message
+		if (state == VisibilityState::Inactive || state == VisibilityState::Occluded) {
+			::SetTimer(m_Window, kPollTimerId, kPollIntervalMs, NULL);
+		}
+		else {
+			::KillTimer(m_Window, kPollTimerId);
+		}
+
+		// Get a fresh frame on screen as soon as the window becomes more visible
+		if (state < previous && m_Loop) {
+			m_Loop->RequestFrame();
+		}
+	}
+
+	// Call once per frame; returns false if this frame should be skipped. Goes by time
+	// rather than by counting frames, as the loop may already tick slower for this window.
+	bool ShouldRenderFrame() {
+		uint32_t divisor = m_Policy[static_cast<size_t>(m_State)].frameDivisor;
+		RunLoop::Clock::time_point now = RunLoop::Clock::now();
+		bool render = divisor != 0;
+		if (render && divisor > 1) {
+			std::chrono::microseconds interval = GetFrameInterval();
+			render = now - m_LastRender >= interval * divisor - interval / 2;
+		}
+		if (render) {
+			m_LastRender = now;
+			++m_FramesRendered;
+		}
+		else {
+			++m_FramesSkipped;
+		}
+		return render;
+	}
+
+	// Creates or replaces a window timer whose interval follows the throttle policy
+	void SetTimer(UINT_PTR id, UINT elapse) {
+		if (id == kPollTimerId) {
+			throw std::runtime_error("Failed to set timer: the id is reserved for the visibility poll.");
+		}
+		for (Timer& timer : m_Timers) {
+			if (timer.id == id) {
+				timer.elapse = elapse;
+				ApplyTimer(timer);
+				return;
+			}
+		}
+		m_Timers.push_back({ id, elapse });
+		ApplyTimer(m_Timers.back());
+	}
+
+	void KillTimer(UINT_PTR id) {
+		for (size_t i = 0; i < m_Timers.size(); ++i) {
+			if (m_Timers[i].id == id) {
+				::KillTimer(m_Window, id);
+				m_Timers.erase(m_Timers.begin() + i);
+				return;
+			}
+		}
+	}
+
+	uint64_t GetFramesRendered() const {
+		return m_FramesRendered;
+	}
+
+	uint64_t GetFramesSkipped() const {
+		return m_FramesSkipped;
+	}
+
+	uint64_t GetTransitionCount() const {
+		return m_Transitions;
+	}
+
+	// Time frames were paused for this window, during which the loop may not have asked
+	// `ShouldRenderFrame` at all
+	RunLoop::Clock::duration GetPausedTime() const {
+		RunLoop::Clock::duration paused = m_PausedTime;
+		if (m_Paused) {
+			paused += RunLoop::Clock::now() - m_PausedSince;
+		}
+		return paused;
+	}
+
+	// True if DWM hides the window even though it is shown, e.g. on another virtual
+	// desktop. `Window::IsCloaked` asks this too.
+	static bool IsCloaked(HWND window) {
+		DWORD cloaked = 0;
+		return SUCCEEDED(GetDwmApi().DwmGetWindowAttribute(window, kDwmCloakedAttribute, &cloaked, sizeof(cloaked))) && cloaked != 0;
+	}
+
+	// True if the window rectangle is entirely covered by visible top-level windows above it
+	static bool IsOccluded(HWND window) {
+		RECT rect = {};
+		if (!GetWindowRect(window, &rect) || IsRectEmpty(&rect)) {
+			return true;
+		}
+		HRGN remaining = CreateRectRgnIndirect(&rect);
+		HRGN other = CreateRectRgn(0, 0, 0, 0);
+		bool occluded = false;
+		for (HWND above = GetWindow(window, GW_HWNDPREV); above; above = GetWindow(above, GW_HWNDPREV)) {
+			if (!CoversOthers(above)) {
+				continue;
+			}
+			RECT aboveRect = {};
+			GetWindowRect(above, &aboveRect);
+			SetRectRgn(other, aboveRect.left, aboveRect.top, aboveRect.right, aboveRect.bottom);
+			if (CombineRgn(remaining, remaining, other, RGN_DIFF) == NULLREGION) {
+				occluded = true;
+				break;
+			}
+		}
+		DeleteObject(other);
+		DeleteObject(remaining);
+		return occluded;
+	}
+
+private:
+	static constexpr UINT kPollIntervalMs = 500;
+	static constexpr DWORD kDwmCloakedAttribute = 14; // DWMWA_CLOAKED
+
+	struct Timer {
+		UINT_PTR id;
+		UINT elapse;
+	};
+
+	VisibilityState ComputeState() const {
+		HWND root = GetAncestor(m_Window, GA_ROOT);
+		if (!root) {
+			root = m_Window;
+		}
+		if (IsIconic(root) || !IsWindowVisible(root)) {
+			return VisibilityState::Minimized;
+		}
+		if (IsCloaked(root) || IsOccluded(root)) {
+			return VisibilityState::Occluded;
+		}
+		if (GetForegroundWindow() != root) {
+			return VisibilityState::Inactive;
+		}
+		return VisibilityState::Visible;
+	}
+
+	// Layered and transparent windows may let the window below show through
+	static bool CoversOthers(HWND window) {
+		if (!IsWindowVisible(window) || IsIconic(window) || IsCloaked(window)) {
+			return false;
+		}
+		LONG exStyle = GetWindowLong(window, GWL_EXSTYLE);
+		return !(exStyle & (WS_EX_LAYERED | WS_EX_TRANSPARENT));
+	}
+
+	std::chrono::microseconds GetFrameInterval() const {
+		return m_Loop ? m_Loop->GetFrameInterval() : std::chrono::microseconds(16667);
+	}
+
+	// Passes the current frame divisor to the loop and keeps the paused time
+	void ApplyFrameThrottle() {
+		uint32_t divisor = m_Policy[static_cast<size_t>(m_State)].frameDivisor;
+		bool paused = divisor == 0;
+		if (paused != m_Paused) {
+			RunLoop::Clock::time_point now = RunLoop::Clock::now();
+			if (m_Paused) {
+				m_PausedTime += now - m_PausedSince;
+			}
+			m_PausedSince = now;
+			m_Paused = paused;
+		}
+		if (m_Loop) {
+			m_Loop->SetFrameThrottle(m_Throttle, divisor);
+		}
+	}
+
+	void ApplyTimers() {
+		for (Timer& timer : m_Timers) {
+			ApplyTimer(timer);
+		}
+	}
+
+	void ApplyTimer(const Timer& timer) {
+		uint32_t multiplier = m_Policy[static_cast<size_t>(m_State)].timerMultiplier;
+		if (multiplier == 0) {
+			::KillTimer(m_Window, timer.id);
+		}
+		else {
+			::SetTimer(m_Window, timer.id, timer.elapse * multiplier, NULL);
+		}
+	}
+
+	HWND m_Window;
+	RunLoop* m_Loop;
+	size_t m_Throttle = 0;
+	VisibilityState m_State = VisibilityState::Visible;
+	bool m_Initialized = false;
+	VisibilityThrottle m_Policy[4];
+	std::vector<Timer> m_Timers;
+	RunLoop::Clock::time_point m_LastRender;
+	bool m_Paused = false;
+	RunLoop::Clock::time_point m_PausedSince;
+	RunLoop::Clock::duration m_PausedTime = RunLoop::Clock::duration::zero();
+	uint64_t m_FramesRendered = 0;
+	uint64_t m_FramesSkipped = 0;
+	uint64_t m_Transitions = 0;
+};
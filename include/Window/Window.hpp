@@ -2,33 +2,54 @@
 
 #include <stdint.h>
 #include <string>
+#include <memory>
+#include <optional>
+#include <algorithm>
+#include <source_location>
 #include <windows.h>
 
 #include "WindowClass.hpp"
+#include "MonitorTopology.hpp"
+#include "RedrawSuspend.hpp"
+#include "SubclassChain.hpp"
+#include "ClipboardImage.hpp"
+#include "VisibilityTracker.hpp"
+#include "../System/ApiTable.hpp"
+#include "../Diagnostics/GuiResources.hpp"
+#include "../Diagnostics/MemoryLedger.hpp"
+#include "../Diagnostics/Log.hpp"
 
 class Window {
 public:
 	// Constructor with only class name, hInstance and window name
-	Window(LPCWSTR windowClassName, LPCWSTR windowName, HINSTANCE hInstance) {
+	Window(LPCWSTR windowClassName, LPCWSTR windowName, HINSTANCE hInstance, const std::source_location& location = std::source_location::current()) {
 		m_NativeWindow = CreateWindowEx(0, windowClassName, windowName, WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, NULL, NULL, hInstance, NULL);
 		if (!m_NativeWindow) {
 			DWORD error = GetLastError();
 			throw std::runtime_error("Failed to create window. Error code: " + std::to_string(error));
 		}
+		TrackGuiObject(m_NativeWindow, GuiObjectType::Window, NULL, location);
 	}
 
 	// Constructor that are closer to `CreateWindowEx`
-	Window(LPCWSTR windowClassName, LPCWSTR windowName, HINSTANCE hInstance, int x, int y, int width, int height, DWORD style, DWORD exStyle = 0) {
+	Window(LPCWSTR windowClassName, LPCWSTR windowName, HINSTANCE hInstance, int x, int y, int width, int height, DWORD style, DWORD exStyle = 0, const std::source_location& location = std::source_location::current()) {
 		m_NativeWindow = CreateWindowEx(exStyle, windowClassName, windowName, style, x, y, width, height, NULL, NULL, hInstance, NULL);
 		if (!m_NativeWindow) {
 			throw std::runtime_error("Failed to create window.");
 		}
+		TrackGuiObject(m_NativeWindow, GuiObjectType::Window, NULL, location);
 	}
 
-	// Destroys the window
+	// Destroys the window and reports GDI/USER objects still attributed to it as leaks
 	~Window() {
 		if (m_NativeWindow) {
+			ReleaseBackgroundBrush();
+			GetGuiObjectTracker().OnOwnerDestroyed(reinterpret_cast<uintptr_t>(m_NativeWindow));
+			UntrackGuiObject(m_NativeWindow);
 			DestroyWindow(m_NativeWindow);
+			// The chain sees the window's last messages, then releases its charge
+			m_SubclassChain.reset();
+			GetMemoryLedger().RemoveOwner(reinterpret_cast<uintptr_t>(m_NativeWindow));
 		}
 	}
 
@@ -86,11 +107,44 @@ public:
 		return IsIconic(m_NativeWindow) != 0;
 	}
 
+	// True if DWM hides the window even though it is shown, e.g. on another virtual desktop
+	bool IsCloaked() const {
+		return VisibilityTracker::IsCloaked(m_NativeWindow);
+	}
+
 
 	void SetPosition(int x, int y) {
 		SetWindowPos(m_NativeWindow, NULL, x, y, 0, 0, SWP_NOSIZE | SWP_NOZORDER);
 	}
 
+	// Monitor the window is mostly on, from the cached topology. Returned by value, since
+	// the cache is replaced on the next query after a layout change.
+	MonitorInfo GetMonitor() const {
+		return MonitorTopology::Get().FromWindow(m_NativeWindow);
+	}
+
+	// Centers the window in the work area of its monitor
+	void CenterOnMonitor() {
+		RECT rect = {};
+		GetWindowRect(m_NativeWindow, &rect);
+		RECT work = MonitorTopology::Get().FromRect(rect).workArea;
+		int width = rect.right - rect.left;
+		int height = rect.bottom - rect.top;
+		SetPosition(work.left + (work.right - work.left - width) / 2, work.top + (work.bottom - work.top - height) / 2);
+	}
+
+	// Moves the window into the work area of its monitor, shrinking it if it is larger
+	void FitToWorkArea() {
+		RECT rect = {};
+		GetWindowRect(m_NativeWindow, &rect);
+		RECT work = MonitorTopology::Get().FromRect(rect).workArea;
+		int width = std::min(static_cast<int>(rect.right - rect.left), static_cast<int>(work.right - work.left));
+		int height = std::min(static_cast<int>(rect.bottom - rect.top), static_cast<int>(work.bottom - work.top));
+		int x = std::max(static_cast<int>(work.left), std::min(static_cast<int>(rect.left), static_cast<int>(work.right) - width));
+		int y = std::max(static_cast<int>(work.top), std::min(static_cast<int>(rect.top), static_cast<int>(work.bottom) - height));
+		SetWindowPos(m_NativeWindow, NULL, x, y, width, height, SWP_NOZORDER | SWP_NOACTIVATE);
+	}
+
 	void Maximize() {
 		ShowWindow(m_NativeWindow, SW_MAXIMIZE);
 	}
@@ -103,11 +157,31 @@ public:
 		ShowWindow(m_NativeWindow, SW_RESTORE);
 	}
 
-	// Sets thw window procedure. If possible this should have been set in the WindowClass constructor
+	// Sets thw window procedure. If possible this should have been set in the WindowClass constructor.
+	// With message layers installed, this replaces the procedure underneath them.
 	void SetWindowProcedure(WNDPROC windowProc) {
+		if (m_SubclassChain) {
+			m_SubclassChain->SetBaseProcedure(windowProc);
+			return;
+		}
 		SetWindowLongPtr(m_NativeWindow, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(windowProc));
 	}
 
+	// Layers a handler over the window procedure that is only called for the messages in
+	// `mask`; returns an id for `RemoveMessageLayer`
+	size_t AddMessageLayer(const MessageMask& mask, SubclassChain::Handler handler) {
+		if (!m_SubclassChain) {
+			m_SubclassChain = std::make_unique<SubclassChain>(m_NativeWindow);
+		}
+		return m_SubclassChain->AddLayer(mask, std::move(handler));
+	}
+
+	void RemoveMessageLayer(size_t id) {
+		if (m_SubclassChain) {
+			m_SubclassChain->RemoveLayer(id);
+		}
+	}
+
 	void SetTransparency(BYTE alpha) {
 		SetWindowLong(m_NativeWindow, GWL_EXSTYLE, GetWindowLong(m_NativeWindow, GWL_EXSTYLE) | WS_EX_LAYERED);
 		SetLayeredWindowAttributes(m_NativeWindow, 0, alpha, LWA_ALPHA);
@@ -159,37 +233,60 @@ public:
 	}
 
 	void CopyToClipboard(const std::wstring& text) {
-		if (OpenClipboard(m_NativeWindow)) {
-			EmptyClipboard();
-			HGLOBAL hGlobal = GlobalAlloc(GMEM_MOVEABLE, (text.size() + 1) * sizeof(wchar_t));
+		if (!OpenClipboard(m_NativeWindow)) {
+			LogWarning("Failed to open the clipboard. Error code: {}", GetLastError());
+			return;
+		}
+		EmptyClipboard();
+		HGLOBAL hGlobal = GlobalAlloc(GMEM_MOVEABLE, (text.size() + 1) * sizeof(wchar_t));
+		wchar_t* pGlobal = hGlobal ? static_cast<wchar_t*>(GlobalLock(hGlobal)) : nullptr;
+		if (pGlobal) {
+			wcscpy_s(pGlobal, text.size() + 1, text.c_str());
+			GlobalUnlock(hGlobal);
+			if (!SetClipboardData(CF_UNICODETEXT, hGlobal)) {
+				LogWarning("Failed to set clipboard data. Error code: {}", GetLastError());
+				GlobalFree(hGlobal);
+			}
+		}
+		else {
+			LogWarning("Failed to allocate {} bytes of clipboard data. Error code: {}", (text.size() + 1) * sizeof(wchar_t), GetLastError());
 			if (hGlobal) {
-				wchar_t* pGlobal = static_cast<wchar_t*>(GlobalLock(hGlobal));
-				if (pGlobal) {
-					wcscpy_s(pGlobal, text.size() + 1, text.c_str());
-					GlobalUnlock(hGlobal);
-					SetClipboardData(CF_UNICODETEXT, hGlobal);
-				}
+				GlobalFree(hGlobal);
 			}
-			CloseClipboard();
 		}
+		CloseClipboard();
 	}
 
 	std::wstring PasteFromClipboard() {
 		std::wstring result;
-		if (OpenClipboard(m_NativeWindow)) {
-			HANDLE hData = GetClipboardData(CF_UNICODETEXT);
-			if (hData) {
-				wchar_t* pText = static_cast<wchar_t*>(GlobalLock(hData));
-				if (pText) {
-					result = pText;
-					GlobalUnlock(hData);
-				}
+		if (!OpenClipboard(m_NativeWindow)) {
+			LogWarning("Failed to open the clipboard. Error code: {}", GetLastError());
+			return result;
+		}
+		// No text on the clipboard is not an error
+		if (HANDLE hData = GetClipboardData(CF_UNICODETEXT)) {
+			if (wchar_t* pText = static_cast<wchar_t*>(GlobalLock(hData))) {
+				result = pText;
+				GlobalUnlock(hData);
+			}
+			else {
+				LogWarning("Failed to lock clipboard data. Error code: {}", GetLastError());
 			}
-			CloseClipboard();
 		}
+		CloseClipboard();
 		return result;
 	}
 
+	// Copies top-down, premultiplied BGRA pixels as `CF_DIBV5` and PNG. Use
+	// `DelayedClipboardImage` to defer the encoding of large images until they are pasted.
+	bool CopyImageToClipboard(const void* pixels, UINT width, UINT height, UINT stride) {
+		return ClipboardImage::Copy(m_NativeWindow, pixels, width, height, stride);
+	}
+
+	std::optional<BgraImage> PasteImageFromClipboard() {
+		return ClipboardImage::Paste(m_NativeWindow);
+	}
+
 	void SetTimer(UINT_PTR id, UINT elapse) {
 		::SetTimer(m_NativeWindow, id, elapse, NULL);
 	}
@@ -202,17 +299,23 @@ public:
 		TrackPopupMenu(menu, TPM_RIGHTBUTTON, x, y, 0, m_NativeWindow, NULL);
 	}
 
+	// Falls back to the system DPI on systems without per-monitor DPI support
 	UINT GetDPI() const {
-		return GetDpiForWindow(m_NativeWindow);
+		return GetUser32Api().GetDpiForWindow(m_NativeWindow);
 	}
 
+	// Falls back to system DPI awareness on systems without per-monitor awareness
 	void SetDPIAwareness() {
-		SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+		GetUser32Api().SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
 	}
 
-	void SetBackgroundColor(COLORREF color) {
-		HBRUSH brush = CreateSolidBrush(color);
+	// Replaces the class background brush. The brush of a previous call is deleted once
+	// the class no longer uses it.
+	void SetBackgroundColor(COLORREF color, const std::source_location& location = std::source_location::current()) {
+		HBRUSH brush = TrackGuiObject(CreateSolidBrush(color), GuiObjectType::Brush, m_NativeWindow, location);
 		SetClassLongPtr(m_NativeWindow, GCLP_HBRBACKGROUND, reinterpret_cast<LONG_PTR>(brush));
+		ReleaseBackgroundBrush();
+		m_BackgroundBrush = brush;
 		InvalidateRect(m_NativeWindow, NULL, TRUE);
 	}
 
@@ -234,6 +337,17 @@ public:
 		return std::wstring(buffer);
 	}
 
+	// Suspends drawing until the returned scope ends, then redraws once
+	RedrawSuspend SuspendRedraw() const {
+		return RedrawSuspend(m_NativeWindow);
+	}
+
+	// Memory the library accounts to this window (back buffers, surfaces it presents,
+	// channels, subclass layers, ...) by category
+	MemoryOwnerReport GetMemoryUsage() const {
+		return GetMemoryLedger().GetOwnerReport(reinterpret_cast<uintptr_t>(m_NativeWindow));
+	}
+
 	// Get the HWND handle
 	HWND GetHandle() const {
 		return m_NativeWindow;
@@ -249,5 +363,22 @@ public:
 	}
 
 private:
+	// Deletes the background brush unless the class still paints with it, in which case
+	// it stays alive for the other windows of the class
+	void ReleaseBackgroundBrush() {
+		if (!m_BackgroundBrush) {
+			return;
+		}
+		if (GetClassLongPtr(m_NativeWindow, GCLP_HBRBACKGROUND) == reinterpret_cast<ULONG_PTR>(m_BackgroundBrush)) {
+			GetGuiObjectTracker().SetOwner(reinterpret_cast<uintptr_t>(m_BackgroundBrush), 0);
+		}
+		else {
+			DeleteTrackedObject(m_BackgroundBrush);
+		}
+		m_BackgroundBrush = NULL;
+	}
+
 	HWND m_NativeWindow;
+	HBRUSH m_BackgroundBrush = NULL;
+	std::unique_ptr<SubclassChain> m_SubclassChain;
 };
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include <windows.h>
 #include <stdexcept> // For std::runtime_error
 
+#include "../Diagnostics/Log.hpp"
+
 class WindowClass {
 public:
     // Default constructor
@@ -84,7 +86,7 @@ public:
     // Register the window class
     bool Register() {
         if (!RegisterClass(&m_NativeClass)) {
-            // Handle error (e.g., log or throw an exception)
+            LogError("Failed to register window class {}. Error code: {}", m_NativeClass.lpszClassName, GetLastError());
             return false;
         }
         return true;
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <windows.h>
+
+#include "WindowIndexCore.hpp"
+
+// Index of the desktop's top-level windows by title prefix, class and process, built
+// once with `EnumWindows` and then kept current by out-of-context WinEvent hooks for
+// window creation, destruction, showing and title changes. Lookups never enumerate or
+// query other windows, which makes them cheap enough for automation and snapping code
+// that used to scan on every call.
+//
+// WinEvents are delivered to the creating thread while it dispatches messages, so that
+// thread must run a message loop. At most one index per thread.
+class WindowIndex {
+public:
+	WindowIndex() {
+		if (Current()) {
+			throw std::runtime_error("A WindowIndex already exists on this thread.");
+		}
+		Current() = this;
+		m_CreateHook = SetWinEventHook(EVENT_OBJECT_CREATE, EVENT_OBJECT_SHOW, NULL, &WindowIndex::OnWinEvent, 0, 0, WINEVENT_OUTOFCONTEXT);
+		m_NameHook = SetWinEventHook(EVENT_OBJECT_NAMECHANGE, EVENT_OBJECT_NAMECHANGE, NULL, &WindowIndex::OnWinEvent, 0, 0, WINEVENT_OUTOFCONTEXT);
+		if (!m_CreateHook || !m_NameHook) {
+			DWORD error = GetLastError();
+			Unhook();
+			Current() = nullptr;
+			throw std::runtime_error("Failed to install window index hooks. Error code: " + std::to_string(error));
+		}
+		Rebuild();
+	}
+
+	~WindowIndex() {
+		Unhook();
+		Current() = nullptr;
+	}
+
+	WindowIndex(const WindowIndex&) = delete;
+	WindowIndex& operator=(const WindowIndex&) = delete;
+
+	// Re-enumerates every top-level window. Only needed if events might have been missed.
+	void Rebuild() {
+		m_Core.Clear();
+		EnumWindows([](HWND window, LPARAM param) -> BOOL {
+			reinterpret_cast<WindowIndex*>(param)->Add(window);
+			return TRUE;
+		}, reinterpret_cast<LPARAM>(this));
+	}
+
+	const IndexedWindow* Find(HWND window) const {
+		return m_Core.Find(reinterpret_cast<uintptr_t>(window));
+	}
+
+	// Windows whose title starts with `prefix`, ignoring case
+	std::vector<HWND> FindByTitlePrefix(const std::wstring& prefix, size_t limit = SIZE_MAX) const {
+		return ToHandles(m_Core.FindByTitlePrefix(prefix, limit));
+	}
+
+	std::vector<HWND> FindByTitle(const std::wstring& title) const {
+		return ToHandles(m_Core.FindByTitle(title));
+	}
+
+	std::vector<HWND> FindByClass(const std::wstring& className) const {
+		return ToHandles(m_Core.FindByClass(className));
+	}
+
+	std::vector<HWND> FindByProcess(DWORD processId) const {
+		return ToHandles(m_Core.FindByProcess(processId));
+	}
+
+	size_t GetCount() const {
+		return m_Core.GetCount();
+	}
+
+	// Events that changed the index since it was built
+	uint64_t GetUpdateCount() const {
+		return m_Updates;
+	}
+
+	const WindowIndexCore& GetCore() const {
+		return m_Core;
+	}
+
+private:
+	static WindowIndex*& Current() {
+		static thread_local WindowIndex* current = nullptr;
+		return current;
+	}
+
+	static void CALLBACK OnWinEvent(HWINEVENTHOOK, DWORD event, HWND window, LONG object, LONG child, DWORD, DWORD) {
+		WindowIndex* index = Current();
+		if (!index || !window || object != OBJID_WINDOW || child != CHILDID_SELF) {
+			return;
+		}
+		switch (event) {
+		case EVENT_OBJECT_CREATE:
+		case EVENT_OBJECT_SHOW:
+			if (index->Add(window)) {
+				++index->m_Updates;
+			}
+			break;
+		case EVENT_OBJECT_DESTROY:
+			if (index->m_Core.Find(reinterpret_cast<uintptr_t>(window))) {
+				index->m_Core.Remove(reinterpret_cast<uintptr_t>(window));
+				++index->m_Updates;
+			}
+			break;
+		case EVENT_OBJECT_NAMECHANGE:
+			if (index->m_Core.SetTitle(reinterpret_cast<uintptr_t>(window), GetTitle(window))) {
+				++index->m_Updates;
+			}
+			break;
+		}
+	}
+
+	// Indexes `window` if it is top-level; message-only and child windows are skipped
+	bool Add(HWND window) {
+		if (GetAncestor(window, GA_PARENT) != GetDesktopWindow()) {
+			return false;
+		}
+		IndexedWindow entry;
+		entry.handle = reinterpret_cast<uintptr_t>(window);
+		entry.title = GetTitle(window);
+		wchar_t className[256];
+		int length = GetClassNameW(window, className, 256);
+		entry.className.assign(className, length > 0 ? length : 0);
+		DWORD processId = 0;
+		GetWindowThreadProcessId(window, &processId);
+		entry.processId = processId;
+		m_Core.Upsert(entry);
+		return true;
+	}
+
+	// Windows of other processes are read from the window manager's copy of the title,
+	// without sending them WM_GETTEXT, so a hung window cannot block the index
+	static std::wstring GetTitle(HWND window) {
+		wchar_t buffer[256];
+		int length = GetWindowTextW(window, buffer, 256);
+		return std::wstring(buffer, length > 0 ? length : 0);
+	}
+
+	static std::vector<HWND> ToHandles(const std::vector<uintptr_t>& handles) {
+		std::vector<HWND> windows;
+		windows.reserve(handles.size());
+		for (uintptr_t handle : handles) {
+			windows.push_back(reinterpret_cast<HWND>(handle));
+		}
+		return windows;
+	}
+
+	void Unhook() {
+		if (m_CreateHook) {
+			UnhookWinEvent(m_CreateHook);
+			m_CreateHook = NULL;
+		}
+		if (m_NameHook) {
+			UnhookWinEvent(m_NameHook);
+			m_NameHook = NULL;
+		}
+	}
+
+	WindowIndexCore m_Core;
+	HWINEVENTHOOK m_CreateHook = NULL;
+	HWINEVENTHOOK m_NameHook = NULL;
+	uint64_t m_Updates = 0;
+};
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cwctype>
+#include <unordered_map>
+
+#include "../Diagnostics/MemoryLedger.hpp"
+
+// A window as the index knows it
+struct IndexedWindow {
+	uintptr_t handle = 0;
+	std::wstring title;
+	std::wstring className;
+	uint32_t processId = 0;
+};
+
+// In-memory index of windows by handle, case-insensitive title prefix, class name and
+// process. Titles live in a trie whose nodes are recycled when titles change, so a
+// window with a ticking title does not grow it. Platform independent; `WindowIndex`
+// feeds it from `EnumWindows` and WinEvents. Its tables are charged to the memory ledger
+// as an unattributed cache, and the titles and class names it copies as strings.
+class WindowIndexCore {
+public:
+	WindowIndexCore() {
+		m_Nodes.emplace_back();
+		UpdateMemory();
+	}
+
+	// Adds a window or replaces everything known about it
+	void Upsert(const IndexedWindow& window) {
+		Remove(window.handle);
+		m_Windows[window.handle] = window;
+		InsertTitle(window.handle, window.title);
+		m_ByClass[window.className].push_back(window.handle);
+		m_ByProcess[window.processId].push_back(window.handle);
+		m_StringBytes += StringBytes(window.title) + StringBytes(window.className);
+		UpdateMemory();
+	}
+
+	// Returns false if the window is not indexed
+	bool SetTitle(uintptr_t handle, const std::wstring& title) {
+		auto it = m_Windows.find(handle);
+		if (it == m_Windows.end()) {
+			return false;
+		}
+		if (it->second.title != title) {
+			RemoveTitle(handle, it->second.title);
+			m_StringBytes += StringBytes(title) - StringBytes(it->second.title);
+			it->second.title = title;
+			InsertTitle(handle, title);
+			UpdateMemory();
+		}
+		return true;
+	}
+
+	void Remove(uintptr_t handle) {
+		auto it = m_Windows.find(handle);
+		if (it == m_Windows.end()) {
+			return;
+		}
+		RemoveTitle(handle, it->second.title);
+		RemoveFrom(m_ByClass, it->second.className, handle);
+		RemoveFrom(m_ByProcess, it->second.processId, handle);
+		m_StringBytes -= StringBytes(it->second.title) + StringBytes(it->second.className);
+		m_Windows.erase(it);
+		UpdateMemory();
+	}
+
+	void Clear() {
+		m_Windows.clear();
+		m_ByClass.clear();
+		m_ByProcess.clear();
+		m_Nodes.assign(1, Node());
+		m_FreeNodes.clear();
+		m_StringBytes = 0;
+		UpdateMemory();
+	}
+
+	const IndexedWindow* Find(uintptr_t handle) const {
+		auto it = m_Windows.find(handle);
+		return it == m_Windows.end() ? nullptr : &it->second;
+	}
+
+	// Windows whose title starts with `prefix`, ignoring case; at most `limit` of them
+	std::vector<uintptr_t> FindByTitlePrefix(const std::wstring& prefix, size_t limit = SIZE_MAX) const {
+		std::vector<uintptr_t> result;
+		uint32_t node = 0;
+		for (wchar_t c : prefix) {
+			node = Child(node, Fold(c));
+			if (node == kNone) {
+				return result;
+			}
+		}
+		Collect(node, limit, result);
+		return result;
+	}
+
+	// Windows whose title is exactly `title`, ignoring case
+	std::vector<uintptr_t> FindByTitle(const std::wstring& title) const {
+		uint32_t node = 0;
+		for (wchar_t c : title) {
+			node = Child(node, Fold(c));
+			if (node == kNone) {
+				return {};
+			}
+		}
+		return m_Nodes[node].windows;
+	}
+
+	std::vector<uintptr_t> FindByClass(const std::wstring& className) const {
+		auto it = m_ByClass.find(className);
+		return it == m_ByClass.end() ? std::vector<uintptr_t>() : it->second;
+	}
+
+	std::vector<uintptr_t> FindByProcess(uint32_t processId) const {
+		auto it = m_ByProcess.find(processId);
+		return it == m_ByProcess.end() ? std::vector<uintptr_t>() : it->second;
+	}
+
+	size_t GetCount() const {
+		return m_Windows.size();
+	}
+
+	// Trie nodes in use, for checking that title churn does not leak nodes
+	size_t GetNodeCount() const {
+		return m_Nodes.size() - m_FreeNodes.size();
+	}
+
+private:
+	static constexpr uint32_t kNone = UINT32_MAX;
+	// Approximate table overhead of one window: its record and hash node, its entries in
+	// the class and process lists and in a trie node
+	static constexpr size_t kWindowBytes = sizeof(IndexedWindow) + 2 * sizeof(void*) + 3 * sizeof(uintptr_t);
+
+	struct Node {
+		// Sorted by character
+		std::vector<std::pair<wchar_t, uint32_t>> children;
+		std::vector<uintptr_t> windows;
+	};
+
+	static uint64_t StringBytes(const std::wstring& text) {
+		return text.size() * sizeof(wchar_t);
+	}
+
+	void UpdateMemory() {
+		m_CacheMemory.Resize(m_Nodes.capacity() * sizeof(Node) + m_Windows.size() * kWindowBytes);
+		m_StringMemory.Resize(m_StringBytes);
+	}
+
+	static wchar_t Fold(wchar_t c) {
+		return static_cast<wchar_t>(std::towlower(static_cast<std::wint_t>(c)));
+	}
+
+	uint32_t Child(uint32_t node, wchar_t c) const {
+		const auto& children = m_Nodes[node].children;
+		auto it = std::lower_bound(children.begin(), children.end(), c, [](const std::pair<wchar_t, uint32_t>& entry, wchar_t key) {
+			return entry.first < key;
+		});
+		return it != children.end() && it->first == c ? it->second : kNone;
+	}
+
+	uint32_t AddChild(uint32_t node, wchar_t c) {
+		uint32_t child;
+		if (!m_FreeNodes.empty()) {
+			child = m_FreeNodes.back();
+			m_FreeNodes.pop_back();
+		}
+		else {
+			child = static_cast<uint32_t>(m_Nodes.size());
+			m_Nodes.emplace_back();
+		}
+		auto& children = m_Nodes[node].children;
+		auto it = std::lower_bound(children.begin(), children.end(), c, [](const std::pair<wchar_t, uint32_t>& entry, wchar_t key) {
+			return entry.first < key;
+		});
+		children.insert(it, { c, child });
+		return child;
+	}
+
+	void InsertTitle(uintptr_t handle, const std::wstring& title) {
+		uint32_t node = 0;
+		for (wchar_t c : title) {
+			wchar_t folded = Fold(c);
+			uint32_t next = Child(node, folded);
+			node = next != kNone ? next : AddChild(node, folded);
+		}
+		m_Nodes[node].windows.push_back(handle);
+	}
+
+	void RemoveTitle(uintptr_t handle, const std::wstring& title) {
+		m_Path.clear();
+		uint32_t node = 0;
+		for (wchar_t c : title) {
+			m_Path.push_back(node);
+			node = Child(node, Fold(c));
+			if (node == kNone) {
+				return;
+			}
+		}
+		auto& windows = m_Nodes[node].windows;
+		windows.erase(std::remove(windows.begin(), windows.end(), handle), windows.end());
+
+		// Prune nodes that no longer lead to any window, bottom up
+		for (size_t depth = title.size(); depth-- > 0;) {
+			Node& current = m_Nodes[node];
+			if (!current.windows.empty() || !current.children.empty()) {
+				break;
+			}
+			uint32_t parent = m_Path[depth];
+			auto& siblings = m_Nodes[parent].children;
+			siblings.erase(std::find_if(siblings.begin(), siblings.end(), [node](const std::pair<wchar_t, uint32_t>& entry) {
+				return entry.second == node;
+			}));
+			m_FreeNodes.push_back(node);
+			node = parent;
+		}
+	}
+
+	void Collect(uint32_t node, size_t limit, std::vector<uintptr_t>& result) const {
+		for (uintptr_t handle : m_Nodes[node].windows) {
+			if (result.size() >= limit) {
+				return;
+			}
+			result.push_back(handle);
+		}
+		for (const auto& child : m_Nodes[node].children) {
+			if (result.size() >= limit) {
+				return;
+			}
+			Collect(child.second, limit, result);
+		}
+	}
+
+	template <typename Map, typename Key>
+	static void RemoveFrom(Map& map, const Key& key, uintptr_t handle) {
+		auto it = map.find(key);
+		if (it == map.end()) {
+			return;
+		}
+		auto& handles = it->second;
+		handles.erase(std::remove(handles.begin(), handles.end(), handle), handles.end());
+		if (handles.empty()) {
+			map.erase(it);
+		}
+	}
+
+	std::unordered_map<uintptr_t, IndexedWindow> m_Windows;
+	std::unordered_map<std::wstring, std::vector<uintptr_t>> m_ByClass;
+	std::unordered_map<uint32_t, std::vector<uintptr_t>> m_ByProcess;
+	std::vector<Node> m_Nodes;
+	std::vector<uint32_t> m_FreeNodes;
+	std::vector<uint32_t> m_Path;
+	uint64_t m_StringBytes = 0;
+	MemoryCharge m_CacheMemory{ 0, MemoryCategory::Cache, 0 };
+	MemoryCharge m_StringMemory{ 0, MemoryCategory::Strings, 0 };
+};
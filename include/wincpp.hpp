@@ -1,5 +1,63 @@
 #pragma once
 
+// -------------- SYSTEM --------------
+#include "System/ApiTable.hpp"
+
+// -------------- IPC --------------
+#include "Ipc/FrameRing.hpp"
+#include "Ipc/SharedFrameSurface.hpp"
+#include "Ipc/MessageRing.hpp"
+#include "Ipc/WindowChannel.hpp"
+
+// -------------- DIAGNOSTICS --------------
+#include "Diagnostics/HangDetector.hpp"
+#include "Diagnostics/HangWatchdog.hpp"
+#include "Diagnostics/LatencyHistogram.hpp"
+#include "Diagnostics/QueueLatencyMonitor.hpp"
+#include "Diagnostics/GuiObjectTracker.hpp"
+#include "Diagnostics/GuiResources.hpp"
+#include "Diagnostics/MemoryLedger.hpp"
+#include "Diagnostics/MemoryOverlay.hpp"
+#include "Diagnostics/RingLogger.hpp"
+#include "Diagnostics/Log.hpp"
+
+// -------------- LOOP --------------
+#include "Loop/RunLoop.hpp"
+#include "Loop/CompletionQueue.hpp"
+#include "Loop/AsyncIo.hpp"
+#include "Loop/ModalLoopTicker.hpp"
+#include "Loop/IdleTaskQueue.hpp"
+#include "Loop/LaneScheduler.hpp"
+#include "Loop/UiScheduler.hpp"
+#include "Loop/UiJob.hpp"
+
+// -------------- RENDER --------------
+#include "Render/TripleBuffer.hpp"
+#include "Render/RenderThread.hpp"
+#include "Render/PixelConversion.hpp"
+
 // -------------- WINDOW --------------
 #include "Window/Window.hpp"
 #include "Window/WindowClass.hpp"
+#include "Window/VisibilityTracker.hpp"
+#include "Window/WindowIndexCore.hpp"
+#include "Window/WindowIndex.hpp"
+#include "Window/MonitorTopology.hpp"
+#include "Window/RedrawSuspend.hpp"
+#include "Window/MessageMask.hpp"
+#include "Window/SubclassChain.hpp"
+#include "Window/ClipboardImage.hpp"
+#include "Window/DelayedClipboardImage.hpp"
+
+// -------------- EVENT --------------
+#include "Event/Signal.hpp"
+#include "Event/WindowEvents.hpp"
+#include "Event/Property.hpp"
+#include "Event/WindowBinding.hpp"
+
+// -------------- UI --------------
+#include "Ui/UiLayout.hpp"
+#include "Ui/UiLayoutFile.hpp"
+#include "Ui/UiTree.hpp"
+#include "Ui/DialogTemplate.hpp"
+#include "Ui/Dialog.hpp"
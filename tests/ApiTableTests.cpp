@@ -0,0 +1,105 @@
+#include "pch.h"
+
+#include "../include/System/ApiTable.hpp"
+
+namespace {
+	UINT WINAPI StubDpiForWindow(HWND) {
+		return 144;
+	}
+
+	HRESULT WINAPI StubDwmFlush() {
+		return S_OK;
+	}
+
+	HRESULT WINAPI StubDpiForMonitor(HMONITOR, int, UINT* dpiX, UINT* dpiY) {
+		*dpiX = 192;
+		*dpiY = 192;
+		return S_OK;
+	}
+}
+
+TEST(ApiTable, TablesAreResolvedOnce) {
+	EXPECT_EQ(&GetUser32Api(), &GetUser32Api());
+	EXPECT_EQ(&GetDwmApi(), &GetDwmApi());
+	EXPECT_EQ(&GetShcoreApi(), &GetShcoreApi());
+	EXPECT_EQ(&GetDbgHelpApi(), &GetDbgHelpApi());
+}
+
+TEST(ApiTable, EntriesAreNeverNull) {
+	const User32Api& user32 = GetUser32Api();
+	EXPECT_NE(user32.GetDpiForWindow, nullptr);
+	EXPECT_NE(user32.GetDpiForSystem, nullptr);
+	EXPECT_NE(user32.SetProcessDpiAwarenessContext, nullptr);
+	EXPECT_NE(user32.AdjustWindowRectExForDpi, nullptr);
+	EXPECT_NE(user32.GetSystemMetricsForDpi, nullptr);
+	const DwmApi& dwm = GetDwmApi();
+	EXPECT_NE(dwm.DwmGetWindowAttribute, nullptr);
+	EXPECT_NE(dwm.DwmSetWindowAttribute, nullptr);
+	EXPECT_NE(dwm.DwmFlush, nullptr);
+	EXPECT_NE(dwm.DwmIsCompositionEnabled, nullptr);
+	EXPECT_NE(GetShcoreApi().GetDpiForMonitor, nullptr);
+	EXPECT_NE(GetDbgHelpApi().MiniDumpWriteDump, nullptr);
+}
+
+#ifndef _WIN32
+TEST(ApiTable, StubTableUsesFallbacks) {
+	const User32Api& user32 = GetUser32Api();
+	EXPECT_FALSE(user32.hasPerMonitorDpi);
+	EXPECT_EQ(user32.GetDpiForWindow(nullptr), 96u);
+	EXPECT_EQ(user32.GetDpiForSystem(), 96u);
+	RECT rect = { 1, 2, 3, 4 };
+	EXPECT_TRUE(user32.AdjustWindowRectExForDpi(&rect, 0, FALSE, 0, 96));
+	EXPECT_EQ(rect.left, 1);
+	EXPECT_EQ(rect.bottom, 4);
+
+	const DwmApi& dwm = GetDwmApi();
+	EXPECT_FALSE(dwm.available);
+	EXPECT_EQ(dwm.DwmFlush(), E_NOTIMPL);
+	BOOL enabled = TRUE;
+	EXPECT_EQ(dwm.DwmIsCompositionEnabled(&enabled), S_OK);
+	EXPECT_FALSE(enabled);
+
+	UINT dpiX = 0;
+	UINT dpiY = 0;
+	EXPECT_FALSE(GetShcoreApi().hasPerMonitorDpi);
+	EXPECT_EQ(GetShcoreApi().GetDpiForMonitor(nullptr, 0, &dpiX, &dpiY), S_OK);
+	EXPECT_EQ(dpiX, 96u);
+
+	EXPECT_FALSE(GetDbgHelpApi().available);
+	EXPECT_FALSE(GetDbgHelpApi().MiniDumpWriteDump(nullptr, 0, nullptr, 0, nullptr, nullptr, nullptr));
+}
+#endif
+
+TEST(ApiTable, OverrideRedirectsCallsUntilCleared) {
+	const User32Api* resolved = &GetUser32Api();
+
+	User32Api user32 = *resolved;
+	user32.GetDpiForWindow = &StubDpiForWindow;
+	user32.hasPerMonitorDpi = true;
+	OverrideUser32Api(&user32);
+	EXPECT_EQ(&GetUser32Api(), &user32);
+	EXPECT_EQ(GetUser32Api().GetDpiForWindow(nullptr), 144u);
+	OverrideUser32Api(nullptr);
+	EXPECT_EQ(&GetUser32Api(), resolved);
+
+	DwmApi dwm = GetDwmApi();
+	dwm.DwmFlush = &StubDwmFlush;
+	OverrideDwmApi(&dwm);
+	EXPECT_EQ(GetDwmApi().DwmFlush(), S_OK);
+	OverrideDwmApi(nullptr);
+
+	ShcoreApi shcore = GetShcoreApi();
+	shcore.GetDpiForMonitor = &StubDpiForMonitor;
+	OverrideShcoreApi(&shcore);
+	UINT dpiX = 0;
+	UINT dpiY = 0;
+	GetShcoreApi().GetDpiForMonitor(nullptr, 0, &dpiX, &dpiY);
+	EXPECT_EQ(dpiX, 192u);
+	OverrideShcoreApi(nullptr);
+	EXPECT_NE(&GetShcoreApi(), &shcore);
+
+	DbgHelpApi dbghelp = GetDbgHelpApi();
+	OverrideDbgHelpApi(&dbghelp);
+	EXPECT_EQ(&GetDbgHelpApi(), &dbghelp);
+	OverrideDbgHelpApi(nullptr);
+}
@@ -0,0 +1,40 @@
+//
+// Benchmark.h
+//
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+
+// Timing helpers for the benchmark tests. The numbers depend on the machine, so they are
+// printed and recorded as test properties rather than asserted.
+class BenchmarkTimer {
+public:
+	BenchmarkTimer() : m_Start(std::chrono::steady_clock::now()) {}
+
+	double ElapsedNanoseconds() const {
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_Start).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point m_Start;
+};
+
+inline void ReportBenchmark(const char* name, uint64_t operations, double nanoseconds) {
+	double perOperation = operations ? nanoseconds / static_cast<double>(operations) : 0.0;
+	printf("[ BENCH    ] %-48s %12.2f ns/op %12.3f Mop/s\n", name, perOperation, perOperation > 0.0 ? 1000.0 / perOperation : 0.0);
+	::testing::Test::RecordProperty(name, static_cast<int>(perOperation + 0.5));
+}
+
+// Keeps the optimizer from discarding a result the benchmark does not otherwise use
+template <typename T>
+inline void KeepValue(const T& value) {
+#if defined(_MSC_VER)
+	static const T* volatile sink;
+	sink = &value;
+#else
+	asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
@@ -0,0 +1,276 @@
+#include "pch.h"
+
+#include <atomic>
+#include <functional>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/Loop/CompletionQueue.hpp"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	struct TestOperation {
+		TestOperation() {
+			++live;
+		}
+
+		~TestOperation() {
+			--live;
+		}
+
+		int id = 0;
+		int fd = -1;
+		char buffer[64] = {};
+		long bytes = 0;
+		std::function<void(TestOperation&)> callback;
+		TestOperation* previous = nullptr;
+		TestOperation* next = nullptr;
+
+		static inline std::atomic<int> live = 0;
+	};
+}
+
+TEST(CompletionQueue, DispatchRunsAndDeletesCompleted) {
+	CompletionQueue<TestOperation> queue;
+	std::vector<int> ran;
+	for (int i = 0; i < 3; ++i) {
+		TestOperation* operation = new TestOperation();
+		operation->id = i;
+		queue.Start(operation);
+		queue.Complete(operation);
+	}
+	EXPECT_EQ(queue.GetPendingCount(), 3u);
+	EXPECT_EQ(queue.Dispatch([&](TestOperation* operation) { ran.push_back(operation->id); }), 3u);
+	EXPECT_EQ(ran, (std::vector<int>{ 0, 1, 2 }));
+	EXPECT_EQ(queue.GetPendingCount(), 0u);
+	EXPECT_FALSE(queue.HasInFlight());
+	EXPECT_EQ(TestOperation::live.load(), 0);
+}
+
+TEST(CompletionQueue, OnlyFirstCompletionWakesTheLoop) {
+	CompletionQueue<TestOperation> queue;
+	TestOperation* operations[3];
+	for (TestOperation*& operation : operations) {
+		operation = new TestOperation();
+		queue.Start(operation);
+	}
+	EXPECT_TRUE(queue.Complete(operations[0]));
+	EXPECT_FALSE(queue.Complete(operations[1]));
+	queue.Dispatch([](TestOperation*) {});
+	EXPECT_TRUE(queue.Complete(operations[2]));
+	queue.Dispatch([](TestOperation*) {});
+}
+
+TEST(CompletionQueue, ShutdownSeparatesCompletedFromInFlight) {
+	TestOperation::live = 0;
+	{
+		CompletionQueue<TestOperation> queue;
+		std::vector<TestOperation*> kernel;
+		for (int i = 0; i < 6; ++i) {
+			TestOperation* operation = new TestOperation();
+			operation->id = i;
+			queue.Start(operation);
+			if (i % 2) {
+				queue.Complete(operation);
+			}
+			else {
+				kernel.push_back(operation);
+			}
+		}
+		queue.DiscardCompleted();
+		EXPECT_EQ(TestOperation::live.load(), 3);
+		std::vector<int> inFlight;
+		queue.ForEachInFlight([&](TestOperation* operation) { inFlight.push_back(operation->id); });
+		EXPECT_EQ(inFlight, (std::vector<int>{ 4, 2, 0 }));
+		for (TestOperation* operation : kernel) {
+			queue.Reap(operation);
+		}
+		EXPECT_FALSE(queue.HasInFlight());
+		EXPECT_EQ(queue.GetPendingCount(), 0u);
+	}
+	EXPECT_EQ(TestOperation::live.load(), 0);
+}
+
+#ifndef _WIN32
+namespace {
+	// Stand-in for `AsyncIo` on Linux: epoll plays the completion port, a pump thread
+	// performs the reads it reports ready, and an eventfd plays the event the loop waits
+	// on. The `CompletionQueue` in between is the same code `AsyncIo` runs.
+	class EpollIo {
+	public:
+		EpollIo() {
+			m_Epoll = epoll_create1(0);
+			m_Ready = eventfd(0, EFD_NONBLOCK);
+			m_Stop = eventfd(0, 0);
+			epoll_event event = {};
+			event.events = EPOLLIN;
+			event.data.ptr = nullptr;
+			epoll_ctl(m_Epoll, EPOLL_CTL_ADD, m_Stop, &event);
+			m_Pump = std::thread([this] { PumpCompletions(); });
+		}
+
+		~EpollIo() {
+			uint64_t one = 1;
+			(void)!write(m_Stop, &one, sizeof(one));
+			m_Pump.join();
+			m_Queue.DiscardCompleted();
+			// epoll cancels synchronously, so every operation can be reaped at once
+			m_Queue.ForEachInFlight([this](TestOperation* operation) {
+				epoll_ctl(m_Epoll, EPOLL_CTL_DEL, operation->fd, nullptr);
+				m_Queue.Reap(operation);
+			});
+			close(m_Stop);
+			close(m_Ready);
+			close(m_Epoll);
+		}
+
+		void Read(int fd, int id, std::function<void(TestOperation&)> callback) {
+			TestOperation* operation = new TestOperation();
+			operation->id = id;
+			operation->fd = fd;
+			operation->callback = std::move(callback);
+			m_Queue.Start(operation);
+			epoll_event event = {};
+			event.events = EPOLLIN | EPOLLONESHOT;
+			event.data.ptr = operation;
+			epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &event);
+		}
+
+		// One pass of the loop thread: wait for the ready event, then run callbacks
+		size_t RunOnce(int timeoutMs) {
+			pollfd ready = { m_Ready, POLLIN, 0 };
+			if (poll(&ready, 1, timeoutMs) <= 0) {
+				return 0;
+			}
+			uint64_t count = 0;
+			(void)!read(m_Ready, &count, sizeof(count));
+			++m_Wakeups;
+			return m_Queue.Dispatch([](TestOperation* operation) {
+				operation->callback(*operation);
+			});
+		}
+
+		size_t GetPendingCount() const {
+			return m_Queue.GetPendingCount();
+		}
+
+		uint64_t GetWakeups() const {
+			return m_Wakeups;
+		}
+
+		uint64_t GetSignals() const {
+			return m_Signals.load();
+		}
+
+	private:
+		void PumpCompletions() {
+			for (;;) {
+				epoll_event events[8];
+				int count = epoll_wait(m_Epoll, events, 8, -1);
+				for (int i = 0; i < count; ++i) {
+					TestOperation* operation = static_cast<TestOperation*>(events[i].data.ptr);
+					if (!operation) {
+						return;
+					}
+					epoll_ctl(m_Epoll, EPOLL_CTL_DEL, operation->fd, nullptr);
+					operation->bytes = read(operation->fd, operation->buffer, sizeof(operation->buffer));
+					if (m_Queue.Complete(operation)) {
+						uint64_t one = 1;
+						(void)!write(m_Ready, &one, sizeof(one));
+						++m_Signals;
+					}
+				}
+			}
+		}
+
+		int m_Epoll = -1;
+		int m_Ready = -1;
+		int m_Stop = -1;
+		std::thread m_Pump;
+		CompletionQueue<TestOperation> m_Queue;
+		uint64_t m_Wakeups = 0;
+		std::atomic<uint64_t> m_Signals = 0;
+	};
+
+	struct Pipe {
+		Pipe() {
+			(void)!pipe(fds);
+		}
+
+		~Pipe() {
+			close(fds[0]);
+			close(fds[1]);
+		}
+
+		void Send(const char* text) {
+			(void)!write(fds[1], text, strlen(text));
+		}
+
+		int fds[2];
+	};
+}
+
+TEST(CompletionQueue, EpollCallbacksRunOnLoopThread) {
+	TestOperation::live = 0;
+	constexpr int kPipes = 16;
+	std::vector<Pipe> pipes(kPipes);
+	std::thread::id loopThread = std::this_thread::get_id();
+	std::vector<int> done(kPipes, 0);
+	{
+		EpollIo io;
+		for (int i = 0; i < kPipes; ++i) {
+			io.Read(pipes[i].fds[0], i, [&](TestOperation& operation) {
+				EXPECT_EQ(std::this_thread::get_id(), loopThread);
+				ASSERT_EQ(operation.bytes, 5);
+				EXPECT_EQ(std::string(operation.buffer, 5), "hello");
+				++done[operation.id];
+			});
+		}
+		EXPECT_EQ(io.GetPendingCount(), static_cast<size_t>(kPipes));
+		std::thread writer([&] {
+			for (Pipe& pipe : pipes) {
+				pipe.Send("hello");
+			}
+		});
+		size_t ran = 0;
+		while (ran < kPipes) {
+			ran += io.RunOnce(5000);
+		}
+		writer.join();
+		EXPECT_EQ(io.GetPendingCount(), 0u);
+		// Completions queued while the loop was busy share a wakeup
+		EXPECT_LE(io.GetWakeups(), io.GetSignals());
+		EXPECT_LE(io.GetSignals(), static_cast<uint64_t>(kPipes));
+	}
+	EXPECT_EQ(done, std::vector<int>(kPipes, 1));
+	EXPECT_EQ(TestOperation::live.load(), 0);
+}
+
+TEST(CompletionQueue, EpollShutdownReapsEverything) {
+	TestOperation::live = 0;
+	std::vector<Pipe> pipes(8);
+	int callbacks = 0;
+	{
+		EpollIo io;
+		for (int i = 0; i < 8; ++i) {
+			io.Read(pipes[i].fds[0], i, [&](TestOperation&) { ++callbacks; });
+		}
+		// Half complete but are never dispatched, the rest never complete
+		for (int i = 0; i < 4; ++i) {
+			pipes[i].Send("x");
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		EXPECT_EQ(io.GetPendingCount(), 8u);
+	}
+	EXPECT_EQ(callbacks, 0);
+	EXPECT_EQ(TestOperation::live.load(), 0);
+}
+#endif
@@ -0,0 +1,156 @@
+#include "pch.h"
+
+#include <vector>
+
+#include "../include/Ui/DialogTemplate.hpp"
+#include "../include/Diagnostics/MemoryLedger.hpp"
+
+namespace {
+	using Bytes = std::vector<uint8_t>;
+
+	constexpr uint32_t kVisible = 0x10000000;	// WS_VISIBLE
+	constexpr uint32_t kPopup = 0x80000000;		// WS_POPUP
+	constexpr uint32_t kCaption = 0x00C00000;	// WS_CAPTION
+
+	Bytes Slice(const Bytes& data, size_t offset, size_t size) {
+		return Bytes(data.begin() + offset, data.begin() + offset + size);
+	}
+}
+
+TEST(DialogTemplate, EncodesHeader) {
+	DialogTemplate dialog(L"A", 1, 2, 3, 4, kPopup | kCaption, 0x00000100);
+	const Bytes expected = {
+		0x01, 0x00, 0xFF, 0xFF,			// dlgVer, signature
+		0x00, 0x00, 0x00, 0x00,			// helpID
+		0x00, 0x01, 0x00, 0x00,			// exStyle
+		0x00, 0x00, 0xC0, 0x80,			// style
+		0x00, 0x00,						// cDlgItems
+		0x01, 0x00, 0x02, 0x00,			// x, y
+		0x03, 0x00, 0x04, 0x00,			// cx, cy
+		0x00, 0x00,						// no menu
+		0x00, 0x00,						// system dialog class
+		0x41, 0x00, 0x00, 0x00,			// title
+		0x00, 0x00,						// padding to a DWORD
+	};
+	EXPECT_EQ(dialog.GetData(), expected);
+}
+
+TEST(DialogTemplate, EncodesMenuClassAndNegativeCoordinates) {
+	DialogTemplate dialog(L"", -1, -2, 100, 50, kPopup);
+	dialog.SetMenu(0x0102).SetClass(L"Dlg");
+	const Bytes& data = dialog.GetData();
+	EXPECT_EQ(Slice(data, 18, 8), (Bytes{ 0xFF, 0xFF, 0xFE, 0xFF, 0x64, 0x00, 0x32, 0x00 }));
+	const Bytes tail = {
+		0xFF, 0xFF, 0x02, 0x01,			// menu ordinal
+		0x44, 0x00, 0x6C, 0x00, 0x67, 0x00, 0x00, 0x00,	// class "Dlg"
+		0x00, 0x00,						// empty title, ending on a DWORD
+	};
+	EXPECT_EQ(Slice(data, 26, data.size() - 26), tail);
+}
+
+TEST(DialogTemplate, EncodesFontBlock) {
+	DialogTemplate dialog(L"", 0, 0, 10, 10, kPopup);
+	dialog.SetFont(L"MS", 9, 700, true, 0);
+	const Bytes& data = dialog.GetData();
+	// DS_SETFONT is added to the style
+	EXPECT_EQ(Slice(data, 12, 4), (Bytes{ 0x40, 0x00, 0x00, 0x80 }));
+	const Bytes font = {
+		0x09, 0x00,						// pointsize
+		0xBC, 0x02,						// weight 700
+		0x01,							// italic
+		0x00,							// charset
+		0x4D, 0x00, 0x53, 0x00, 0x00, 0x00,	// typeface "MS"
+	};
+	// Header up to and including the empty title is 32 bytes
+	EXPECT_EQ(Slice(data, 32, font.size()), font);
+	EXPECT_EQ(data.size(), 44u);
+}
+
+TEST(DialogTemplate, EncodesItems) {
+	DialogTemplate dialog(L"", 0, 0, 100, 50, kPopup);
+	dialog.AddControl(DialogClass::Button, L"OK", 1, 10, 20, 30, 14, kVisible, 0x4);
+	dialog.AddControl(L"Ctl", L"", 0x12345678, 0, 0, 5, 5, 0);
+	const Bytes& data = dialog.GetData();
+	EXPECT_EQ(Slice(data, 16, 2), (Bytes{ 0x02, 0x00 }));
+	const Bytes button = {
+		0x00, 0x00, 0x00, 0x00,			// helpID
+		0x04, 0x00, 0x00, 0x00,			// exStyle
+		0x00, 0x00, 0x00, 0x50,			// WS_CHILD | WS_VISIBLE
+		0x0A, 0x00, 0x14, 0x00, 0x1E, 0x00, 0x0E, 0x00,
+		0x01, 0x00, 0x00, 0x00,			// id
+		0xFF, 0xFF, 0x80, 0x00,			// Button ordinal
+		0x4F, 0x00, 0x4B, 0x00, 0x00, 0x00,	// "OK"
+		0x00, 0x00,						// extraCount
+	};
+	EXPECT_EQ(Slice(data, 32, button.size()), button);
+	const Bytes custom = {
+		0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x40,			// WS_CHILD is always set
+		0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x05, 0x00,
+		0x78, 0x56, 0x34, 0x12,			// 32-bit id
+		0x43, 0x00, 0x74, 0x00, 0x6C, 0x00, 0x00, 0x00,	// class "Ctl"
+		0x00, 0x00,						// empty text
+		0x00, 0x00,						// extraCount
+	};
+	EXPECT_EQ(Slice(data, 68, custom.size()), custom);
+	EXPECT_EQ(data.size(), 68 + custom.size());
+}
+
+TEST(DialogTemplate, AlignsEveryItemToADword) {
+	DialogTemplate dialog(L"T", 0, 0, 100, 50, kPopup);
+	dialog.AddControl(DialogClass::Static, L"A", 1, 0, 0, 1, 1, 0);
+	dialog.AddControl(DialogClass::Edit, L"", 2, 0, 0, 1, 1, 0);
+	dialog.AddControl(DialogClass::Static, L"", 3, 0, 0, 1, 1, 0);
+	const Bytes& data = dialog.GetData();
+	// Header is 34 bytes with a one-character title, so the first item starts at 36
+	EXPECT_EQ(Slice(data, 34, 2), (Bytes{ 0x00, 0x00 }));
+	EXPECT_EQ(Slice(data, 36 + 20, 4), (Bytes{ 0x01, 0x00, 0x00, 0x00 }));
+	// The first item is 34 bytes long: two bytes of padding, then the second item
+	EXPECT_EQ(Slice(data, 36 + 34, 2), (Bytes{ 0x00, 0x00 }));
+	EXPECT_EQ(Slice(data, 72 + 20, 4), (Bytes{ 0x02, 0x00, 0x00, 0x00 }));
+	// An empty text makes a 32-byte item, which needs no padding
+	EXPECT_EQ(Slice(data, 104 + 20, 4), (Bytes{ 0x03, 0x00, 0x00, 0x00 }));
+	EXPECT_EQ(data.size(), 136u);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(data.data()) % 4, 0u);
+}
+
+TEST(DialogTemplate, EncodesTextAsUtf16) {
+	DialogTemplate dialog(std::wstring(1, static_cast<wchar_t>(0xE9)) + static_cast<wchar_t>(0x20AC), 0, 0, 1, 1, kPopup);
+	const Bytes& data = dialog.GetData();
+	EXPECT_EQ(Slice(data, 30, 6), (Bytes{ 0xE9, 0x00, 0xAC, 0x20, 0x00, 0x00 }));
+#ifndef _WIN32
+	// wchar_t is UTF-32 here, so characters outside the BMP become surrogate pairs
+	DialogTemplate wide(std::wstring(1, static_cast<wchar_t>(0x1F600)), 0, 0, 1, 1, kPopup);
+	EXPECT_EQ(Slice(wide.GetData(), 30, 6), (Bytes{ 0x3D, 0xD8, 0x00, 0xDE, 0x00, 0x00 }));
+#endif
+}
+
+TEST(DialogTemplate, ReencodesAfterChanges) {
+	DialogTemplate dialog(L"", 0, 0, 1, 1, kPopup);
+	size_t empty = dialog.GetData().size();
+	const uint8_t* cached = dialog.GetData().data();
+	EXPECT_EQ(dialog.GetData().data(), cached);
+	dialog.AddControl(DialogClass::Button, L"", 1, 0, 0, 1, 1, 0);
+	EXPECT_EQ(dialog.GetData().size(), empty + 32);
+	EXPECT_EQ(dialog.GetData()[16], 1);
+	EXPECT_EQ(dialog.GetControlCount(), 1u);
+}
+
+TEST(DialogTemplate, ChargesTheEncodedTemplateAsACache) {
+	auto cached = [] {
+		return GetMemoryLedger().GetOwnerReport(0).categories[static_cast<size_t>(MemoryCategory::Cache)].current;
+	};
+	const uint64_t before = cached();
+	{
+		DialogTemplate dialog(L"", 0, 0, 1, 1, kPopup);
+		EXPECT_EQ(cached(), before);
+		const size_t size = dialog.GetData().size();
+		EXPECT_GE(cached(), before + size);
+		// Copies encode on their own and release their own charge
+		DialogTemplate copy = dialog;
+		EXPECT_EQ(copy.GetData(), dialog.GetData());
+		EXPECT_GE(cached(), before + 2 * size);
+	}
+	EXPECT_EQ(cached(), before);
+}
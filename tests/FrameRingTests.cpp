@@ -0,0 +1,173 @@
+#include "pch.h"
+
+#include <string>
+
+#include "../include/Ipc/FrameRing.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	// The first shared word is the middle slot; a hostile process may write anything there
+	void CorruptMiddle(FrameRing& ring, uint32_t value) {
+		reinterpret_cast<std::atomic<uint32_t>*>(&ring)->store(value);
+	}
+}
+
+TEST(FrameRing, ConsumerStartsWithoutFrame) {
+	FrameRing ring;
+	ring.Initialize();
+	FrameConsumer consumer(ring);
+	EXPECT_EQ(consumer.ReadSlot(), FrameRing::kNoFrame);
+	EXPECT_FALSE(consumer.Acquire());
+	EXPECT_FALSE(ring.HasNewFrame());
+}
+
+TEST(FrameRing, SidesNeverShareASlot) {
+	FrameRing ring;
+	ring.Initialize();
+	FrameProducer producer(ring);
+	FrameConsumer consumer(ring);
+	for (int i = 0; i < 100; ++i) {
+		producer.Publish();
+		if (i % 3 == 0) {
+			ASSERT_TRUE(consumer.Acquire());
+			EXPECT_NE(consumer.ReadSlot(), producer.WriteSlot());
+		}
+	}
+	EXPECT_EQ(ring.PublishedSequence(), 100u);
+}
+
+TEST(FrameRing, CountsDroppedFrames) {
+	FrameRing ring;
+	ring.Initialize();
+	FrameProducer producer(ring);
+	FrameConsumer consumer(ring);
+	producer.Publish();
+	ASSERT_TRUE(consumer.Acquire());
+	producer.Publish();
+	producer.Publish();
+	producer.Publish();
+	ASSERT_TRUE(consumer.Acquire());
+	EXPECT_EQ(consumer.ReadSequence(), 4u);
+	EXPECT_EQ(consumer.DroppedFrames(), 2u);
+	EXPECT_FALSE(consumer.Acquire());
+}
+
+TEST(FrameRing, RejectsOutOfRangeSlot) {
+	FrameRing ring;
+	ring.Initialize();
+	FrameProducer producer(ring);
+	FrameConsumer consumer(ring);
+	producer.Publish();
+	ASSERT_TRUE(consumer.Acquire());
+	uint32_t held = consumer.ReadSlot();
+
+	CorruptMiddle(ring, 0x80000003);
+	EXPECT_FALSE(consumer.Acquire());
+	EXPECT_EQ(consumer.ReadSlot(), held);
+	EXPECT_EQ(consumer.RejectedSlots(), 1u);
+
+	CorruptMiddle(ring, 0x7FFFFFFF);
+	producer.Publish();
+	EXPECT_LT(producer.WriteSlot(), FrameRing::kSlotCount);
+	EXPECT_EQ(producer.RejectedSlots(), 1u);
+}
+
+TEST(FrameRing, IgnoresSequenceGoingBackwards) {
+	FrameRing ring;
+	ring.Initialize();
+	FrameProducer producer(ring);
+	FrameConsumer consumer(ring);
+	for (int i = 0; i < 5; ++i) {
+		producer.Publish();
+	}
+	ASSERT_TRUE(consumer.Acquire());
+	EXPECT_EQ(consumer.ReadSequence(), 5u);
+
+	// A second producer restarting at one must not wrap the drop counter
+	FrameProducer restarted(ring);
+	restarted.Publish();
+	ASSERT_TRUE(consumer.Acquire());
+	EXPECT_EQ(consumer.ReadSequence(), 5u);
+	EXPECT_EQ(consumer.DroppedFrames(), 0u);
+}
+
+#ifndef _WIN32
+// Producer and consumer in separate processes over a POSIX shared memory object, the
+// same arrangement `SharedFrameSurface` uses with a Win32 file mapping
+TEST(FrameRing, SharedMemoryAcrossProcesses) {
+	constexpr size_t kSlotWords = 4096;
+	constexpr uint64_t kFrames = 20000;
+	constexpr size_t kDataOffset = 4096;
+	const size_t size = kDataOffset + sizeof(uint64_t) * kSlotWords * FrameRing::kSlotCount;
+
+	std::string name = "/wincpp-frame-ring-" + std::to_string(getpid());
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	ASSERT_GE(fd, 0);
+	shm_unlink(name.c_str());
+	ASSERT_EQ(ftruncate(fd, static_cast<off_t>(size)), 0);
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	ASSERT_NE(memory, MAP_FAILED);
+
+	FrameRing& ring = *static_cast<FrameRing*>(memory);
+	uint64_t* slots = reinterpret_cast<uint64_t*>(static_cast<uint8_t*>(memory) + kDataOffset);
+	ring.Initialize();
+
+	pid_t child = fork();
+	ASSERT_GE(child, 0);
+	if (child == 0) {
+		FrameProducer producer(ring);
+		for (uint64_t i = 1; i <= kFrames; ++i) {
+			uint64_t* slot = slots + producer.WriteSlot() * kSlotWords;
+			for (size_t w = 0; w < kSlotWords; ++w) {
+				slot[w] = i;
+			}
+			producer.Publish();
+		}
+		_exit(producer.RejectedSlots() == 0 ? 0 : 1);
+	}
+
+	FrameConsumer consumer(ring);
+	uint64_t received = 0;
+	uint64_t first = 0;
+	uint64_t last = 0;
+	bool exited = false;
+	int status = 0;
+	while (last < kFrames) {
+		if (!consumer.Acquire()) {
+			if (exited && !ring.HasNewFrame()) {
+				break;
+			}
+			exited = exited || waitpid(child, &status, WNOHANG) == child;
+			continue;
+		}
+		ASSERT_LT(consumer.ReadSlot(), FrameRing::kSlotCount);
+		const uint64_t* slot = slots + consumer.ReadSlot() * kSlotWords;
+		uint64_t sequence = consumer.ReadSequence();
+		for (size_t w = 0; w < kSlotWords; ++w) {
+			ASSERT_EQ(slot[w], sequence);
+		}
+		ASSERT_GT(sequence, last);
+		if (first == 0) {
+			first = sequence;
+		}
+		last = sequence;
+		++received;
+	}
+	if (!exited) {
+		ASSERT_EQ(waitpid(child, &status, 0), child);
+	}
+	EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	EXPECT_EQ(last, kFrames);
+	EXPECT_EQ(ring.PublishedSequence(), kFrames);
+	EXPECT_EQ(first - 1 + received + consumer.DroppedFrames(), kFrames);
+	EXPECT_EQ(consumer.RejectedSlots(), 0u);
+	munmap(memory, size);
+}
+#endif
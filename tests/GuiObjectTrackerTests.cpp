@@ -0,0 +1,160 @@
+#include "pch.h"
+
+#include <string>
+#include <vector>
+
+#include "../include/Diagnostics/GuiObjectTracker.hpp"
+
+namespace {
+	// Creates an object on behalf of the caller, the way the library wrappers do
+	void CreateBrush(GuiObjectTracker& tracker, uintptr_t handle, const std::source_location& location = std::source_location::current()) {
+		tracker.OnCreated(handle, GuiObjectType::Brush, 0, location);
+	}
+}
+
+TEST(GuiObjectTracker, AttributesObjectsToTheWrappersCaller) {
+	FakeGuiResourceBackend backend;
+	GuiObjectTracker tracker(backend);
+	uint32_t line = std::source_location::current().line() + 1;
+	CreateBrush(tracker, 1);
+	std::vector<GuiObjectRecord> live = tracker.GetLiveObjects(0);
+	ASSERT_EQ(live.size(), 1u);
+	EXPECT_EQ(live[0].site.line, line);
+	EXPECT_NE(std::string(live[0].site.function).find("AttributesObjectsToTheWrappersCaller"), std::string::npos);
+}
+
+TEST(GuiObjectTracker, CountsPerCallSite) {
+	FakeGuiResourceBackend backend;
+	GuiObjectTracker tracker(backend);
+	for (uintptr_t handle = 1; handle <= 3; ++handle) {
+		CreateBrush(tracker, handle);
+	}
+	CreateBrush(tracker, 4);
+	tracker.OnDestroyed(1);
+	std::vector<GuiCallSiteStats> sites = tracker.GetCallSites();
+	ASSERT_EQ(sites.size(), 2u);
+	EXPECT_EQ(sites[0].created, 3u);
+	EXPECT_EQ(sites[0].live, 2u);
+	EXPECT_EQ(sites[1].created, 1u);
+	EXPECT_EQ(tracker.GetLiveCount(GuiObjectType::Brush), 3u);
+}
+
+TEST(GuiObjectTracker, TrackedBudgetAlertsOncePerUpwardCrossing) {
+	FakeGuiResourceBackend backend;
+	GuiObjectTracker tracker(backend);
+	std::vector<GuiBudgetAlert> alerts;
+	tracker.SetBudget(GuiResourceKind::Gdi, 3, [&alerts](const GuiBudgetAlert& alert) { alerts.push_back(alert); });
+	tracker.OnCreated(1, GuiObjectType::Brush);
+	tracker.OnCreated(2, GuiObjectType::Pen);
+	// USER objects count against the other budget
+	tracker.OnCreated(100, GuiObjectType::Window);
+	EXPECT_TRUE(alerts.empty());
+	tracker.OnCreated(3, GuiObjectType::Font);
+	tracker.OnCreated(4, GuiObjectType::Bitmap);
+	ASSERT_EQ(alerts.size(), 1u);
+	EXPECT_EQ(alerts[0].kind, GuiResourceKind::Gdi);
+	EXPECT_EQ(alerts[0].count, 3u);
+	EXPECT_EQ(alerts[0].budget, 3u);
+	EXPECT_FALSE(alerts[0].processWide);
+
+	// Still at the budget: not re-armed
+	tracker.OnDestroyed(4);
+	tracker.OnCreated(5, GuiObjectType::Region);
+	EXPECT_EQ(alerts.size(), 1u);
+	// Back under it, then over again
+	tracker.OnDestroyed(5);
+	tracker.OnDestroyed(3);
+	tracker.OnCreated(6, GuiObjectType::Brush);
+	ASSERT_EQ(alerts.size(), 2u);
+	EXPECT_EQ(alerts[1].count, 3u);
+
+	tracker.SetBudget(GuiResourceKind::Gdi, 0, nullptr);
+	tracker.OnCreated(7, GuiObjectType::Brush);
+	EXPECT_EQ(alerts.size(), 2u);
+}
+
+TEST(GuiObjectTracker, SampleChecksTheProcessWideCounts) {
+	FakeGuiResourceBackend backend;
+	GuiObjectTracker tracker(backend);
+	std::vector<GuiBudgetAlert> alerts;
+	tracker.SetBudget(GuiResourceKind::User, 100, [&alerts](const GuiBudgetAlert& alert) { alerts.push_back(alert); });
+	tracker.OnCreated(1, GuiObjectType::Window);
+	tracker.OnCreated(2, GuiObjectType::Menu);
+	tracker.OnCreated(3, GuiObjectType::DeviceContext);
+	backend.gdiObjects = 40;
+	backend.userObjects = 60;
+	GuiResourceSample sample = tracker.Sample();
+	EXPECT_EQ(sample.processGdi, 40u);
+	EXPECT_EQ(sample.processUser, 60u);
+	EXPECT_EQ(sample.trackedGdi, 1u);
+	EXPECT_EQ(sample.trackedUser, 2u);
+	EXPECT_TRUE(alerts.empty());
+
+	backend.userObjects = 120;
+	tracker.Sample();
+	tracker.Sample();
+	ASSERT_EQ(alerts.size(), 1u);
+	EXPECT_EQ(alerts[0].kind, GuiResourceKind::User);
+	EXPECT_EQ(alerts[0].count, 120u);
+	EXPECT_TRUE(alerts[0].processWide);
+
+	backend.userObjects = 90;
+	tracker.Sample();
+	backend.userObjects = 100;
+	tracker.Sample();
+	ASSERT_EQ(alerts.size(), 2u);
+	EXPECT_EQ(alerts[1].count, 100u);
+}
+
+TEST(GuiObjectTracker, ReportsObjectsLeftBehindByADestroyedOwner) {
+	FakeGuiResourceBackend backend;
+	GuiObjectTracker tracker(backend);
+	std::vector<std::pair<uintptr_t, std::vector<GuiObjectRecord>>> reports;
+	tracker.SetLeakHandler([&reports](uintptr_t owner, const std::vector<GuiObjectRecord>& leaked) { reports.push_back({ owner, leaked }); });
+	tracker.OnCreated(1, GuiObjectType::Brush, 0x10);
+	tracker.OnCreated(2, GuiObjectType::Font, 0x10);
+	tracker.OnCreated(3, GuiObjectType::Pen, 0x20);
+	tracker.OnCreated(4, GuiObjectType::Bitmap, 0x10);
+	tracker.OnDestroyed(1);
+	// Handed over to another owner before the window goes
+	tracker.SetOwner(4, 0x20);
+
+	EXPECT_EQ(tracker.OnOwnerDestroyed(0x10), 1u);
+	ASSERT_EQ(reports.size(), 1u);
+	EXPECT_EQ(reports[0].first, 0x10u);
+	ASSERT_EQ(reports[0].second.size(), 1u);
+	EXPECT_EQ(reports[0].second[0].handle, 2u);
+	EXPECT_EQ(reports[0].second[0].type, GuiObjectType::Font);
+	// Reported objects are still alive, so they stay tracked
+	EXPECT_EQ(tracker.GetLiveCount(GuiObjectType::Font), 1u);
+
+	tracker.OnDestroyed(3);
+	tracker.OnDestroyed(4);
+	EXPECT_EQ(tracker.OnOwnerDestroyed(0x20), 0u);
+	EXPECT_EQ(reports.size(), 1u);
+}
+
+// A handle value reused by the system before its deletion was reported replaces the
+// stale record instead of counting twice
+TEST(GuiObjectTracker, RecycledHandleReplacesTheStaleRecord) {
+	FakeGuiResourceBackend backend;
+	GuiObjectTracker tracker(backend);
+	tracker.OnCreated(0, GuiObjectType::Brush);
+	EXPECT_EQ(tracker.GetLiveCount(GuiObjectType::Brush), 0u);
+	tracker.OnCreated(5, GuiObjectType::Brush, 0x10);
+	tracker.OnCreated(5, GuiObjectType::Icon, 0x20);
+	EXPECT_EQ(tracker.GetLiveCount(GuiObjectType::Brush), 0u);
+	EXPECT_EQ(tracker.GetLiveCount(GuiObjectType::Icon), 1u);
+	EXPECT_EQ(tracker.GetLiveCount(GuiResourceKind::Gdi), 0u);
+	EXPECT_TRUE(tracker.GetLiveObjects(0x10).empty());
+	EXPECT_EQ(tracker.GetLiveObjects(0x20).size(), 1u);
+	uint64_t live = 0;
+	for (const GuiCallSiteStats& site : tracker.GetCallSites()) {
+		live += site.live;
+	}
+	EXPECT_EQ(live, 1u);
+	tracker.OnDestroyed(5);
+	EXPECT_EQ(tracker.GetLiveCount(GuiObjectType::Icon), 0u);
+	tracker.OnDestroyed(5);
+	EXPECT_EQ(tracker.GetLiveCount(GuiResourceKind::User), 0u);
+}
@@ -0,0 +1,149 @@
+#include "pch.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../include/Diagnostics/HangDetector.hpp"
+
+namespace {
+	using namespace std::chrono_literals;
+
+	constexpr uint32_t kPaint = 0x000F;
+	constexpr uint32_t kTimer = 0x0113;
+	constexpr uint32_t kCommand = 0x0111;
+
+	const HangDetector::Clock::time_point kStart = HangDetector::Clock::time_point(1h);
+}
+
+TEST(HangDetector, IdleLoopIsNotAHang) {
+	HangDetector detector(100ms);
+	HangReport report;
+	detector.BeginDispatch(kPaint, 1, kStart);
+	detector.EndDispatch(kStart + 1ms);
+	// The loop waits for messages for a long time; nothing runs, so nothing is reported
+	EXPECT_FALSE(detector.Check(kStart + 10s, report));
+	EXPECT_EQ(detector.GetHangCount(), 0u);
+	EXPECT_EQ(detector.GetDispatchCount(), 1u);
+}
+
+TEST(HangDetector, ReportsStallOnceThenWhenItEnds) {
+	HangDetector detector(100ms);
+	HangReport report;
+	detector.BeginDispatch(kTimer, 7, kStart);
+	EXPECT_FALSE(detector.Check(kStart + 99ms, report));
+
+	ASSERT_TRUE(detector.Check(kStart + 150ms, report));
+	EXPECT_TRUE(report.ongoing);
+	EXPECT_EQ(report.message, kTimer);
+	EXPECT_EQ(report.window, 7u);
+	EXPECT_EQ(report.duration, 150ms);
+	// Still stuck, but already reported
+	EXPECT_FALSE(detector.Check(kStart + 300ms, report));
+
+	detector.EndDispatch(kStart + 400ms);
+	ASSERT_TRUE(detector.Check(kStart + 500ms, report));
+	EXPECT_FALSE(report.ongoing);
+	EXPECT_EQ(report.message, kTimer);
+	EXPECT_EQ(report.duration, 400ms);
+	EXPECT_FALSE(detector.Check(kStart + 600ms, report));
+	EXPECT_EQ(detector.GetHangCount(), 1u);
+}
+
+TEST(HangDetector, TraceHoldsMessagesBeforeTheStall) {
+	HangDetector detector(100ms);
+	HangReport report;
+	HangDetector::Clock::time_point now = kStart;
+	for (uint32_t i = 0; i < HangDetector::kTraceSize + 5; ++i) {
+		detector.BeginDispatch(i, 0, now);
+		detector.EndDispatch(now + 1ms);
+		now += 2ms;
+	}
+	detector.BeginDispatch(kCommand, 3, now);
+	ASSERT_TRUE(detector.Check(now + 200ms, report));
+	ASSERT_EQ(report.trace.size(), HangDetector::kTraceSize);
+	// Oldest first; the first five fell out of the trace
+	EXPECT_EQ(report.trace.front().message, 5u);
+	EXPECT_EQ(report.trace.back().message, HangDetector::kTraceSize + 4);
+	EXPECT_EQ(report.trace.back().duration, 1ms);
+	EXPECT_EQ(report.trace.back().age, 2ms);
+	detector.EndDispatch(now + 250ms);
+}
+
+TEST(HangDetector, NestedDispatchIsPartOfTheOuterOne) {
+	HangDetector detector(100ms);
+	HangReport report;
+	detector.BeginDispatch(kCommand, 1, kStart);
+	// A modal loop inside the handler dispatches more messages
+	detector.BeginDispatch(kPaint, 2, kStart + 10ms);
+	detector.EndDispatch(kStart + 20ms);
+	ASSERT_TRUE(detector.Check(kStart + 150ms, report));
+	EXPECT_EQ(report.message, kCommand);
+	EXPECT_EQ(report.duration, 150ms);
+	detector.EndDispatch(kStart + 200ms);
+	EXPECT_EQ(detector.GetDispatchCount(), 1u);
+}
+
+TEST(HangDetector, LongHandlerBetweenPollsIsReportedWhenItEnds) {
+	HangDetector detector(100ms);
+	HangReport report;
+	EXPECT_FALSE(detector.Check(kStart, report));
+	detector.BeginDispatch(kPaint, 1, kStart + 1ms);
+	ASSERT_TRUE(detector.Check(kStart + 120ms, report));
+	detector.EndDispatch(kStart + 130ms);
+	// A short message ran after it before the watchdog looked again
+	detector.BeginDispatch(kTimer, 1, kStart + 131ms);
+	detector.EndDispatch(kStart + 132ms);
+	ASSERT_TRUE(detector.Check(kStart + 200ms, report));
+	EXPECT_FALSE(report.ongoing);
+	EXPECT_EQ(report.duration, 129ms);
+}
+
+// A real loop thread and a polling watchdog thread, with one handler made to stall
+TEST(HangDetector, DetectsArtificialStall) {
+	HangDetector detector(50ms);
+	std::atomic<bool> loopDone = false;
+	std::vector<HangReport> reports;
+
+	std::thread watchdog([&] {
+		HangReport report;
+		for (;;) {
+			bool done = loopDone.load();
+			if (detector.Check(HangDetector::Clock::now(), report)) {
+				reports.push_back(report);
+			}
+			if (done) {
+				return;
+			}
+			std::this_thread::sleep_for(5ms);
+		}
+	});
+
+	auto dispatch = [&](uint32_t message, HangDetector::Clock::duration work) {
+		detector.BeginDispatch(message, 42, HangDetector::Clock::now());
+		std::this_thread::sleep_for(work);
+		detector.EndDispatch(HangDetector::Clock::now());
+	};
+	for (int i = 0; i < 20; ++i) {
+		dispatch(kPaint, 1ms);
+	}
+	dispatch(kCommand, 200ms);
+	for (int i = 0; i < 20; ++i) {
+		dispatch(kTimer, 1ms);
+	}
+	loopDone = true;
+	watchdog.join();
+
+	ASSERT_EQ(reports.size(), 2u);
+	EXPECT_TRUE(reports[0].ongoing);
+	EXPECT_EQ(reports[0].message, kCommand);
+	EXPECT_EQ(reports[0].window, 42u);
+	EXPECT_GE(reports[0].duration, 50ms);
+	EXPECT_EQ(reports[0].trace.size(), 20u);
+	EXPECT_EQ(reports[0].trace.back().message, kPaint);
+	EXPECT_FALSE(reports[1].ongoing);
+	EXPECT_EQ(reports[1].dispatch, reports[0].dispatch);
+	EXPECT_GE(reports[1].duration, 200ms);
+	EXPECT_EQ(detector.GetHangCount(), 1u);
+	EXPECT_EQ(detector.GetDispatchCount(), 41u);
+}
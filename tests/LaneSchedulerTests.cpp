@@ -0,0 +1,184 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../include/Loop/LaneScheduler.hpp"
+
+namespace {
+	using namespace std::chrono_literals;
+
+	// Simulated time: nothing moves unless a task or the test advances it
+	struct SimulatedClock {
+		LaneScheduler::Clock::time_point now = LaneScheduler::Clock::time_point(1h);
+
+		LaneScheduler::NowFunction Function() {
+			return [this] { return now; };
+		}
+	};
+
+	struct Simulation {
+		SimulatedClock clock;
+		LaneScheduler scheduler{ clock.Function() };
+		std::string trace;
+
+		// Posts a task that takes `cost` of simulated time and leaves `mark` in the trace
+		void Post(TaskLane lane, char mark, LaneScheduler::Clock::duration cost = 1ms) {
+			scheduler.Post(lane, [this, mark, cost] {
+				trace += mark;
+				clock.now += cost;
+			});
+		}
+
+		bool Run() {
+			return scheduler.Run([] { return false; });
+		}
+	};
+}
+
+TEST(LaneScheduler, DrainsLanesByPriority) {
+	Simulation sim;
+	sim.Post(TaskLane::Idle, 'd');
+	sim.Post(TaskLane::Normal, 'n');
+	sim.Post(TaskLane::Animation, 'a');
+	sim.Post(TaskLane::Input, 'i');
+	EXPECT_FALSE(sim.Run());
+	EXPECT_EQ(sim.trace, "iand");
+}
+
+TEST(LaneScheduler, BudgetsLastForTheWholeFrame) {
+	Simulation sim;
+	for (int i = 0; i < 20; ++i) {
+		sim.Post(TaskLane::Normal, 'n');
+	}
+	LaneScheduler::Clock::time_point frameStart = sim.clock.now;
+	EXPECT_TRUE(sim.Run());
+	EXPECT_EQ(sim.trace.size(), 4u);
+
+	// More loop passes in the same frame find the budget spent
+	for (int pass = 0; pass < 10; ++pass) {
+		EXPECT_TRUE(sim.Run());
+	}
+	EXPECT_EQ(sim.trace.size(), 4u);
+	EXPECT_EQ(sim.scheduler.GetSpent(TaskLane::Normal), 4ms);
+	EXPECT_EQ(sim.scheduler.GetNextRunTime(), frameStart + sim.scheduler.GetConfig().frameInterval);
+
+	// The next frame refills it
+	sim.clock.now = sim.scheduler.GetNextRunTime();
+	EXPECT_TRUE(sim.Run());
+	EXPECT_EQ(sim.trace.size(), 8u);
+	EXPECT_EQ(sim.scheduler.GetFrameCount(), 2u);
+}
+
+TEST(LaneScheduler, BeginFrameRefillsBudgets) {
+	Simulation sim;
+	for (int i = 0; i < 10; ++i) {
+		sim.Post(TaskLane::Animation, 'a');
+	}
+	sim.Run();
+	EXPECT_EQ(sim.trace.size(), 4u);
+	sim.scheduler.BeginFrame();
+	EXPECT_EQ(sim.scheduler.GetNextRunTime(), sim.clock.now);
+	sim.Run();
+	EXPECT_EQ(sim.trace.size(), 8u);
+}
+
+TEST(LaneScheduler, NothingQueuedMeansNoWakeup) {
+	Simulation sim;
+	EXPECT_EQ(sim.scheduler.GetNextRunTime(), LaneScheduler::Clock::time_point::max());
+	sim.Post(TaskLane::Normal, 'n');
+	EXPECT_EQ(sim.scheduler.GetNextRunTime(), sim.clock.now);
+	sim.Run();
+	EXPECT_EQ(sim.scheduler.GetNextRunTime(), LaneScheduler::Clock::time_point::max());
+}
+
+TEST(LaneScheduler, IdleWaitsForOtherLanes) {
+	Simulation sim;
+	for (int i = 0; i < 6; ++i) {
+		sim.Post(TaskLane::Normal, 'n');
+	}
+	sim.Post(TaskLane::Idle, 'd');
+	sim.Run();
+	EXPECT_EQ(sim.trace, "nnnn");
+	// Normal is out of budget but not empty, so idle may not run either
+	EXPECT_GT(sim.scheduler.GetNextRunTime(), sim.clock.now);
+	sim.clock.now = sim.scheduler.GetNextRunTime();
+	sim.Run();
+	EXPECT_EQ(sim.trace, "nnnnnnd");
+}
+
+TEST(LaneScheduler, YieldStopsTheRun) {
+	Simulation sim;
+	for (int i = 0; i < 3; ++i) {
+		sim.Post(TaskLane::Input, 'i');
+	}
+	int checks = 0;
+	EXPECT_TRUE(sim.scheduler.Run([&] { return ++checks > 2; }));
+	EXPECT_EQ(sim.trace, "ii");
+	// Input is waiting, so the scheduler wants to run again as soon as it is handled
+	EXPECT_EQ(sim.scheduler.GetNextRunTime(), sim.clock.now);
+}
+
+TEST(LaneScheduler, StarvedTasksArePromoted) {
+	Simulation sim;
+	sim.Post(TaskLane::Idle, 'd');
+	// Normal work never runs out, so the idle lane never gets a regular turn
+	for (int frame = 0; frame < 80 && sim.trace.find('d') == std::string::npos; ++frame) {
+		for (int i = 0; i < 5; ++i) {
+			sim.Post(TaskLane::Normal, 'n');
+		}
+		sim.Run();
+		sim.clock.now = sim.scheduler.GetNextRunTime();
+	}
+	EXPECT_NE(sim.trace.find('d'), std::string::npos);
+	EXPECT_EQ(sim.scheduler.GetPromotionCount(), 1u);
+	EXPECT_GE(sim.scheduler.GetLatency(TaskLane::Idle).max, sim.scheduler.GetConfig().starvation[static_cast<size_t>(TaskLane::Idle)]);
+	EXPECT_LT(sim.scheduler.GetLatency(TaskLane::Idle).max, sim.scheduler.GetConfig().starvation[static_cast<size_t>(TaskLane::Idle)] + 2 * sim.scheduler.GetConfig().frameInterval);
+}
+
+TEST(LaneScheduler, RecordsQueueingDelayPerLane) {
+	Simulation sim;
+	sim.Post(TaskLane::Normal, 'n');
+	sim.Post(TaskLane::Normal, 'n');
+	sim.clock.now += 5ms;
+	sim.Run();
+	const LaneLatency& latency = sim.scheduler.GetLatency(TaskLane::Normal);
+	EXPECT_EQ(latency.count, 2u);
+	EXPECT_EQ(latency.max, 6ms);
+	EXPECT_EQ(latency.Average(), 5500us);
+	EXPECT_EQ(sim.scheduler.GetLatency(TaskLane::Input).count, 0u);
+}
+
+// A steady mix of work over a simulated second: input never waits behind posted work for
+// more than one task, and every lane makes progress
+TEST(LaneScheduler, SimulatedSecondOfMixedLoad) {
+	Simulation sim;
+	uint64_t posted[LaneScheduler::kLaneCount] = {};
+	LaneScheduler::Clock::time_point end = sim.clock.now + 1s;
+	int step = 0;
+	while (sim.clock.now < end) {
+		if (step % 3 == 0) {
+			sim.Post(TaskLane::Input, 'i', 200us);
+			++posted[0];
+		}
+		sim.Post(TaskLane::Animation, 'a', 500us);
+		sim.Post(TaskLane::Normal, 'n', 2ms);
+		posted[1] += 1;
+		posted[2] += 1;
+		if (step % 10 == 0) {
+			sim.Post(TaskLane::Idle, 'd', 1ms);
+			++posted[3];
+		}
+		sim.Run();
+		LaneScheduler::Clock::time_point next = sim.scheduler.GetNextRunTime();
+		sim.clock.now = next == LaneScheduler::Clock::time_point::max() ? sim.clock.now + 1ms : std::max(next, sim.clock.now + 1ms);
+		++step;
+	}
+	EXPECT_EQ(sim.scheduler.GetLatency(TaskLane::Input).count, posted[0]);
+	EXPECT_LE(sim.scheduler.GetLatency(TaskLane::Input).max, 4ms);
+	EXPECT_GT(sim.scheduler.GetLatency(TaskLane::Animation).count, 0u);
+	EXPECT_GT(sim.scheduler.GetLatency(TaskLane::Normal).count, 0u);
+	// Posted faster than budgets allow, so the backlog grows instead of eating the frame
+	EXPECT_GT(sim.scheduler.GetPendingCount(TaskLane::Normal), 0u);
+}
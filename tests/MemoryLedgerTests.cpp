@@ -0,0 +1,131 @@
+#include "pch.h"
+
+#include <string>
+#include <utility>
+
+#include "../include/Diagnostics/MemoryLedger.hpp"
+
+namespace {
+	uint64_t Current(const MemoryOwnerReport& report, MemoryCategory category) {
+		return report.categories[static_cast<size_t>(category)].current;
+	}
+
+	uint64_t Peak(const MemoryOwnerReport& report, MemoryCategory category) {
+		return report.categories[static_cast<size_t>(category)].peak;
+	}
+}
+
+TEST(MemoryLedger, NestsCategoriesUnderOwnersUnderTheProcess) {
+	MemoryLedger ledger;
+	ledger.Charge(1, MemoryCategory::BackBuffer, 100);
+	ledger.Charge(1, MemoryCategory::Cache, 50);
+	ledger.Charge(2, MemoryCategory::Surface, 300);
+	ledger.Charge(2, MemoryCategory::Cache, 10);
+	ledger.Release(1, MemoryCategory::Cache, 20);
+
+	MemoryReport report = ledger.GetReport();
+	EXPECT_EQ(report.total.current, 440u);
+	EXPECT_EQ(report.categories[static_cast<size_t>(MemoryCategory::Cache)].current, 40u);
+	EXPECT_EQ(report.categories[static_cast<size_t>(MemoryCategory::Surface)].current, 300u);
+	ASSERT_EQ(report.owners.size(), 2u);
+	// Largest owner first
+	EXPECT_EQ(report.owners[0].owner, 2u);
+	EXPECT_EQ(report.owners[0].total.current, 310u);
+	EXPECT_EQ(report.owners[1].owner, 1u);
+	EXPECT_EQ(report.owners[1].total.current, 130u);
+	EXPECT_EQ(Current(report.owners[1], MemoryCategory::BackBuffer), 100u);
+	EXPECT_EQ(Current(report.owners[1], MemoryCategory::Cache), 30u);
+	EXPECT_EQ(Current(report.owners[1], MemoryCategory::Surface), 0u);
+
+	MemoryOwnerReport owner = ledger.GetOwnerReport(2);
+	EXPECT_EQ(owner.total.current, 310u);
+	EXPECT_EQ(Current(owner, MemoryCategory::Cache), 10u);
+	EXPECT_EQ(ledger.GetOwnerReport(3).total.current, 0u);
+}
+
+TEST(MemoryLedger, TracksPeaksAtEveryLevel) {
+	MemoryLedger ledger;
+	ledger.Charge(1, MemoryCategory::Strings, 100);
+	ledger.Release(1, MemoryCategory::Strings, 60);
+	ledger.Charge(1, MemoryCategory::Strings, 30);
+	ledger.Charge(2, MemoryCategory::Strings, 5);
+
+	MemoryReport report = ledger.GetReport();
+	EXPECT_EQ(report.total.current, 75u);
+	EXPECT_EQ(report.total.peak, 100u);
+	EXPECT_EQ(report.categories[static_cast<size_t>(MemoryCategory::Strings)].peak, 100u);
+	MemoryOwnerReport owner = ledger.GetOwnerReport(1);
+	EXPECT_EQ(owner.total.current, 70u);
+	EXPECT_EQ(owner.total.peak, 100u);
+	EXPECT_EQ(Peak(owner, MemoryCategory::Strings), 100u);
+
+	ledger.ResetPeaks();
+	owner = ledger.GetOwnerReport(1);
+	EXPECT_EQ(owner.total.peak, 70u);
+	EXPECT_EQ(ledger.GetReport().total.peak, 75u);
+
+	// Releasing more than was charged stops at zero
+	ledger.Release(1, MemoryCategory::Strings, 1000);
+	owner = ledger.GetOwnerReport(1);
+	EXPECT_EQ(owner.total.current, 0u);
+	EXPECT_EQ(owner.total.peak, 70u);
+}
+
+TEST(MemoryLedger, RemoveOwnerKeepsOwnersThatStillHoldMemory) {
+	MemoryLedger ledger;
+	ledger.Charge(1, MemoryCategory::HandlerState, 64);
+	ledger.Charge(2, MemoryCategory::HandlerState, 64);
+	ledger.Release(1, MemoryCategory::HandlerState, 64);
+	EXPECT_EQ(ledger.RemoveOwner(1), 0u);
+	EXPECT_EQ(ledger.RemoveOwner(2), 64u);
+	EXPECT_EQ(ledger.RemoveOwner(3), 0u);
+	MemoryReport report = ledger.GetReport();
+	ASSERT_EQ(report.owners.size(), 1u);
+	EXPECT_EQ(report.owners[0].owner, 2u);
+}
+
+TEST(MemoryLedger, FormatsOneLinePerOwnerAndCategory) {
+	MemoryLedger ledger;
+	ledger.Charge(0x10, MemoryCategory::BackBuffer, 2048);
+	ledger.Charge(0x10, MemoryCategory::Cache, 512);
+	ledger.Release(0x10, MemoryCategory::Cache, 512);
+	ledger.Charge(0, MemoryCategory::Arena, 100);
+	ledger.SetOwnerName(0x10, "Main window");
+	EXPECT_EQ(ledger.GetReport().Format(),
+		"memory 2.1 KB (peak 2.5 KB)\n"
+		"  Main window 2.0 KB (peak 2.5 KB)\n"
+		"    back buffers 2.0 KB (peak 2.0 KB)\n"
+		// Released categories stay listed with their peak
+		"    caches 0 B (peak 512 B)\n"
+		"  unattributed 100 B (peak 100 B)\n"
+		"    arenas 100 B (peak 100 B)\n");
+	EXPECT_EQ(MemoryReport::FormatBytes(3u * 1024 * 1024 * 1024), "3.0 GB");
+}
+
+// `MemoryCharge` works on the process-wide ledger; the owner below is not used elsewhere
+TEST(MemoryLedger, ChargeFollowsItsAllocation) {
+	constexpr uintptr_t kOwner = 0x7E57;
+	constexpr uintptr_t kOtherOwner = 0x7E58;
+	MemoryLedger& ledger = GetMemoryLedger();
+	{
+		MemoryCharge charge(kOwner, MemoryCategory::Surface, 100);
+		EXPECT_EQ(Current(ledger.GetOwnerReport(kOwner), MemoryCategory::Surface), 100u);
+		charge.Resize(250);
+		charge.Resize(200);
+		MemoryOwnerReport report = ledger.GetOwnerReport(kOwner);
+		EXPECT_EQ(report.total.current, 200u);
+		EXPECT_EQ(report.total.peak, 250u);
+
+		MemoryCharge moved = std::move(charge);
+		EXPECT_EQ(charge.GetBytes(), 0u);
+		EXPECT_EQ(ledger.GetOwnerReport(kOwner).total.current, 200u);
+
+		moved.SetOwner(kOtherOwner);
+		EXPECT_EQ(moved.GetOwner(), kOtherOwner);
+		EXPECT_EQ(ledger.GetOwnerReport(kOwner).total.current, 0u);
+		EXPECT_EQ(Current(ledger.GetOwnerReport(kOtherOwner), MemoryCategory::Surface), 200u);
+	}
+	EXPECT_EQ(ledger.GetOwnerReport(kOtherOwner).total.current, 0u);
+	EXPECT_EQ(ledger.RemoveOwner(kOwner), 0u);
+	EXPECT_EQ(ledger.RemoveOwner(kOtherOwner), 0u);
+}
@@ -0,0 +1,229 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../include/Ipc/MessageRing.hpp"
+
+namespace {
+	// A ring with its storage right behind the header, as in a file mapping
+	template <uint64_t Capacity>
+	struct RingMemory {
+		MessageRing ring;
+		uint8_t storage[Capacity];
+
+		RingMemory() {
+			ring.Initialize(Capacity);
+		}
+	};
+
+	// Raw header and storage words, as a hostile producer in another process sees them
+	struct RingWords {
+		uint64_t capacity;
+		alignas(64) uint64_t head;
+		alignas(64) uint64_t tail;
+	};
+
+	template <uint64_t Capacity>
+	void SetWords(RingMemory<Capacity>& memory, uint64_t RingWords::* field, uint64_t value) {
+		RingWords words;
+		memcpy(&words, &memory.ring, sizeof(words));
+		words.*field = value;
+		memcpy(static_cast<void*>(&memory.ring), &words, sizeof(words));
+	}
+
+	template <uint64_t Capacity>
+	void WriteRecordHeader(RingMemory<Capacity>& memory, uint64_t offset, uint32_t size, uint32_t type) {
+		uint32_t header[2] = { size, type };
+		memcpy(memory.storage + offset, header, sizeof(header));
+	}
+}
+
+TEST(MessageRing, DeliversRecordsInOrder) {
+	RingMemory<256> memory;
+	for (uint32_t i = 0; i < 5; ++i) {
+		ASSERT_TRUE(memory.ring.TryWrite(i, &i, sizeof(i)));
+	}
+	std::vector<uint32_t> seen;
+	uint64_t delivered = memory.ring.Drain([&](uint32_t type, const void* data, uint64_t size) {
+		ASSERT_EQ(size, sizeof(uint32_t));
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		EXPECT_EQ(value, type);
+		seen.push_back(type);
+	});
+	EXPECT_EQ(delivered, 5u);
+	EXPECT_EQ(seen, (std::vector<uint32_t>{ 0, 1, 2, 3, 4 }));
+	EXPECT_TRUE(memory.ring.IsEmpty());
+}
+
+TEST(MessageRing, WrapsWithPaddingRecord) {
+	RingMemory<64> memory;
+	uint8_t payload[20] = {};
+	uint64_t total = 0;
+	for (int round = 0; round < 50; ++round) {
+		ASSERT_TRUE(memory.ring.TryWrite(7, payload, sizeof(payload)));
+		total += memory.ring.Drain([](uint32_t type, const void*, uint64_t size) {
+			EXPECT_EQ(type, 7u);
+			EXPECT_EQ(size, 20u);
+		});
+	}
+	EXPECT_EQ(total, 50u);
+}
+
+TEST(MessageRing, RefusesWhenFull) {
+	RingMemory<64> memory;
+	uint8_t payload[64] = {};
+	EXPECT_TRUE(memory.ring.TryWrite(1, payload, 24));
+	EXPECT_TRUE(memory.ring.TryWrite(1, payload, 24));
+	EXPECT_FALSE(memory.ring.TryWrite(1, payload, 24));
+	EXPECT_FALSE(memory.ring.TryWrite(1, payload, MessageRing::MaxPayload(64) + 1));
+}
+
+TEST(MessageRing, RejectsRecordLargerThanStorage) {
+	RingMemory<64> memory;
+	WriteRecordHeader(memory, 0, 0x7FFFFFFF, 1);
+	SetWords(memory, &RingWords::head, 16);
+	int calls = 0;
+	EXPECT_EQ(memory.ring.Drain([&](uint32_t, const void*, uint64_t) { ++calls; }), 0u);
+	EXPECT_EQ(calls, 0);
+	// The bad record is discarded and the ring keeps working
+	EXPECT_TRUE(memory.ring.IsEmpty());
+	uint32_t value = 5;
+	ASSERT_TRUE(memory.ring.TryWrite(2, &value, sizeof(value)));
+	EXPECT_EQ(memory.ring.Drain([&](uint32_t type, const void*, uint64_t) { EXPECT_EQ(type, 2u); }), 1u);
+}
+
+TEST(MessageRing, RejectsRecordCrossingTheEnd) {
+	RingMemory<64> memory;
+	SetWords(memory, &RingWords::head, 48);
+	SetWords(memory, &RingWords::tail, 48);
+	// 16 bytes left before the end, but the record claims 16 bytes of payload
+	WriteRecordHeader(memory, 48, 16, 1);
+	SetWords(memory, &RingWords::head, 72);
+	int calls = 0;
+	memory.ring.Drain([&](uint32_t, const void*, uint64_t) { ++calls; });
+	EXPECT_EQ(calls, 0);
+	EXPECT_TRUE(memory.ring.IsEmpty());
+}
+
+TEST(MessageRing, RejectsHeadBeyondCapacity) {
+	RingMemory<64> memory;
+	SetWords(memory, &RingWords::head, 1 << 20);
+	int calls = 0;
+	EXPECT_EQ(memory.ring.Drain([&](uint32_t, const void*, uint64_t) { ++calls; }), 0u);
+	EXPECT_EQ(calls, 0);
+}
+
+TEST(MessageRing, UsesCallerCapacity) {
+	RingMemory<64> memory;
+	uint32_t value = 1;
+	ASSERT_TRUE(memory.ring.TryWrite(3, &value, sizeof(value)));
+	// The producer claims a larger ring than the consumer created
+	SetWords(memory, &RingWords::capacity, 1 << 20);
+	EXPECT_EQ(memory.ring.Drain(64, [](uint32_t type, const void*, uint64_t) { EXPECT_EQ(type, 3u); }), 1u);
+}
+
+TEST(MessageRing, ThreadsExchangeEveryRecord) {
+	static RingMemory<4096> memory;
+	memory.ring.Initialize(4096);
+	constexpr uint64_t kCount = 50000;
+	std::thread producer([] {
+		for (uint64_t i = 0; i < kCount; ++i) {
+			uint64_t words[4] = { i, i, i, i };
+			size_t size = sizeof(uint64_t) * (1 + i % 4);
+			while (!memory.ring.TryWrite(static_cast<uint32_t>(size), words, size)) {
+				std::this_thread::yield();
+			}
+		}
+	});
+	uint64_t expected = 0;
+	while (expected < kCount) {
+		uint64_t before = expected;
+		memory.ring.Drain([&](uint32_t type, const void* data, uint64_t size) {
+			ASSERT_EQ(size, type);
+			uint64_t words[4];
+			memcpy(words, data, static_cast<size_t>(size));
+			for (uint64_t w = 0; w < size / sizeof(uint64_t); ++w) {
+				ASSERT_EQ(words[w], expected);
+			}
+			++expected;
+		});
+		if (expected == before) {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+}
+
+TEST(MessageRingBenchmark, Throughput) {
+	static RingMemory<1 << 16> memory;
+	memory.ring.Initialize(1 << 16);
+	constexpr uint64_t kCount = 500000;
+	uint8_t payload[64] = {};
+	BenchmarkTimer timer;
+	std::thread producer([&] {
+		for (uint64_t i = 0; i < kCount; ++i) {
+			while (!memory.ring.TryWrite(1, payload, sizeof(payload))) {
+				std::this_thread::yield();
+			}
+		}
+	});
+	uint64_t received = 0;
+	uint64_t bytes = 0;
+	while (received < kCount) {
+		uint64_t drained = memory.ring.Drain([&](uint32_t, const void* data, uint64_t size) {
+			bytes += size;
+			KeepValue(data);
+		});
+		if (!drained) {
+			std::this_thread::yield();
+		}
+		received += drained;
+	}
+	producer.join();
+	ReportBenchmark("MessageRing 64-byte records, one thread each side", kCount, timer.ElapsedNanoseconds());
+	EXPECT_EQ(bytes, kCount * sizeof(payload));
+}
+
+TEST(MessageRingBenchmark, Latency) {
+	static RingMemory<1 << 12> memory;
+	memory.ring.Initialize(1 << 12);
+	constexpr uint64_t kCount = 20000;
+	std::vector<double> samples;
+	samples.reserve(kCount);
+	std::thread consumer([&] {
+		while (samples.size() < kCount) {
+			uint64_t drained = memory.ring.Drain([&](uint32_t, const void* data, uint64_t) {
+				std::chrono::steady_clock::time_point sent;
+				memcpy(&sent, data, sizeof(sent));
+				samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - sent).count());
+			});
+			if (!drained) {
+				std::this_thread::yield();
+			}
+		}
+	});
+	for (uint64_t i = 0; i < kCount; ++i) {
+		// One record in flight at a time, so the time measured is the hand-off alone
+		while (!memory.ring.IsEmpty()) {
+			std::this_thread::yield();
+		}
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		memory.ring.TryWrite(1, &now, sizeof(now));
+	}
+	consumer.join();
+	std::sort(samples.begin(), samples.end());
+	printf("[ BENCH    ] MessageRing hand-off latency: p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns\n",
+		samples[kCount / 2], samples[kCount * 99 / 100], samples[kCount * 999 / 1000]);
+	ReportBenchmark("MessageRing hand-off latency (mean)", kCount, [&] {
+		double sum = 0.0;
+		for (double sample : samples) {
+			sum += sample;
+		}
+		return sum;
+	}());
+}
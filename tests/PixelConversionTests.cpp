@@ -0,0 +1,149 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../include/Render/PixelConversion.hpp"
+
+namespace {
+	using Pixels = std::vector<uint32_t>;
+
+	uint32_t MakePixel(uint32_t alpha, uint32_t red, uint32_t green, uint32_t blue) {
+		return (alpha << 24) | (red << 16) | (green << 8) | blue;
+	}
+
+	// Every alpha with every channel value, in the three color channels at once
+	Pixels EveryAlphaAndChannel() {
+		Pixels pixels;
+		pixels.reserve(256 * 256);
+		for (uint32_t alpha = 0; alpha < 256; ++alpha) {
+			for (uint32_t value = 0; value < 256; ++value) {
+				pixels.push_back(MakePixel(alpha, value, 255 - value, value ^ 0x5A));
+			}
+		}
+		return pixels;
+	}
+
+	// Premultiplied pixels: no color channel above alpha
+	Pixels EveryPremultiplied() {
+		Pixels pixels;
+		for (uint32_t alpha = 0; alpha < 256; ++alpha) {
+			for (uint32_t value = 0; value <= alpha; ++value) {
+				pixels.push_back(MakePixel(alpha, value, alpha - value, value / 2));
+			}
+		}
+		return pixels;
+	}
+
+	Pixels RandomPixels(size_t count, uint32_t seed, int opaquePercent) {
+		std::mt19937 random(seed);
+		Pixels pixels(count);
+		for (uint32_t& pixel : pixels) {
+			pixel = static_cast<uint32_t>(random());
+			if (static_cast<int>(random() % 100) < opaquePercent) {
+				pixel |= 0xFF000000;
+			}
+		}
+		return pixels;
+	}
+
+	// Runs a row kernel over the whole buffer and over every offset and length that
+	// leaves a partial SSE2 block at either end
+	template <typename Kernel, typename Scalar>
+	void ExpectSameAsScalar(const Pixels& source, Kernel kernel, Scalar scalar) {
+		Pixels expected(source.size());
+		Pixels actual(source.size());
+		scalar(source.data(), expected.data(), source.size());
+		kernel(source.data(), actual.data(), source.size());
+		ASSERT_EQ(actual, expected);
+		for (size_t offset = 0; offset < 4; ++offset) {
+			for (size_t count = 0; count <= 11; ++count) {
+				Pixels tail(count, 0xDEADBEEF);
+				kernel(source.data() + 1000 + offset, tail.data(), count);
+				ASSERT_TRUE(std::equal(tail.begin(), tail.end(), expected.begin() + 1000 + offset)) << "offset " << offset << " count " << count;
+			}
+		}
+	}
+}
+
+TEST(PixelConversion, PremultiplyMatchesScalarForEveryInput) {
+	ExpectSameAsScalar(EveryAlphaAndChannel(), &PixelConversion::PremultiplyRow, &PixelConversion::ScalarPremultiplyRow);
+	ExpectSameAsScalar(RandomPixels(4099, 1, 30), &PixelConversion::PremultiplyRow, &PixelConversion::ScalarPremultiplyRow);
+}
+
+TEST(PixelConversion, UnpremultiplyMatchesScalarForEveryPremultipliedInput) {
+	ExpectSameAsScalar(EveryPremultiplied(), &PixelConversion::UnpremultiplyRow, &PixelConversion::ScalarUnpremultiplyRow);
+}
+
+// Channels above alpha are not valid premultiplied colors; both kernels clamp them to 255
+TEST(PixelConversion, UnpremultiplyMatchesScalarForInvalidInput) {
+	ExpectSameAsScalar(EveryAlphaAndChannel(), &PixelConversion::UnpremultiplyRow, &PixelConversion::ScalarUnpremultiplyRow);
+	ExpectSameAsScalar(RandomPixels(4099, 2, 30), &PixelConversion::UnpremultiplyRow, &PixelConversion::ScalarUnpremultiplyRow);
+}
+
+TEST(PixelConversion, RoundsToNearest) {
+	const Pixels source = { MakePixel(128, 255, 128, 1), MakePixel(0, 200, 100, 50), MakePixel(255, 1, 2, 3), MakePixel(1, 1, 0, 1) };
+	Pixels premultiplied(source.size());
+	PixelConversion::PremultiplyRow(source.data(), premultiplied.data(), source.size());
+	EXPECT_EQ(premultiplied, (Pixels{ MakePixel(128, 128, 64, 1), MakePixel(0, 0, 0, 0), MakePixel(255, 1, 2, 3), MakePixel(1, 0, 0, 0) }));
+	Pixels straight(source.size());
+	PixelConversion::UnpremultiplyRow(premultiplied.data(), straight.data(), premultiplied.size());
+	EXPECT_EQ(straight, (Pixels{ MakePixel(128, 255, 128, 2), 0, MakePixel(255, 1, 2, 3), MakePixel(1, 0, 0, 0) }));
+}
+
+TEST(PixelConversion, ConvertsInPlaceAndFlipsRows) {
+	Pixels pixels = RandomPixels(3 * 5, 3, 50);
+	Pixels expected(pixels.size());
+	PixelConversion::ScalarPremultiplyRow(pixels.data(), expected.data(), expected.size());
+	PixelConversion::Convert(pixels.data(), 5 * 4, pixels.data(), 5 * 4, 5, 3, AlphaConversion::Premultiply);
+	EXPECT_EQ(pixels, expected);
+
+	Pixels flipped(pixels.size());
+	PixelConversion::Convert(pixels.data(), 5 * 4, flipped.data() + 2 * 5, -5 * 4, 5, 3, AlphaConversion::None);
+	for (int row = 0; row < 3; ++row) {
+		EXPECT_TRUE(std::equal(flipped.begin() + row * 5, flipped.begin() + row * 5 + 5, pixels.begin() + (2 - row) * 5));
+	}
+}
+
+namespace {
+	constexpr uint32_t kWidth = 1920;
+	constexpr uint32_t kHeight = 1080;
+	constexpr uint64_t kFramePixels = uint64_t(kWidth) * kHeight;
+
+	template <typename Kernel>
+	void BenchmarkKernel(const char* name, const Pixels& source, Kernel kernel, int rounds) {
+		Pixels target(source.size());
+		BenchmarkTimer timer;
+		for (int round = 0; round < rounds; ++round) {
+			for (uint32_t y = 0; y < kHeight; ++y) {
+				kernel(source.data() + size_t(y) * kWidth, target.data() + size_t(y) * kWidth, kWidth);
+			}
+			KeepValue(target);
+		}
+		ReportBenchmark(name, rounds * kFramePixels, timer.ElapsedNanoseconds());
+	}
+}
+
+// A 1080p frame with translucent pixels everywhere: the SSE2 kernels against the scalar
+// versions, per pixel
+TEST(PixelConversionBenchmark, PremultiplyTranslucentFrame) {
+	Pixels source = RandomPixels(kFramePixels, 4, 0);
+	BenchmarkKernel("Premultiply 1080p, translucent, per pixel", source, &PixelConversion::PremultiplyRow, 10);
+	BenchmarkKernel("Scalar premultiply 1080p, translucent, per pixel", source, &PixelConversion::ScalarPremultiplyRow, 3);
+}
+
+TEST(PixelConversionBenchmark, UnpremultiplyTranslucentFrame) {
+	Pixels source(kFramePixels);
+	PixelConversion::ScalarPremultiplyRow(RandomPixels(kFramePixels, 5, 0).data(), source.data(), source.size());
+	BenchmarkKernel("Unpremultiply 1080p, translucent, per pixel", source, &PixelConversion::UnpremultiplyRow, 10);
+	BenchmarkKernel("Scalar unpremultiply 1080p, translucent, per pixel", source, &PixelConversion::ScalarUnpremultiplyRow, 3);
+}
+
+// Snapshots are mostly opaque, which both kernels copy through
+TEST(PixelConversionBenchmark, PremultiplyOpaqueFrame) {
+	Pixels source = RandomPixels(kFramePixels, 6, 100);
+	BenchmarkKernel("Premultiply 1080p, opaque, per pixel", source, &PixelConversion::PremultiplyRow, 10);
+	BenchmarkKernel("Scalar premultiply 1080p, opaque, per pixel", source, &PixelConversion::ScalarPremultiplyRow, 10);
+}
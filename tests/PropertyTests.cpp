@@ -0,0 +1,203 @@
+#include "pch.h"
+
+#include <memory>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../include/Event/Property.hpp"
+
+TEST(Property, EffectRunsOnceOnTheFirstFlush) {
+	PropertyGraph graph;
+	Property<int> width(graph, 10);
+	int runs = 0;
+	PropertyEffect effect(graph, { &width }, [&runs] { ++runs; });
+	EXPECT_TRUE(graph.HasPending());
+	graph.Flush();
+	graph.Flush();
+	EXPECT_EQ(runs, 1);
+	EXPECT_FALSE(graph.HasPending());
+}
+
+TEST(Property, DiamondRecomputesEachValueOnce) {
+	PropertyGraph graph;
+	Property<int> source(graph, 1);
+	Computed<int> left(graph, { &source }, [&source] { return source.Get() + 1; });
+	Computed<int> right(graph, { &source }, [&source] { return source.Get() * 2; });
+	Computed<int> sum(graph, { &left, &right }, [&left, &right] { return left.Get() + right.Get(); });
+	int seen = 0;
+	PropertyEffect effect(graph, { &sum }, [&seen, &sum] { seen = sum.Get(); });
+	graph.Flush();
+	EXPECT_EQ(seen, 4);
+	uint64_t before = graph.GetStats().recomputations;
+	source.Set(5);
+	graph.Flush();
+	EXPECT_EQ(seen, 16);
+	EXPECT_EQ(graph.GetStats().recomputations - before, 3u);
+}
+
+TEST(Property, UnchangedResultStopsPropagation) {
+	PropertyGraph graph;
+	Property<int> value(graph, 3);
+	Computed<bool> positive(graph, { &value }, [&value] { return value.Get() > 0; });
+	int downstream = 0;
+	Computed<int> label(graph, { &positive }, [&downstream, &positive] {
+		++downstream;
+		return positive.Get() ? 1 : -1;
+	});
+	int runs = 0;
+	PropertyEffect effect(graph, { &label }, [&runs, &label] {
+		label.Get();
+		++runs;
+	});
+	graph.Flush();
+	value.Set(7);
+	graph.Flush();
+	EXPECT_EQ(downstream, 1);
+	EXPECT_EQ(runs, 1);
+	EXPECT_EQ(graph.GetStats().recomputationsSkipped, 1u);
+	EXPECT_EQ(graph.GetStats().effectsSkipped, 1u);
+	value.Set(-1);
+	graph.Flush();
+	EXPECT_EQ(downstream, 2);
+	EXPECT_EQ(runs, 2);
+}
+
+TEST(Property, SettingAnEqualValueSchedulesNothing) {
+	PropertyGraph graph;
+	Property<int> value(graph, 3);
+	PropertyEffect effect(graph, { &value }, [] {});
+	graph.Flush();
+	value.Set(3);
+	EXPECT_FALSE(graph.HasPending());
+}
+
+TEST(Property, EffectsMayChangePropertiesDuringAFlush) {
+	PropertyGraph graph;
+	Property<int> input(graph, 0);
+	Property<int> mirrored(graph, 0);
+	PropertyEffect copy(graph, { &input }, [&input, &mirrored] { mirrored.Set(input.Get()); });
+	int seen = -1;
+	PropertyEffect show(graph, { &mirrored }, [&seen, &mirrored] { seen = mirrored.Get(); });
+	graph.Flush();
+	input.Set(9);
+	graph.Flush();
+	EXPECT_EQ(seen, 9);
+	EXPECT_FALSE(graph.HasPending());
+}
+
+TEST(Property, EffectMayDestroyAnotherScheduledEffect) {
+	PropertyGraph graph;
+	Property<int> value(graph, 0);
+	std::unique_ptr<PropertyEffect> victim;
+	int victimRuns = 0;
+	PropertyEffect killer(graph, { &value }, [&victim] { victim.reset(); });
+	victim = std::make_unique<PropertyEffect>(graph, std::initializer_list<PropertyNode*>{ &value }, [&victimRuns] { ++victimRuns; });
+	graph.Flush();
+	EXPECT_EQ(victim.get(), nullptr);
+	EXPECT_EQ(victimRuns, 0);
+}
+
+namespace {
+	// `kSources` properties, each feeding one derived value, summed in groups of ten by
+	// `kEffects` effects: the shape of a form bound to its model
+	struct WideGraph {
+		static constexpr int kSources = 1000;
+		static constexpr int kEffects = 100;
+
+		PropertyGraph graph;
+		std::vector<std::unique_ptr<Property<int>>> sources;
+		std::vector<std::unique_ptr<Computed<int>>> derived;
+		std::vector<std::unique_ptr<PropertyEffect>> effects;
+		Computed<int>* groups[kSources] = {};
+		int64_t total = 0;
+
+		WideGraph() {
+			for (int i = 0; i < kSources; ++i) {
+				sources.push_back(std::make_unique<Property<int>>(graph, i));
+				Property<int>* source = sources.back().get();
+				derived.push_back(std::make_unique<Computed<int>>(graph, std::initializer_list<PropertyNode*>{ source }, [source] { return source->Get() * 3; }));
+			}
+			for (int e = 0; e < kEffects; ++e) {
+				Computed<int>** group = &groups[e * 10];
+				for (int i = 0; i < 10; ++i) {
+					group[i] = derived[e * 10 + i].get();
+				}
+				effects.push_back(std::make_unique<PropertyEffect>(graph,
+					std::initializer_list<PropertyNode*>{ group[0], group[1], group[2], group[3], group[4], group[5], group[6], group[7], group[8], group[9] },
+					[this, group] {
+						for (int i = 0; i < 10; ++i) {
+							total += group[i]->Get();
+						}
+					}));
+			}
+			graph.Flush();
+		}
+	};
+}
+
+// A few changes per frame in a large graph: the cost should follow the changes, not the graph
+TEST(PropertyBenchmark, FlushTenChangesInAThousandNodeGraph) {
+	WideGraph wide;
+	const PropertyGraph::Stats start = wide.graph.GetStats();
+	constexpr int kFrames = 20000;
+	BenchmarkTimer timer;
+	for (int frame = 0; frame < kFrames; ++frame) {
+		for (int i = 0; i < 10; ++i) {
+			wide.sources[(frame * 37 + i * 101) % WideGraph::kSources]->Set(frame + i);
+		}
+		wide.graph.Flush();
+	}
+	ReportBenchmark("PropertyGraph flush, 10 of 1,000 sources changed", kFrames, timer.ElapsedNanoseconds());
+	KeepValue(wide.total);
+	const PropertyGraph::Stats& stats = wide.graph.GetStats();
+	printf("[ BENCH    ] PropertyGraph per flush: %.1f recomputations, %.1f effects run\n",
+		static_cast<double>(stats.recomputations - start.recomputations) / kFrames, static_cast<double>(stats.effectsRun - start.effectsRun) / kFrames);
+	EXPECT_LE(stats.recomputations - start.recomputations, 10ull * kFrames);
+	EXPECT_LE(stats.effectsRun - start.effectsRun, 10ull * kFrames);
+}
+
+// Every source changed at once: each derived value recomputed once, each effect run once
+TEST(PropertyBenchmark, FlushEverySourceChanged) {
+	WideGraph wide;
+	const PropertyGraph::Stats start = wide.graph.GetStats();
+	constexpr int kFrames = 500;
+	BenchmarkTimer timer;
+	for (int frame = 1; frame <= kFrames; ++frame) {
+		for (int i = 0; i < WideGraph::kSources; ++i) {
+			wide.sources[i]->Set(i + frame);
+		}
+		wide.graph.Flush();
+	}
+	ReportBenchmark("PropertyGraph set and flush, per source of 1,000", static_cast<uint64_t>(kFrames) * WideGraph::kSources, timer.ElapsedNanoseconds());
+	KeepValue(wide.total);
+	const PropertyGraph::Stats& stats = wide.graph.GetStats();
+	EXPECT_EQ(stats.recomputations - start.recomputations, static_cast<uint64_t>(kFrames) * WideGraph::kSources);
+	EXPECT_EQ(stats.effectsRun - start.effectsRun, static_cast<uint64_t>(kFrames) * WideGraph::kEffects);
+}
+
+// A 1,000-deep chain of derived values read by one effect
+TEST(PropertyBenchmark, FlushDeepChain) {
+	constexpr int kDepth = 1000;
+	PropertyGraph graph;
+	Property<int> source(graph, 0);
+	std::vector<std::unique_ptr<Computed<int>>> chain;
+	PropertyValue<int>* previous = &source;
+	for (int i = 0; i < kDepth; ++i) {
+		chain.push_back(std::make_unique<Computed<int>>(graph, std::initializer_list<PropertyNode*>{ previous }, [previous] { return previous->Get() + 1; }));
+		previous = chain.back().get();
+	}
+	int seen = 0;
+	Computed<int>* last = chain.back().get();
+	PropertyEffect effect(graph, { last }, [&seen, last] { seen = last->Get(); });
+	graph.Flush();
+	const PropertyGraph::Stats start = graph.GetStats();
+	constexpr int kFrames = 2000;
+	BenchmarkTimer timer;
+	for (int frame = 1; frame <= kFrames; ++frame) {
+		source.Set(frame);
+		graph.Flush();
+	}
+	ReportBenchmark("PropertyGraph flush, per node of a 1,000-deep chain", static_cast<uint64_t>(kFrames) * kDepth, timer.ElapsedNanoseconds());
+	EXPECT_EQ(seen, kFrames + kDepth);
+	EXPECT_EQ(graph.GetStats().recomputations - start.recomputations, static_cast<uint64_t>(kFrames) * kDepth);
+}
@@ -0,0 +1,181 @@
+#include "pch.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/Diagnostics/RingLogger.hpp"
+#include "../include/Diagnostics/MemoryLedger.hpp"
+
+namespace {
+	struct Lines {
+		std::mutex mutex;
+		std::vector<std::string> lines;
+
+		RingLogger::Sink MakeSink() {
+			return [this](LogLevel, const char* line, size_t length) {
+				std::lock_guard<std::mutex> lock(mutex);
+				lines.emplace_back(line, length);
+			};
+		}
+	};
+
+	void AppendTo(void* context, const char* data, size_t size) {
+		static_cast<std::string*>(context)->append(data, size);
+	}
+}
+
+TEST(RingLogger, FormatsArgumentsInOrder) {
+	Lines output;
+	RingLogger logger(output.MakeSink());
+	logger.Log<LogLevel::Info>("window {} has {} children", 7, 3u);
+	logger.Log<LogLevel::Debug>("filtered out");
+	logger.Flush();
+	ASSERT_EQ(output.lines.size(), 1u);
+	EXPECT_NE(output.lines[0].find("window 7 has 3 children"), std::string::npos);
+}
+
+TEST(RingLogger, LevelCanChangeAtRuntime) {
+	Lines output;
+	RingLogger logger(output.MakeSink());
+	logger.SetLevel(LogLevel::Debug);
+	EXPECT_TRUE(logger.IsEnabled<LogLevel::Debug>());
+	logger.Log<LogLevel::Debug>("debug {}", 1);
+	logger.SetLevel(LogLevel::Error);
+	EXPECT_FALSE(logger.IsEnabled<LogLevel::Warning>());
+	logger.Log<LogLevel::Warning>("warning {}", 2);
+	logger.Log<LogLevel::Error>("error {}", 3);
+	logger.Flush();
+	ASSERT_EQ(output.lines.size(), 2u);
+	EXPECT_NE(output.lines[0].find("debug 1"), std::string::npos);
+	EXPECT_NE(output.lines[1].find("error 3"), std::string::npos);
+}
+
+// Window class names reach the logger as wide C strings
+TEST(RingLogger, FormatsWideStringsAsUtf8) {
+	Lines output;
+	RingLogger logger(output.MakeSink());
+	const wchar_t* className = L"Caf\u00e9 \u03a9 \U0001F600";
+	const wchar_t* missing = nullptr;
+	logger.Log<LogLevel::Error>("Failed to register window class {}. Error code: {}", className, 1410u);
+	logger.Log<LogLevel::Error>("{} and {}", std::wstring(L"wide"), missing);
+	logger.Flush();
+	ASSERT_EQ(output.lines.size(), 2u);
+	EXPECT_NE(output.lines[0].find("window class Caf\xc3\xa9 \xce\xa9 \xf0\x9f\x98\x80. Error code: 1410"), std::string::npos);
+	EXPECT_NE(output.lines[1].find("wide and (null)"), std::string::npos);
+}
+
+TEST(RingLogger, CountsRecordsDroppedByAFullRing) {
+	Lines output;
+	RingLogger logger(output.MakeSink(), 4096, std::chrono::hours(1));
+	const std::string text(200, 'x');
+	constexpr int kRecords = 100;
+	for (int i = 0; i < kRecords; ++i) {
+		logger.Log<LogLevel::Error>("{} {}", i, text);
+	}
+	uint64_t dropped = logger.GetDroppedCount();
+	EXPECT_GT(dropped, 0u);
+	logger.Flush();
+	ASSERT_FALSE(output.lines.empty());
+	EXPECT_EQ(output.lines.size() - 1, kRecords - dropped);
+	EXPECT_NE(output.lines.back().find("dropped " + std::to_string(dropped) + " records"), std::string::npos);
+}
+
+// Records that do not fit before the end of the ring continue at its start
+TEST(RingLogger, RecordsWrapAroundTheRing) {
+	Lines output;
+	RingLogger logger(output.MakeSink(), 4096, std::chrono::hours(1));
+	const std::string text(300, 'y');
+	int next = 0;
+	for (int round = 0; round < 20; ++round) {
+		for (int i = 0; i < 5; ++i) {
+			logger.Log<LogLevel::Error>("record {} {}", next++, text);
+		}
+		if (round == 8) {
+			// These five records sit on both sides of a wrap marker
+			std::string dump;
+			logger.Dump(&AppendTo, &dump);
+			EXPECT_NE(dump.find("record 40 "), std::string::npos);
+			EXPECT_NE(dump.find("record 44 "), std::string::npos);
+		}
+		logger.Flush();
+	}
+	EXPECT_EQ(logger.GetDroppedCount(), 0u);
+	ASSERT_EQ(output.lines.size(), static_cast<size_t>(next));
+	for (int i = 0; i < next; ++i) {
+		EXPECT_NE(output.lines[i].find("record " + std::to_string(i) + " " + text), std::string::npos) << i;
+	}
+}
+
+TEST(RingLogger, DumpIncludesPendingRecords) {
+	RingLogger logger(nullptr, RingLogger::kDefaultRingSize, std::chrono::hours(1));
+	logger.Log<LogLevel::Warning>("first {}", 1);
+	logger.Flush();
+	logger.Log<LogLevel::Error>("second {}", 2);
+	std::string dump;
+	logger.Dump(&AppendTo, &dump);
+	size_t history = dump.find("first 1");
+	size_t pending = dump.find("--- pending log ---");
+	ASSERT_NE(history, std::string::npos);
+	ASSERT_NE(pending, std::string::npos);
+	EXPECT_LT(history, pending);
+	EXPECT_NE(dump.find("second 2", pending), std::string::npos);
+}
+
+TEST(RingLogger, StopDropsLaterRecordsFromNewThreads) {
+	Lines output;
+	RingLogger logger(output.MakeSink());
+	logger.Stop();
+	std::thread([&logger]() {
+		logger.Log<LogLevel::Error>("after stop");
+	}).join();
+	EXPECT_EQ(logger.GetDroppedCount(), 1u);
+	EXPECT_TRUE(output.lines.empty());
+}
+
+// A dump that reaches the ring of an exited thread while the consumer drains and
+// retires it must still be able to read the ring. Records drained under the dump are
+// skipped: they are in the history from then on.
+TEST(RingLogger, DumpSurvivesRetiringRings) {
+	RingLogger logger(nullptr, RingLogger::kDefaultRingSize, std::chrono::hours(1));
+	std::thread([&logger]() {
+		logger.Log<LogLevel::Error>("pending {}", 1);
+		logger.Log<LogLevel::Error>("pending {}", 2);
+	}).join();
+	struct Context {
+		RingLogger* logger;
+		std::string dump;
+		bool flushed = false;
+	} context{ &logger, {}, false };
+	logger.Dump([](void* pointer, const char* data, size_t size) {
+		Context& context = *static_cast<Context*>(pointer);
+		context.dump.append(data, size);
+		if (!context.flushed && context.dump.find("pending 1") != std::string::npos) {
+			// Drains the retired ring in the middle of the dump
+			context.flushed = true;
+			context.logger->Flush();
+		}
+	}, &context);
+	EXPECT_TRUE(context.flushed);
+	EXPECT_EQ(context.dump.find("pending 2"), std::string::npos);
+	std::string dump;
+	logger.Dump(&AppendTo, &dump);
+	EXPECT_LT(dump.find("pending 2"), dump.find("--- pending log ---"));
+}
+
+TEST(RingLogger, ChargesRingsAsArenas) {
+	auto arenas = [] {
+		return GetMemoryLedger().GetOwnerReport(0).categories[static_cast<size_t>(MemoryCategory::Arena)].current;
+	};
+	const uint64_t before = arenas();
+	RingLogger logger(nullptr, 4096, std::chrono::hours(1));
+	std::thread([&logger, &arenas, before]() {
+		logger.Log<LogLevel::Error>("ring {}", 1);
+		EXPECT_EQ(arenas(), before + 4096);
+	}).join();
+	// The ring of the exited thread is freed once drained
+	EXPECT_EQ(arenas(), before + 4096);
+	logger.Flush();
+	EXPECT_EQ(arenas(), before);
+}
@@ -0,0 +1,32 @@
+#include "pch.h"
+
+#ifdef _WIN32
+#include <stdexcept>
+#include <windows.h>
+
+#include "../include/Ipc/SharedFrameSurface.hpp"
+
+TEST(SharedFrameSurface, CreatesAndPublishesAFrame) {
+	SharedFrameSurface surface(nullptr, 64, 32);
+	SharedFrameSurface::Frame frame = surface.BeginFrame();
+	ASSERT_NE(frame.pixels, nullptr);
+	EXPECT_EQ(frame.stride, 256u);
+	static_cast<uint32_t*>(frame.pixels)[0] = 0xFF102030;
+	uint64_t sequence = surface.EndFrame();
+	EXPECT_TRUE(surface.AcquireFrame());
+	SharedFrameSurface::Frame acquired = surface.GetFrame();
+	EXPECT_EQ(acquired.sequence, sequence);
+	EXPECT_EQ(static_cast<uint32_t*>(acquired.pixels)[0], 0xFF102030u);
+}
+
+// Slot offsets are DWORDs, so sizes whose three slots do not fit in 4 GiB are refused
+// before anything is mapped
+TEST(SharedFrameSurface, RejectsOversizedSurfaces) {
+	EXPECT_THROW(SharedFrameSurface(nullptr, 0, 10), std::runtime_error);
+	EXPECT_THROW(SharedFrameSurface(nullptr, 1u << 30, 1), std::runtime_error);
+	EXPECT_THROW(SharedFrameSurface(nullptr, 32769, 1), std::runtime_error);
+	EXPECT_THROW(SharedFrameSurface(nullptr, 32768, 32768), std::runtime_error);
+	// 3 x 20000 x 20000 x 4 bytes is about 4.8 GB
+	EXPECT_THROW(SharedFrameSurface(nullptr, 20000, 20000), std::runtime_error);
+}
+#endif
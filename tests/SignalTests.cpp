@@ -0,0 +1,171 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../include/Event/Signal.hpp"
+
+namespace {
+	struct Counter {
+		int calls = 0;
+		int total = 0;
+
+		void Add(int value) {
+			++calls;
+			total += value;
+		}
+	};
+}
+
+TEST(Signal, CallsEverySlot) {
+	Signal<int> signal;
+	Counter a;
+	Counter b;
+	signal.Connect<&Counter::Add>(&a);
+	signal.Connect([&b](int value) { b.Add(value * 2); });
+	signal.Emit(3);
+	signal(4);
+	EXPECT_EQ(a.total, 7);
+	EXPECT_EQ(b.total, 14);
+	EXPECT_EQ(signal.GetConnectionCount(), 2u);
+}
+
+TEST(Signal, DisconnectedHandlesGoStale) {
+	Signal<int> signal;
+	Counter a;
+	Counter b;
+	SignalConnection first = signal.Connect<&Counter::Add>(&a);
+	signal.Disconnect(first);
+	// Reuses the slot of the first connection
+	SignalConnection second = signal.Connect<&Counter::Add>(&b);
+	EXPECT_EQ(second.index, first.index);
+	signal.Disconnect(first);
+	signal.Emit(1);
+	EXPECT_EQ(a.calls, 0);
+	EXPECT_EQ(b.calls, 1);
+	{
+		ScopedConnection scoped = signal.ConnectScoped([&a](int value) { a.Add(value); });
+		signal.Emit(1);
+	}
+	signal.Emit(1);
+	EXPECT_EQ(a.calls, 1);
+	EXPECT_EQ(b.calls, 3);
+}
+
+TEST(Signal, SlotsKeepTheirStateBetweenEmits) {
+	Signal<> signal;
+	int last = 0;
+	signal.Connect([count = 0, seen = &last]() mutable { *seen = ++count; });
+	signal.Emit();
+	signal.Emit();
+	signal.Emit();
+	EXPECT_EQ(last, 3);
+}
+
+TEST(Signal, SlotsMayConnectAndDisconnectWhileEmitting) {
+	Signal<int> signal;
+	Counter counters[40];
+	std::vector<SignalConnection> connections;
+	struct Context {
+		Signal<int>* signal;
+		Counter* counters;
+		std::vector<SignalConnection>* connections;
+	} context{ &signal, counters, &connections };
+	// Connecting past the first chunk must not move the running slot
+	connections.push_back(signal.Connect([c = &context](int value) {
+		for (int i = 1; i < 40; ++i) {
+			c->connections->push_back(c->signal->Connect<&Counter::Add>(&c->counters[i]));
+		}
+		c->signal->Disconnect((*c->connections)[0]);
+		c->counters[0].Add(value);
+	}));
+	signal.Emit(1);
+	EXPECT_EQ(counters[0].calls, 1);
+	EXPECT_EQ(counters[1].calls, 0);
+	signal.Emit(1);
+	EXPECT_EQ(counters[0].calls, 1);
+	EXPECT_TRUE(std::all_of(counters + 1, counters + 40, [](const Counter& counter) { return counter.calls == 1; }));
+	EXPECT_EQ(signal.GetConnectionCount(), 39u);
+}
+
+TEST(Signal, SlotMayDestroyTheSignal) {
+	auto signal = std::make_unique<Signal<int>>();
+	Counter before;
+	Counter after;
+	int seen = 0;
+	std::unique_ptr<Signal<int>>* owner = &signal;
+	signal->Connect<&Counter::Add>(&before);
+	signal->Connect([owner, seen = &seen, tag = 42](int) {
+		owner->reset();
+		// The running slot stays alive until the emit unwinds
+		*seen = tag;
+	});
+	signal->Connect<&Counter::Add>(&after);
+	(*signal)(1);
+	EXPECT_EQ(signal.get(), nullptr);
+	EXPECT_EQ(seen, 42);
+	EXPECT_EQ(before.calls, 1);
+	EXPECT_EQ(after.calls, 0);
+}
+
+TEST(Signal, NestedEmitSurvivesDestruction) {
+	auto signal = std::make_unique<Signal<int>>();
+	std::unique_ptr<Signal<int>>* owner = &signal;
+	int calls = 0;
+	int* count = &calls;
+	signal->Connect([owner, count](int depth) {
+		++*count;
+		if (depth == 0) {
+			(**owner)(1);
+		}
+		else {
+			owner->reset();
+		}
+	});
+	(*signal)(0);
+	EXPECT_EQ(calls, 2);
+	EXPECT_EQ(signal.get(), nullptr);
+}
+
+TEST(SignalBenchmark, EmitToEightSlots) {
+	Signal<int> signal;
+	Counter counters[8];
+	for (Counter& counter : counters) {
+		signal.Connect<&Counter::Add>(&counter);
+	}
+	constexpr int kEmits = 2000000;
+	BenchmarkTimer timer;
+	for (int i = 0; i < kEmits; ++i) {
+		signal.Emit(i);
+	}
+	ReportBenchmark("Signal emit, 8 slots", kEmits, timer.ElapsedNanoseconds());
+	EXPECT_EQ(counters[7].calls, kEmits);
+}
+
+TEST(SignalBenchmark, EmitToManySlots) {
+	Signal<int> signal;
+	std::vector<Counter> counters(1000);
+	for (Counter& counter : counters) {
+		signal.Connect<&Counter::Add>(&counter);
+	}
+	constexpr int kEmits = 10000;
+	BenchmarkTimer timer;
+	for (int i = 0; i < kEmits; ++i) {
+		signal.Emit(i);
+	}
+	ReportBenchmark("Signal emit, per slot of 1,000", static_cast<uint64_t>(kEmits) * counters.size(), timer.ElapsedNanoseconds());
+	EXPECT_EQ(counters.back().calls, kEmits);
+}
+
+TEST(SignalBenchmark, EmitToNoSlots) {
+	Signal<int> signal;
+	constexpr int kEmits = 10000000;
+	BenchmarkTimer timer;
+	for (int i = 0; i < kEmits; ++i) {
+		signal.Emit(i);
+	}
+	ReportBenchmark("Signal emit, no slots", kEmits, timer.ElapsedNanoseconds());
+	EXPECT_TRUE(signal.IsEmpty());
+}
@@ -0,0 +1,155 @@
+#include "pch.h"
+
+#ifdef _WIN32
+#include <memory>
+#include <string>
+#include <windows.h>
+#include <commctrl.h>
+
+#include "Benchmark.h"
+#include "../include/Window/SubclassChain.hpp"
+
+#pragma comment(lib, "comctl32.lib")
+
+namespace {
+	constexpr UINT kLayers = 8;
+	constexpr UINT kUnhandled = WM_USER + 100;
+	constexpr int kMessages = 200000;
+
+	HWND CreateTestWindow() {
+		static bool registered = false;
+		if (!registered) {
+			WNDCLASS windowClass = {};
+			windowClass.lpfnWndProc = DefWindowProc;
+			windowClass.hInstance = GetModuleHandleW(NULL);
+			windowClass.lpszClassName = L"wincpp.SubclassChainTests";
+			RegisterClass(&windowClass);
+			registered = true;
+		}
+		return CreateWindowEx(0, L"wincpp.SubclassChainTests", L"", 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, GetModuleHandleW(NULL), NULL);
+	}
+
+	// One `SetWindowSubclass` layer per message, each forwarding everything else
+	LRESULT CALLBACK CountingSubclass(HWND window, UINT message, WPARAM wParam, LPARAM lParam, UINT_PTR id, DWORD_PTR data) {
+		if (message == WM_USER + id) {
+			++*reinterpret_cast<uint64_t*>(data);
+			return 1;
+		}
+		return DefSubclassProc(window, message, wParam, lParam);
+	}
+}
+
+TEST(SubclassChain, HandlerMayDestroyTheChain) {
+	HWND window = CreateTestWindow();
+	ASSERT_NE(window, nullptr);
+	auto chain = std::make_unique<SubclassChain>(window);
+	std::string seen;
+	int outerCalls = 0;
+	chain->AddLayer({ WM_USER }, [&outerCalls](HWND, UINT, WPARAM, LPARAM, LRESULT&) {
+		++outerCalls;
+		return false;
+	});
+	chain->AddLayer({ WM_USER }, [&chain, &seen, tag = std::string("captured state")](HWND, UINT, WPARAM, LPARAM, LRESULT& result) {
+		chain.reset();
+		// The closure must still be alive after its chain is gone
+		seen = tag;
+		result = 7;
+		return true;
+	});
+	EXPECT_EQ(SendMessage(window, WM_USER, 0, 0), 7);
+	EXPECT_EQ(seen, "captured state");
+	EXPECT_EQ(outerCalls, 0);
+	// The chain detached itself on the way out
+	EXPECT_EQ(GetProp(window, L"wincpp.SubclassChain"), nullptr);
+	DestroyWindow(window);
+}
+
+TEST(SubclassChain, HandlerMayDestroyTheChainFromANestedMessage) {
+	HWND window = CreateTestWindow();
+	ASSERT_NE(window, nullptr);
+	auto chain = std::make_unique<SubclassChain>(window);
+	chain->AddLayer({ WM_USER + 1 }, [&chain](HWND, UINT, WPARAM, LPARAM, LRESULT&) {
+		chain.reset();
+		return false;
+	});
+	chain->AddLayer({ WM_USER }, [](HWND window, UINT, WPARAM, LPARAM, LRESULT& result) {
+		SendMessage(window, WM_USER + 1, 0, 0);
+		result = 3;
+		return true;
+	});
+	EXPECT_EQ(SendMessage(window, WM_USER, 0, 0), 3);
+	EXPECT_EQ(chain.get(), nullptr);
+	DestroyWindow(window);
+}
+
+TEST(SubclassChainBenchmark, UnhandledMessage) {
+	HWND window = CreateTestWindow();
+	ASSERT_NE(window, nullptr);
+	uint64_t handled = 0;
+	{
+		SubclassChain chain(window);
+		for (UINT i = 1; i <= kLayers; ++i) {
+			chain.AddLayer({ WM_USER + i }, [&handled](HWND, UINT, WPARAM, LPARAM, LRESULT& result) {
+				++handled;
+				result = 1;
+				return true;
+			});
+		}
+		BenchmarkTimer timer;
+		for (int i = 0; i < kMessages; ++i) {
+			SendMessage(window, kUnhandled, 0, 0);
+		}
+		ReportBenchmark("SubclassChain, 8 layers, unhandled message", kMessages, timer.ElapsedNanoseconds());
+		EXPECT_EQ(chain.GetStats().bypassed, static_cast<uint64_t>(kMessages));
+	}
+	for (UINT i = 1; i <= kLayers; ++i) {
+		SetWindowSubclass(window, CountingSubclass, i, reinterpret_cast<DWORD_PTR>(&handled));
+	}
+	BenchmarkTimer timer;
+	for (int i = 0; i < kMessages; ++i) {
+		SendMessage(window, kUnhandled, 0, 0);
+	}
+	ReportBenchmark("SetWindowSubclass, 8 layers, unhandled message", kMessages, timer.ElapsedNanoseconds());
+	for (UINT i = 1; i <= kLayers; ++i) {
+		RemoveWindowSubclass(window, CountingSubclass, i);
+	}
+	EXPECT_EQ(handled, 0u);
+	DestroyWindow(window);
+}
+
+// The message handled by the oldest layer, so every newer layer is passed first
+TEST(SubclassChainBenchmark, HandledByDeepestLayer) {
+	HWND window = CreateTestWindow();
+	ASSERT_NE(window, nullptr);
+	uint64_t handled = 0;
+	{
+		SubclassChain chain(window);
+		for (UINT i = 1; i <= kLayers; ++i) {
+			chain.AddLayer({ WM_USER + i }, [&handled](HWND, UINT, WPARAM, LPARAM, LRESULT& result) {
+				++handled;
+				result = 1;
+				return true;
+			});
+		}
+		BenchmarkTimer timer;
+		for (int i = 0; i < kMessages; ++i) {
+			SendMessage(window, WM_USER + 1, 0, 0);
+		}
+		ReportBenchmark("SubclassChain, 8 layers, deepest layer handles", kMessages, timer.ElapsedNanoseconds());
+	}
+	// SetWindowSubclass calls the newest subclass first, like the chain
+	for (UINT i = 1; i <= kLayers; ++i) {
+		SetWindowSubclass(window, CountingSubclass, i, reinterpret_cast<DWORD_PTR>(&handled));
+	}
+	BenchmarkTimer timer;
+	for (int i = 0; i < kMessages; ++i) {
+		SendMessage(window, WM_USER + 1, 0, 0);
+	}
+	ReportBenchmark("SetWindowSubclass, 8 layers, deepest layer handles", kMessages, timer.ElapsedNanoseconds());
+	for (UINT i = 1; i <= kLayers; ++i) {
+		RemoveWindowSubclass(window, CountingSubclass, i);
+	}
+	EXPECT_EQ(handled, 2u * kMessages);
+	DestroyWindow(window);
+}
+#endif
@@ -0,0 +1,181 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../include/Render/TripleBuffer.hpp"
+
+namespace {
+	// A frame as the headless backend draws it: plain memory, no device
+	struct HeadlessFrame {
+		static constexpr uint32_t kWidth = 256;
+		static constexpr uint32_t kHeight = 256;
+
+		std::vector<uint32_t> pixels = std::vector<uint32_t>(kWidth * kHeight);
+		std::chrono::steady_clock::time_point published;
+	};
+
+	void Render(HeadlessFrame& frame, uint64_t sequence) {
+		uint32_t color = static_cast<uint32_t>(sequence * 2654435761u);
+		for (uint32_t y = 0; y < HeadlessFrame::kHeight; ++y) {
+			uint32_t* row = frame.pixels.data() + y * HeadlessFrame::kWidth;
+			for (uint32_t x = 0; x < HeadlessFrame::kWidth; ++x) {
+				row[x] = color ^ (x << 8) ^ y;
+			}
+		}
+	}
+
+	uint64_t Present(const HeadlessFrame& frame) {
+		uint64_t sum = 0;
+		for (uint32_t pixel : frame.pixels) {
+			sum += pixel;
+		}
+		return sum;
+	}
+}
+
+TEST(TripleBuffer, ValuesArriveWhole) {
+	struct Value {
+		uint64_t words[16];
+	};
+	TripleBuffer<Value> buffer;
+	constexpr uint64_t kCount = 200000;
+	std::thread producer([&] {
+		for (uint64_t i = 1; i <= kCount; ++i) {
+			Value& value = buffer.GetWriteBuffer();
+			for (uint64_t& word : value.words) {
+				word = i;
+			}
+			buffer.Publish();
+		}
+	});
+	uint64_t first = 0;
+	uint64_t last = 0;
+	uint64_t received = 0;
+	while (last < kCount) {
+		if (!buffer.Acquire()) {
+			continue;
+		}
+		const Value* value = buffer.GetReadBuffer();
+		ASSERT_NE(value, nullptr);
+		for (uint64_t word : value->words) {
+			ASSERT_EQ(word, buffer.GetReadSequence());
+		}
+		ASSERT_GT(buffer.GetReadSequence(), last);
+		if (first == 0) {
+			first = buffer.GetReadSequence();
+		}
+		last = buffer.GetReadSequence();
+		++received;
+	}
+	producer.join();
+	EXPECT_EQ(first - 1 + received + buffer.GetDroppedCount(), kCount);
+}
+
+// Handing over a small value as fast as both threads can go
+TEST(TripleBufferBenchmark, PublishThroughput) {
+	TripleBuffer<uint64_t> buffer;
+	constexpr uint64_t kCount = 2000000;
+	std::atomic<bool> done = false;
+	uint64_t acquired = 0;
+	BenchmarkTimer timer;
+	std::thread consumer([&] {
+		while (!done.load(std::memory_order_acquire)) {
+			if (buffer.Acquire()) {
+				KeepValue(*buffer.GetReadBuffer());
+				++acquired;
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+	});
+	for (uint64_t i = 1; i <= kCount; ++i) {
+		buffer.GetWriteBuffer() = i;
+		buffer.Publish();
+	}
+	double elapsed = timer.ElapsedNanoseconds();
+	done.store(true, std::memory_order_release);
+	consumer.join();
+	ReportBenchmark("TripleBuffer publish, consumer polling", kCount, elapsed);
+	EXPECT_GT(acquired, 0u);
+	EXPECT_EQ(buffer.GetPublishedSequence(), kCount);
+}
+
+// Render thread and presenter with the headless backend: frames rendered and presented
+// per second while neither side waits on the other
+TEST(TripleBufferBenchmark, HeadlessFrameThroughput) {
+	TripleBuffer<HeadlessFrame> frames;
+	constexpr uint64_t kFrames = 2000;
+	std::atomic<bool> done = false;
+	uint64_t presented = 0;
+	uint64_t first = 0;
+	BenchmarkTimer timer;
+	std::thread presenter([&] {
+		while (!done.load(std::memory_order_acquire) || frames.HasNewValue()) {
+			if (frames.Acquire()) {
+				KeepValue(Present(*frames.GetReadBuffer()));
+				if (first == 0) {
+					first = frames.GetReadSequence();
+				}
+				++presented;
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+	});
+	for (uint64_t i = 1; i <= kFrames; ++i) {
+		Render(frames.GetWriteBuffer(), i);
+		frames.Publish();
+	}
+	done.store(true, std::memory_order_release);
+	presenter.join();
+	double elapsed = timer.ElapsedNanoseconds();
+	ReportBenchmark("TripleBuffer 256x256 headless frames rendered", kFrames, elapsed);
+	ReportBenchmark("TripleBuffer 256x256 headless frames presented", presented, elapsed);
+	EXPECT_EQ(frames.GetReadSequence(), kFrames);
+	EXPECT_EQ(first - 1 + presented + frames.GetDroppedCount(), kFrames);
+}
+
+// Time from `Publish` until the presenter holds the frame, at a 1 ms render cadence
+TEST(TripleBufferBenchmark, HeadlessFrameLatency) {
+	TripleBuffer<HeadlessFrame> frames;
+	constexpr uint64_t kFrames = 500;
+	std::atomic<bool> done = false;
+	std::vector<double> samples;
+	samples.reserve(kFrames);
+	std::thread presenter([&] {
+		while (!done.load(std::memory_order_acquire)) {
+			if (frames.Acquire()) {
+				HeadlessFrame& frame = *frames.GetReadBuffer();
+				samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - frame.published).count());
+				KeepValue(Present(frame));
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+	});
+	for (uint64_t i = 1; i <= kFrames; ++i) {
+		HeadlessFrame& frame = frames.GetWriteBuffer();
+		Render(frame, i);
+		frame.published = std::chrono::steady_clock::now();
+		frames.Publish();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	done.store(true, std::memory_order_release);
+	presenter.join();
+	ASSERT_FALSE(samples.empty());
+	std::sort(samples.begin(), samples.end());
+	printf("[ BENCH    ] TripleBuffer publish-to-acquire latency: p50 %.0f ns, p99 %.0f ns, max %.0f ns (%zu of %llu frames)\n",
+		samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples.back(), samples.size(), static_cast<unsigned long long>(kFrames));
+	double sum = 0.0;
+	for (double sample : samples) {
+		sum += sample;
+	}
+	ReportBenchmark("TripleBuffer publish-to-acquire latency (mean)", samples.size(), sum);
+}
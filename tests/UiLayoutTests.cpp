@@ -0,0 +1,168 @@
+#include "pch.h"
+
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../include/Ui/UiLayout.hpp"
+
+#ifdef _WIN32
+#include "../include/Ui/UiTree.hpp"
+#endif
+
+namespace {
+	// 100 group boxes with nine buttons each: 1,000 controls, two levels deep
+	std::string MakeThousandControls() {
+		std::string text;
+		for (int group = 0; group < 100; ++group) {
+			int y = 8 + (group % 20) * 40;
+			int x = 8 + (group / 20) * 200;
+			text += "Button \"Group " + std::to_string(group) + "\" x=" + std::to_string(x) + " y=" + std::to_string(y) + " w=190 h=36 style=0x7 {\n";
+			for (int item = 0; item < 9; ++item) {
+				text += "\tButton \"Item " + std::to_string(item) + "\" id=" + std::to_string(1000 + group * 9 + item)
+					+ " x=" + std::to_string(4 + item * 20) + " y=14 w=18 h=18 style=0x3\n";
+			}
+			text += "}\n";
+		}
+		return text;
+	}
+
+	std::u16string ReadString(const UiLayoutView& view, uint32_t offset) {
+		return std::u16string(view.GetString(offset));
+	}
+}
+
+TEST(UiLayout, CompilesNestedControls) {
+	std::vector<uint8_t> bytes = UiLayoutCompiler::Compile(
+		"# login form\n"
+		"Static \"User name:\" x=8 y=10 w=80 h=14\n"
+		"Button \"Options\" id=3 x=8 y=40 w=244 h=80 style=0x7 {\n"
+		"\tButton \"Fast\" id=4 x=8 y=16 w=100 h=16 style=0x9 disabled\n"
+		"\tButton \"Safe\" id=5 x=8 y=36 w=100 h=16 hidden\n"
+		"}\n"
+		"Edit id=100 x=92 y=8 w=-1 h=0x12\n");
+	UiLayoutView view(bytes.data(), bytes.size());
+	ASSERT_EQ(view.GetNodeCount(), 5u);
+	EXPECT_EQ(view.GetNode(0).parent, kUiNoParent);
+	EXPECT_EQ(ReadString(view, view.GetNode(0).text), u"User name:");
+	EXPECT_EQ(view.GetNode(1).childCount, 2u);
+	EXPECT_EQ(view.GetNode(2).parent, 1u);
+	EXPECT_EQ(view.GetNode(2).flags, static_cast<uint32_t>(UiNodeDisabled));
+	EXPECT_EQ(view.GetNode(3).flags, static_cast<uint32_t>(UiNodeHidden));
+	EXPECT_EQ(view.GetNode(4).parent, kUiNoParent);
+	EXPECT_EQ(view.GetNode(4).text, kUiNoString);
+	EXPECT_EQ(view.GetNode(4).width, -1);
+	EXPECT_EQ(view.GetNode(4).height, 0x12);
+	// Class names are pooled once
+	EXPECT_EQ(view.GetNode(1).className, view.GetNode(2).className);
+	EXPECT_EQ(ReadString(view, view.GetNode(4).className), u"Edit");
+}
+
+TEST(UiLayout, CompilerReportsTheLine) {
+	try {
+		UiLayoutCompiler::Compile("Static x=1\nButton size=3\n");
+		FAIL() << "expected an error";
+	}
+	catch (const std::runtime_error& error) {
+		EXPECT_NE(std::string(error.what()).find("line 2"), std::string::npos);
+	}
+	EXPECT_THROW(UiLayoutCompiler::Compile("Button {\n"), std::runtime_error);
+	EXPECT_THROW(UiLayoutCompiler::Compile("}\n"), std::runtime_error);
+	EXPECT_THROW(UiLayoutCompiler::Compile("Static \"open\n"), std::runtime_error);
+}
+
+TEST(UiLayout, ViewRejectsBrokenDescriptions) {
+	std::vector<uint8_t> bytes = UiLayoutCompiler::Compile("Button {\n\tStatic\n}\n");
+	EXPECT_NO_THROW(UiLayoutView(bytes.data(), bytes.size()));
+	EXPECT_THROW(UiLayoutView(bytes.data(), bytes.size() - 2), std::runtime_error);
+
+	std::vector<uint8_t> forward = bytes;
+	UiLayoutNode* nodes = reinterpret_cast<UiLayoutNode*>(forward.data() + sizeof(UiLayoutHeader));
+	nodes[1].parent = 1;
+	EXPECT_THROW(UiLayoutView(forward.data(), forward.size()), std::runtime_error);
+
+	std::vector<uint8_t> outside = bytes;
+	nodes = reinterpret_cast<UiLayoutNode*>(outside.data() + sizeof(UiLayoutHeader));
+	nodes[0].text = 1000;
+	EXPECT_THROW(UiLayoutView(outside.data(), outside.size()), std::runtime_error);
+}
+
+TEST(UiLayoutBenchmark, CompileThousandControls) {
+	std::string text = MakeThousandControls();
+	constexpr int kRounds = 20;
+	size_t nodes = 0;
+	BenchmarkTimer timer;
+	for (int round = 0; round < kRounds; ++round) {
+		std::vector<uint8_t> bytes = UiLayoutCompiler::Compile(text);
+		nodes = reinterpret_cast<const UiLayoutHeader*>(bytes.data())->nodeCount;
+		KeepValue(bytes);
+	}
+	ReportBenchmark("UiLayout compile, per control", kRounds * nodes, timer.ElapsedNanoseconds());
+	EXPECT_EQ(nodes, 1000u);
+}
+
+// What instantiation pays before the first window is created: validating the description
+// and walking every node
+TEST(UiLayoutBenchmark, LoadThousandControls) {
+	std::vector<uint8_t> bytes = UiLayoutCompiler::Compile(MakeThousandControls());
+	constexpr int kRounds = 2000;
+	uint64_t checksum = 0;
+	BenchmarkTimer timer;
+	for (int round = 0; round < kRounds; ++round) {
+		UiLayoutView view(bytes.data(), bytes.size());
+		for (const UiLayoutNode& node : view) {
+			checksum += node.id + view.GetString(node.className)[0];
+		}
+	}
+	ReportBenchmark("UiLayout validate and walk, per control", kRounds * 1000ull, timer.ElapsedNanoseconds());
+	KeepValue(checksum);
+	EXPECT_NE(checksum, 0u);
+}
+
+#ifdef _WIN32
+namespace {
+	HWND CreateHost() {
+		return CreateWindowEx(0, L"STATIC", L"UiTree benchmark", WS_OVERLAPPEDWINDOW, 0, 0, 1200, 900, NULL, NULL, GetModuleHandleW(NULL), NULL);
+	}
+}
+
+TEST(UiLayoutBenchmark, InstantiateThousandControls) {
+	std::vector<uint8_t> bytes = UiLayoutCompiler::Compile(MakeThousandControls());
+	UiLayoutView view(bytes.data(), bytes.size());
+	HWND host = CreateHost();
+	ASSERT_NE(host, nullptr);
+	ShowWindow(host, SW_SHOWNOACTIVATE);
+	{
+		UiTree tree(host, view, GetModuleHandleW(NULL));
+		const UiBuildStats& stats = tree.GetStats();
+		ASSERT_EQ(stats.controls, 1000u);
+		EXPECT_NE(tree.GetControl(1000), nullptr);
+		printf("[ BENCH    ] UiTree 1,000 controls: create %lld us, layout %lld us, total %lld us\n",
+			static_cast<long long>(stats.create.count()), static_cast<long long>(stats.layout.count()), static_cast<long long>(stats.total.count()));
+		ReportBenchmark("UiTree instantiate, per control", stats.controls, static_cast<double>(stats.total.count()) * 1000.0);
+	}
+	DestroyWindow(host);
+}
+
+// The same controls created one by one at their final size with the host repainting,
+// for comparison
+TEST(UiLayoutBenchmark, InstantiateThousandControlsOneByOne) {
+	std::vector<uint8_t> bytes = UiLayoutCompiler::Compile(MakeThousandControls());
+	UiLayoutView view(bytes.data(), bytes.size());
+	HWND host = CreateHost();
+	ASSERT_NE(host, nullptr);
+	ShowWindow(host, SW_SHOWNOACTIVATE);
+	std::vector<HWND> controls;
+	controls.reserve(view.GetNodeCount());
+	BenchmarkTimer timer;
+	for (const UiLayoutNode& node : view) {
+		HWND parent = node.parent == kUiNoParent ? host : controls[node.parent];
+		controls.push_back(CreateWindowEx(node.exStyle, reinterpret_cast<LPCWSTR>(view.GetString(node.className)), reinterpret_cast<LPCWSTR>(view.GetString(node.text)),
+			node.style | WS_CHILD | WS_VISIBLE, node.x, node.y, node.width, node.height, parent, reinterpret_cast<HMENU>(static_cast<UINT_PTR>(node.id)), GetModuleHandleW(NULL), NULL));
+	}
+	UpdateWindow(host);
+	ReportBenchmark("Controls created one by one, per control", controls.size(), timer.ElapsedNanoseconds());
+	EXPECT_EQ(controls.size(), 1000u);
+	DestroyWindow(host);
+}
+#endif
@@ -0,0 +1,194 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/Window/WindowIndexCore.hpp"
+#include "../include/Diagnostics/MemoryLedger.hpp"
+
+namespace {
+	IndexedWindow MakeWindow(uintptr_t handle, const std::wstring& title, const std::wstring& className = L"Class", uint32_t processId = 1) {
+		IndexedWindow window;
+		window.handle = handle;
+		window.title = title;
+		window.className = className;
+		window.processId = processId;
+		return window;
+	}
+
+	// Unattributed memory in one category of the process-wide ledger
+	uint64_t Unattributed(MemoryCategory category) {
+		return GetMemoryLedger().GetOwnerReport(0).categories[static_cast<size_t>(category)].current;
+	}
+
+	std::vector<uintptr_t> Sorted(std::vector<uintptr_t> handles) {
+		std::sort(handles.begin(), handles.end());
+		return handles;
+	}
+}
+
+TEST(WindowIndexCore, FindsTitlesByPrefixIgnoringCase) {
+	WindowIndexCore index;
+	index.Upsert(MakeWindow(1, L"Notepad"));
+	index.Upsert(MakeWindow(2, L"NOTES - Draft"));
+	index.Upsert(MakeWindow(3, L"Calculator"));
+	EXPECT_EQ(Sorted(index.FindByTitlePrefix(L"note")), (std::vector<uintptr_t>{ 1, 2 }));
+	EXPECT_EQ(index.FindByTitlePrefix(L"NOTEP"), (std::vector<uintptr_t>{ 1 }));
+	EXPECT_TRUE(index.FindByTitlePrefix(L"notebook").empty());
+	EXPECT_EQ(index.FindByTitlePrefix(L"").size(), 3u);
+}
+
+TEST(WindowIndexCore, ExactTitleIsNotAPrefixMatch) {
+	WindowIndexCore index;
+	index.Upsert(MakeWindow(1, L"Run"));
+	index.Upsert(MakeWindow(2, L"Running"));
+	index.Upsert(MakeWindow(3, L"run"));
+	EXPECT_EQ(Sorted(index.FindByTitle(L"RUN")), (std::vector<uintptr_t>{ 1, 3 }));
+	EXPECT_TRUE(index.FindByTitle(L"Runn").empty());
+	EXPECT_TRUE(index.FindByTitle(L"Runner").empty());
+}
+
+TEST(WindowIndexCore, PrefixResultsAreShortestFirstAndLimited) {
+	WindowIndexCore index;
+	index.Upsert(MakeWindow(1, L"abc"));
+	index.Upsert(MakeWindow(2, L"ab"));
+	index.Upsert(MakeWindow(3, L"abd"));
+	index.Upsert(MakeWindow(4, L"a"));
+	EXPECT_EQ(index.FindByTitlePrefix(L"a"), (std::vector<uintptr_t>{ 4, 2, 1, 3 }));
+	EXPECT_EQ(index.FindByTitlePrefix(L"a", 2), (std::vector<uintptr_t>{ 4, 2 }));
+	EXPECT_TRUE(index.FindByTitlePrefix(L"a", 0).empty());
+}
+
+TEST(WindowIndexCore, TitleChurnReusesNodes) {
+	WindowIndexCore index;
+	index.Upsert(MakeWindow(1, L"Build 0 of 1000"));
+	index.Upsert(MakeWindow(2, L"Build log"));
+	size_t nodes = index.GetNodeCount();
+	for (int i = 1; i <= 1000; ++i) {
+		ASSERT_TRUE(index.SetTitle(1, L"Build " + std::to_wstring(i % 10) + L" of 1000"));
+	}
+	EXPECT_EQ(index.GetNodeCount(), nodes);
+	EXPECT_EQ(index.FindByTitle(L"build 0 of 1000"), (std::vector<uintptr_t>{ 1 }));
+	EXPECT_EQ(index.FindByTitle(L"build log"), (std::vector<uintptr_t>{ 2 }));
+	EXPECT_FALSE(index.SetTitle(99, L"Unknown"));
+}
+
+TEST(WindowIndexCore, RemovePrunesOnlyUnsharedNodes) {
+	WindowIndexCore index;
+	index.Upsert(MakeWindow(1, L"Settings"));
+	size_t withOne = index.GetNodeCount();
+	index.Upsert(MakeWindow(2, L"Set"));
+	index.Upsert(MakeWindow(3, L"Setup Wizard"));
+	index.Remove(3);
+	EXPECT_EQ(index.GetNodeCount(), withOne);
+	index.Remove(1);
+	EXPECT_EQ(index.FindByTitlePrefix(L"se"), (std::vector<uintptr_t>{ 2 }));
+	EXPECT_EQ(index.GetNodeCount(), 4u);
+	index.Remove(2);
+	EXPECT_EQ(index.GetNodeCount(), 1u);
+	EXPECT_EQ(index.GetCount(), 0u);
+	index.Remove(2);
+}
+
+TEST(WindowIndexCore, UpsertReplacesEveryIndex) {
+	WindowIndexCore index;
+	index.Upsert(MakeWindow(1, L"Old", L"Edit", 10));
+	index.Upsert(MakeWindow(1, L"New", L"Button", 20));
+	EXPECT_EQ(index.GetCount(), 1u);
+	EXPECT_TRUE(index.FindByTitle(L"old").empty());
+	EXPECT_TRUE(index.FindByClass(L"Edit").empty());
+	EXPECT_TRUE(index.FindByProcess(10).empty());
+	EXPECT_EQ(index.FindByClass(L"Button"), (std::vector<uintptr_t>{ 1 }));
+	EXPECT_EQ(index.FindByProcess(20), (std::vector<uintptr_t>{ 1 }));
+	ASSERT_NE(index.Find(1), nullptr);
+	EXPECT_EQ(index.Find(1)->title, L"New");
+	EXPECT_EQ(index.Find(2), nullptr);
+}
+
+TEST(WindowIndexCore, ClearResetsTheTrie) {
+	WindowIndexCore index;
+	index.Upsert(MakeWindow(1, L"One"));
+	index.Upsert(MakeWindow(2, L"Two"));
+	index.Clear();
+	EXPECT_EQ(index.GetCount(), 0u);
+	EXPECT_EQ(index.GetNodeCount(), 1u);
+	EXPECT_TRUE(index.FindByTitlePrefix(L"").empty());
+	index.Upsert(MakeWindow(3, L"Three"));
+	EXPECT_EQ(index.FindByTitlePrefix(L"th"), (std::vector<uintptr_t>{ 3 }));
+}
+
+TEST(WindowIndexCore, ChargesTitlesAndTablesToTheLedger) {
+	const uint64_t strings = Unattributed(MemoryCategory::Strings);
+	const uint64_t cache = Unattributed(MemoryCategory::Cache);
+	{
+		WindowIndexCore index;
+		EXPECT_GT(Unattributed(MemoryCategory::Cache), cache);
+		index.Upsert(MakeWindow(1, L"Title", L"Cls"));
+		EXPECT_EQ(Unattributed(MemoryCategory::Strings), strings + 8 * sizeof(wchar_t));
+		index.SetTitle(1, L"Longer title");
+		EXPECT_EQ(Unattributed(MemoryCategory::Strings), strings + 15 * sizeof(wchar_t));
+		index.Upsert(MakeWindow(1, L"T", L"Cls"));
+		EXPECT_EQ(Unattributed(MemoryCategory::Strings), strings + 4 * sizeof(wchar_t));
+		index.Remove(1);
+		EXPECT_EQ(Unattributed(MemoryCategory::Strings), strings);
+	}
+	EXPECT_EQ(Unattributed(MemoryCategory::Cache), cache);
+}
+
+// Random upserts, renames and removals, checked against a plain map after every step
+TEST(WindowIndexCore, MatchesBruteForceUnderChurn) {
+	const std::wstring alphabet = L"abAB ";
+	std::mt19937 random(1234);
+	auto randomTitle = [&] {
+		std::wstring title;
+		size_t length = random() % 5;
+		for (size_t i = 0; i < length; ++i) {
+			title += alphabet[random() % alphabet.size()];
+		}
+		return title;
+	};
+	auto fold = [](std::wstring text) {
+		for (wchar_t& c : text) {
+			c = static_cast<wchar_t>(std::towlower(static_cast<std::wint_t>(c)));
+		}
+		return text;
+	};
+
+	WindowIndexCore index;
+	std::map<uintptr_t, std::wstring> model;
+	for (int step = 0; step < 3000; ++step) {
+		uintptr_t handle = 1 + random() % 40;
+		switch (random() % 3) {
+		case 0:
+			model[handle] = randomTitle();
+			index.Upsert(MakeWindow(handle, model[handle]));
+			break;
+		case 1:
+			if (model.count(handle)) {
+				model[handle] = randomTitle();
+			}
+			EXPECT_EQ(index.SetTitle(handle, model.count(handle) ? model[handle] : L"x"), model.count(handle) != 0);
+			break;
+		default:
+			model.erase(handle);
+			index.Remove(handle);
+			break;
+		}
+
+		std::wstring prefix = fold(randomTitle().substr(0, 2));
+		std::vector<uintptr_t> expected;
+		for (const auto& entry : model) {
+			if (fold(entry.second).compare(0, prefix.size(), prefix) == 0) {
+				expected.push_back(entry.first);
+			}
+		}
+		ASSERT_EQ(Sorted(index.FindByTitlePrefix(prefix)), expected) << "step " << step;
+	}
+	for (const auto& entry : model) {
+		index.Remove(entry.first);
+	}
+	EXPECT_EQ(index.GetNodeCount(), 1u);
+}